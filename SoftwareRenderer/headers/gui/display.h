@@ -2,11 +2,16 @@
 #define DISPLAY_H
 
 #include <QLabel>
+#include <QImage>
+#include <QPainter>
 #include "headers/matrix_transform/animation.h"
 #include "headers/shading/shadingmodel.h"
 #include "headers/rendering/scenedata.h"
-#include "headers/rendering/renderingpipeline.h"
+#include "headers/threading/renderthread.h"
 #include "headers/models/lightsourcelistmodel.h"
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace pv {
 
@@ -15,6 +20,10 @@ namespace pv {
     public:
         explicit Display(size_t width, size_t height, const SceneData& sceneData, QWidget *parent = nullptr);
 
+        // Runs sceneUpdate while no frame is being rendered; the scene is only
+        // referenced by the render thread, so it must not change any other way.
+        void UpdateSceneData(const std::function<void()>& sceneUpdate);
+
         void DeferAnimationType(ANIMATION_TYPE animationType);
         void DeferShadingType(SHADING_MODEL shadingType);
 
@@ -37,6 +46,8 @@ namespace pv {
 
         void DeferEnableZBuffering(bool enableZBuffering);
         void DeferEnableBackfaceCulling(bool enableBackfaceCulling);
+        void DeferEnableDepthPrepass(bool enableDepthPrepass);
+        void DeferDepthFormat(DEPTH_FORMAT depthFormat);
 
         void DeferUpdatedLightSourceListModel(const LightSourceListModel* model);
 
@@ -48,6 +59,10 @@ namespace pv {
         void DeferNormalTexture(TextureHolder texture);
         void DeferSpecularTexture(TextureHolder texture);
 
+        void ToggleProfilerOverlay();
+        void CycleTargetFps();
+        void ToggleAdaptiveResolution();
+
     signals:
 
         // QWidget interface
@@ -56,10 +71,21 @@ namespace pv {
         virtual void wheelEvent(QWheelEvent *event) override;
 
     private:
+        void DrawProfilerOverlay(QPainter& painter, const QRect& imageRect) const;
+        void DrawRenderError(QPainter& painter, const QRect& imageRect) const;
+        void PostLightSources();
+
         size_t width_;
         size_t height_;
-        RenderingPipeline rend_pipeline_;
+        RenderThread render_thread_;
+        std::vector<std::shared_ptr<LightSource>> light_sources_;
+        std::vector<std::shared_ptr<LightSource>> posted_light_sources_;
         bool mouse_pressed_;
+        bool profiler_overlay_visible_;
+        size_t target_fps_index_;
+        bool adaptive_resolution_;
+        // What the last failed frame threw; shown over the last good frame until a frame succeeds.
+        QString render_error_;
 
         int pressed_x_;
         int pressed_y_;
@@ -129,7 +129,6 @@ private:
     void InitTextureStatusStrings();
     void InitTextureStatusStringColors();
 
-    void SplitQuadsIntoTriangles(std::vector<pv::Polygon>& polygons);
 
     void DoEnableModifyButton(bool enableModifyButton);
     void DoEnableZBufferingButton(bool enableZBufferingButton);
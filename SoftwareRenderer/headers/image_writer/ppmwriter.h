@@ -0,0 +1,20 @@
+#ifndef PV_PPMWRITER_H
+#define PV_PPMWRITER_H
+
+#include <cstddef>
+#include <string>
+
+namespace pv {
+
+    using uchar = unsigned char;
+
+    // Writes ARGB32 frame buffer pixels (b, g, r, a in memory) as a binary PPM;
+    // alpha is dropped.
+    class PPMWriter {
+    public:
+        void WriteImage(const std::string& path, const uchar* argbPixels, size_t width, size_t height) const;
+    };
+
+} // namespace pv
+
+#endif // PV_PPMWRITER_H
@@ -7,20 +7,29 @@ namespace pv {
 
     enum class ANIMATION_TYPE { NO_ANIMATION, X_ROTATION, Y_ROTATION, Z_ROTATION, CAROUSEL };
 
+    // Animations are driven by elapsed time rather than by rendered frames, so they
+    // move at the same speed however fast the frames come.
     class Animation {
     public:
         float GetRadianAngle(float degreeAngle) const;
 
         Animation() = default;
-        virtual glm::mat4 GetModelMatrix() = 0;
+        void Advance(float elapsedSeconds);
+        virtual glm::mat4 GetModelMatrix() const = 0;
 
         virtual ~Animation() = default;
+
+    protected:
+        float GetDegreeAngle(float degreesPerSecond) const;
+
+    private:
+        double elapsed_seconds_ = 0.0;
     };
 
     class NoAnimation : public Animation {
     public:
         NoAnimation() = default;
-        virtual glm::mat4 GetModelMatrix() override;
+        virtual glm::mat4 GetModelMatrix() const override;
 
         virtual ~NoAnimation() = default;
     };
@@ -28,7 +37,7 @@ namespace pv {
     class XAnimation : public Animation {
     public:
         XAnimation() = default;
-        virtual glm::mat4 GetModelMatrix() override;
+        virtual glm::mat4 GetModelMatrix() const override;
 
         virtual ~XAnimation() = default;
     };
@@ -36,7 +45,7 @@ namespace pv {
     class YAnimation : public Animation {
     public:
         YAnimation() = default;
-        virtual glm::mat4 GetModelMatrix() override;
+        virtual glm::mat4 GetModelMatrix() const override;
 
         virtual ~YAnimation() = default;
     };
@@ -44,7 +53,7 @@ namespace pv {
     class ZAnimation : public Animation {
     public:
         ZAnimation() = default;
-        virtual glm::mat4 GetModelMatrix() override;
+        virtual glm::mat4 GetModelMatrix() const override;
 
         virtual ~ZAnimation() = default;
     };
@@ -52,7 +61,7 @@ namespace pv {
     class CarouselAnimation : public Animation {
     public:
         CarouselAnimation() = default;
-        virtual glm::mat4 GetModelMatrix() override;
+        virtual glm::mat4 GetModelMatrix() const override;
 
         virtual ~CarouselAnimation() = default;
     };
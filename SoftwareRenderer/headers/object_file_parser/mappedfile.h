@@ -0,0 +1,34 @@
+#ifndef PV_MAPPEDFILE_H
+#define PV_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace pv {
+
+    // Read-only memory mapping of a whole file, kept for the lifetime of the
+    // object. Throws std::runtime_error when the file can't be opened or mapped.
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& filePath);
+        ~MappedFile();
+
+        const char* GetData() const;
+        size_t GetSize() const;
+        std::string_view GetView() const;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&&) = delete;
+
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile& operator=(MappedFile&&) = delete;
+
+    private:
+        const char* data_;
+        size_t size_;
+    };
+
+} // namespace pv
+
+#endif // PV_MAPPEDFILE_H
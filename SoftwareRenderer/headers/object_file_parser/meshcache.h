@@ -0,0 +1,53 @@
+#ifndef PV_MESHCACHE_H
+#define PV_MESHCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "headers/rendering/scenedata.h"
+
+namespace pv {
+
+class ThreadPool;
+
+// Hash of objectFileText, the contents of an OBJ file, computed in parallel
+// blocks. Files made from an OBJ file store it to tell when it changed.
+uint64_t GetContentHash(std::string_view objectFileText, ThreadPool& threadPool);
+
+// Binary copy of the SceneData parsed from an OBJ file, stored next to it as
+// <file>.pvmesh. The cache file starts with a versioned header holding the
+// size and a content hash of the OBJ text it was made from, followed by the
+// SceneData arrays, each starting on a 64 byte boundary. Loading maps the
+// cache file and copies the arrays in bulk; a cache written for other content,
+// by another format version or on a machine of other byte order is ignored.
+class MeshCache
+{
+    public:
+        // Hashes objectFileText, the contents of the OBJ file, in parallel blocks.
+        MeshCache(const std::string& objectFilePath, std::string_view objectFileText, ThreadPool& threadPool);
+
+        MeshCache(const MeshCache&) = delete;
+        MeshCache(MeshCache&&) = delete;
+
+        MeshCache& operator=(const MeshCache&) = delete;
+        MeshCache& operator=(MeshCache&&) = delete;
+
+        // False, leaving sceneData untouched, when there is no valid cache.
+        bool Load(SceneData& sceneData) const;
+
+        // Writes the cache through a temporary file renamed into place. A cache
+        // is only an optimization, so failing to write one returns false.
+        bool Save(const SceneData& sceneData) const;
+
+        const std::string& GetCacheFilePath() const;
+
+    private:
+        std::string cache_file_path_;
+        uint64_t source_size_;
+        uint64_t source_hash_;
+};
+
+} // namespace pv
+
+#endif // PV_MESHCACHE_H
@@ -1,14 +1,49 @@
 #ifndef PV_OBJECTFILEPARSER_H
 #define PV_OBJECTFILEPARSER_H
 
-#include <QString>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "headers/rendering/scenedata.h"
 
 namespace pv {
 
+class VertexWelder;
+class ThreadPool;
+
+// Reads the v, vt, vn and f statements of an OBJ file; everything else is
+// skipped. The file is memory mapped, split at line boundaries into chunks
+// that are tokenized in place in parallel, and the chunks are then merged.
+// Unless disabled, the result is kept in a MeshCache next to the file and
+// read from there as long as the file's content doesn't change.
 class ObjectFileParser
 {
     public:
+        // Statements of one line-aligned piece of the file. Relative corner
+        // indices can only be resolved against the counts of the chunk itself
+        // while parsing; they are flagged in the corner's relativeMask and offset
+        // by the elements of all earlier chunks when merging.
+        struct ObjectFileChunk {
+            struct Corner {
+                std::array<int, 3> indices;
+                uint8_t relativeMask;
+            };
+
+            std::string_view text;
+
+            std::vector<glm::vec3> vertices;
+            std::vector<glm::vec3> vertexTextures;
+            std::vector<glm::vec3> vertexNormals;
+
+            std::vector<Corner> corners;
+            std::vector<uint32_t> polygonCornerCounts;
+
+            std::array<size_t, 3> elementOffsets = {};
+        };
+
         ObjectFileParser();
 
         ObjectFileParser(const ObjectFileParser&) = delete;
@@ -17,24 +52,37 @@ class ObjectFileParser
         ObjectFileParser& operator=(const ObjectFileParser&) = delete;
         ObjectFileParser& operator=(ObjectFileParser&&) = delete;
 
-        SceneData GetSceneDataFromObjectFile(QString filePath);
+        // Throws std::runtime_error for unreadable files and malformed statements.
+        SceneData GetSceneDataFromObjectFile(const std::string& filePath);
+
+        // Parses the file one window of a few megabytes per thread at a time
+        // and hands its chunks to chunkHandler in file order, with all corner
+        // indices resolved to 0-based absolute ones, VertexWelder::NO_INDEX where
+        // missing. Only one window is held in memory, so files of any size can
+        // be read. Nothing is welded or cached; the YZ axes fix is applied.
+        void ReadObjectFileChunks(const std::string& filePath,
+                                  const std::function<void(const ObjectFileChunk&)>& chunkHandler);
 
         void SetDoApplyYZAxesFix(bool applyFix);
+        bool GetDoApplyYZAxesFix() const;
+        void SetUseMeshCache(bool useMeshCache);
 
     private:
-        glm::vec3 GetVertexData(QString);
-        glm::vec3 GetTextureData(QString);
-        glm::vec3 GetNormalData(QString);
+        std::vector<ObjectFileChunk> SplitIntoChunks(std::string_view fileText, size_t chunkCount);
+        void ParseChunk(ObjectFileChunk&);
+        void ReserveChunkData(ObjectFileChunk&);
+        void MergeChunks(std::vector<ObjectFileChunk>&, SceneData&, VertexWelder&, ThreadPool&);
 
-        Polygon GetPolygonData(QString);
+        glm::vec3 GetVertexData(std::string_view);
+        glm::vec3 GetTextureData(std::string_view);
+        glm::vec3 GetNormalData(std::string_view);
 
-        Polygon GetPolygonDataOneDash(QStringList);
-        Polygon GetPolygonDataTwoDashes(QStringList);
-        Polygon GetPolygonDataDoubleDash(QStringList);
+        void AppendPolygonData(std::string_view, ObjectFileChunk&);
 
-        void DoApplyYZAxesFix(SceneData& sceneData);
+        void DoApplyYZAxesFix(SceneData& sceneData, ThreadPool& threadPool);
 
         bool do_apply_yz_axes_fix_;
+        bool use_mesh_cache_;
 };
 
 } // namespace pv
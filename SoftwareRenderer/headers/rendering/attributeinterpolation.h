@@ -6,6 +6,7 @@
 #include <vector>
 #include <array>
 #include "headers/shading/shadedpixel.h"
+#include "headers/rendering/spankernels.h"
 
 namespace pv {
 
@@ -13,6 +14,32 @@ namespace pv {
     using uchar = unsigned char;
     using ShadeColor = std::array<uchar, 4>;
 
+    struct VertexAttributes {
+        glm::vec3 normal;
+        glm::vec3 cameraSpacePosition;
+        glm::vec3 textureCoord;
+    };
+
+    struct InterpolatedFragment {
+        InterpolationPoint interpolatedPoint;
+        glm::vec3 normal;
+        glm::vec3 cameraSpacePosition;
+        glm::vec3 textureCoord;
+    };
+
+    // Barycentric weights of each rendered vertex relative to the corners of the
+    // source triangle; anything but the identity means the triangle was clipped.
+    using SourceVertexWeights = std::array<glm::vec3, 3>;
+
+    constexpr SourceVertexWeights UNCLIPPED_SOURCE_WEIGHTS {
+        glm::vec3{1.0F, 0.0F, 0.0F}, glm::vec3{0.0F, 1.0F, 0.0F}, glm::vec3{0.0F, 0.0F, 1.0F}
+    };
+
+    struct InterpolatedFragmentSpan {
+        InterpolatedFragment fragments[SPAN_WIDTH];
+        int count;
+    };
+
 
 class AttributeInterpolation{
 public:
@@ -20,27 +47,58 @@ public:
     using ViewportPoint = glm::vec4;
     using CameraSpacePoint = glm::vec4;
 
+    AttributeInterpolation();
+
     void InterpolateDepthOverLine(std::vector<InterpolationPoint>& interpolationPoints,
                                   const ViewportPoint& firstPoint,
                                   const ViewportPoint& secondPoint);
 
-    std::vector<ShadedPixel> GetPixelsWithInterpolatedDepth(
-            const std::vector<InterpolationPoint>& interpolationPoints,
-            const ViewportPoint& firstPoint,
-            const ViewportPoint& secondPoint,
-            const ViewportPoint& thirdPoint,
+    void SetTriangle(const ViewportPoint& firstPoint,
+                     const ViewportPoint& secondPoint,
+                     const ViewportPoint& thirdPoint,
+
+                     const std::array<VertexAttributes, 3>* vertexAttributesPtr = nullptr,
+                     bool normalInterpolationNeeded = false,
+                     bool cameraSpaceInterpolationNeeded = false,
+                     bool textureCoordInterpolationNeeded = false);
+
+    static std::array<VertexAttributes, 3> GetClippedVertexAttributes(const std::array<VertexAttributes, 3>& sourceAttributes,
+                                                                      const SourceVertexWeights& sourceWeights);
+
+    // u and v are the barycentric weights of the second and third vertex. Lanes
+    // lying behind the eye are dropped from the returned mask.
+    SpanMask InterpolateDepthSpan(const double* u, const double* v, SpanMask mask, double* depth) const;
+
+    // Lower bounds of the interpolated depth, over the whole triangle or over the
+    // part of it inside a block given by the weights at its four corners.
+    double GetNearestDepth() const;
+    double GetNearestDepth(const double (&cornerU)[4], const double (&cornerV)[4]) const;
+
+    // Expects fragment.interpolatedPoint to hold the depth from InterpolateDepthSpan.
+    void InterpolateAttributes(double u, double v, InterpolatedFragment& fragment) const;
+
+private:
+    struct AttributeGradient {
+        glm::vec3 origin;
+        glm::vec3 uDelta;
+        glm::vec3 vDelta;
+    };
+
+    AttributeGradient GetAttributeGradient(const glm::vec3& first, const glm::vec3& second, const glm::vec3& third) const;
+    glm::vec3 GetInterpolatedAttribute(const AttributeGradient& gradient, float u, float v, float depth) const;
+
+    double GetMaxVertexInverseDepth() const;
+    double GetConservativeDepth(double maxInverseDepth) const;
 
-            bool normalInterpolationNeeded = false,
-            std::vector<glm::vec3>* normalVectorsPtr = nullptr,
-            std::vector<glm::vec3>* interpolatedNormalVectorsPtr = nullptr,
+    DepthSpanSetup depth_setup_;
 
-            bool cameraSpaceInterpolationNeeded = false,
-            std::vector<glm::vec3>* cameraSpacePosPtr = nullptr,
-            std::vector<glm::vec3>* interpolatedCameraSpacePosPtr = nullptr,
+    bool normal_interpolation_needed_;
+    bool camera_space_interpolation_needed_;
+    bool texture_coord_interpolation_needed_;
 
-            bool textureCoordInterpolationNeeded = false,
-            std::vector<glm::vec3>* textureCoordsPtr = nullptr,
-            std::vector<glm::vec3>* interpolatedTextureCoordsPtr = nullptr);
+    AttributeGradient normal_gradient_;
+    AttributeGradient camera_space_gradient_;
+    AttributeGradient texture_coord_gradient_;
 };
 
 } // namespace pv
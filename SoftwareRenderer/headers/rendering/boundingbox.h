@@ -0,0 +1,43 @@
+#ifndef PV_BOUNDINGBOX_H
+#define PV_BOUNDINGBOX_H
+
+#include <limits>
+#include <glm/vec3.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+namespace pv {
+
+    // Axis-aligned box; a default constructed one is empty and takes the
+    // extent of whatever is added to it.
+    struct BoundingBox {
+        glm::vec3 minCorner { std::numeric_limits<float>::max() };
+        glm::vec3 maxCorner { std::numeric_limits<float>::lowest() };
+
+        bool IsEmpty() const {
+            return minCorner.x > maxCorner.x || minCorner.y > maxCorner.y || minCorner.z > maxCorner.z;
+        }
+
+        glm::vec3 GetCenter() const { return (minCorner + maxCorner) * 0.5F; }
+        glm::vec3 GetExtent() const { return maxCorner - minCorner; }
+
+        void Extend(const glm::vec3& point) {
+            minCorner = glm::min(minCorner, point);
+            maxCorner = glm::max(maxCorner, point);
+        }
+
+        void Extend(const BoundingBox& box) {
+            minCorner = glm::min(minCorner, box.minCorner);
+            maxCorner = glm::max(maxCorner, box.maxCorner);
+        }
+
+        // Distance from point to the nearest point of the box, 0 inside it.
+        float GetDistance(const glm::vec3& point) const {
+            const glm::vec3 offset = glm::max(glm::max(minCorner - point, point - maxCorner), glm::vec3(0.0F));
+            return glm::length(offset);
+        }
+    };
+
+} // namespace pv
+
+#endif // PV_BOUNDINGBOX_H
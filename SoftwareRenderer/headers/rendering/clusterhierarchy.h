@@ -0,0 +1,73 @@
+#ifndef PV_CLUSTERHIERARCHY_H
+#define PV_CLUSTERHIERARCHY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "headers/rendering/boundingbox.h"
+#include "headers/rendering/frustum.h"
+#include "headers/rendering/scenedata.h"
+#include "headers/rendering/viewportpoints.h"
+
+namespace pv {
+
+    // Bounding volume hierarchy over clusters of spatially close polygons of a
+    // scene. The polygons are split at the median centroid along the longest
+    // axis until at most polygonsPerCluster are left, and every split becomes a
+    // node bounding both halves. Finding the clusters in view then takes a few
+    // box tests per level, instead of one per polygon.
+    class ClusterHierarchy {
+    public:
+        static constexpr size_t DEFAULT_POLYGONS_PER_CLUSTER = 128;
+
+        // Vertices are grouped in blocks of one visibility mask word, the unit
+        // in which the vertex stage transforms the vertices of visible clusters.
+        static constexpr size_t VERTEX_BLOCK_SIZE = ViewportPoints::MASK_BITS;
+
+        struct Cluster {
+            BoundingBox bounds;
+            // Ranges of GetClusterPolygons() and GetClusterVertexBlocks().
+            uint32_t firstPolygon;
+            uint32_t polygonCount;
+            uint32_t firstVertexBlock;
+            uint32_t vertexBlockCount;
+        };
+
+        // Throws std::runtime_error if polygonsPerCluster is 0.
+        void Build(const SceneData& sceneData, size_t polygonsPerCluster = DEFAULT_POLYGONS_PER_CLUSTER);
+
+        // Indices of the clusters whose bounds intersect frustum, which has to be
+        // in the object space of the scene, in ascending order.
+        void GetVisibleClusters(const Frustum& frustum, std::vector<uint32_t>& visibleClusters) const;
+
+        size_t GetClusterCount() const;
+        const Cluster& GetCluster(size_t clusterIndex) const;
+
+        // Polygon indices of all clusters, ascending within each cluster.
+        const std::vector<uint32_t>& GetClusterPolygons() const;
+        // Indices of the vertex blocks each cluster uses, ascending within each cluster.
+        const std::vector<uint32_t>& GetClusterVertexBlocks() const;
+
+    private:
+        // The first child of an inner node follows it. Leaves hold one cluster
+        // and have no second child, which leaves it at 0.
+        struct Node {
+            BoundingBox bounds;
+            uint32_t secondChild;
+            uint32_t firstCluster;
+            uint32_t clusterCount;
+        };
+
+        uint32_t BuildNode(const SceneData& sceneData, const std::vector<glm::vec3>& centroids,
+                           size_t rangeBegin, size_t rangeEnd, size_t polygonsPerCluster);
+        void AddCluster(const SceneData& sceneData, size_t rangeBegin, size_t rangeEnd, Node& leaf);
+
+        std::vector<Node> nodes_;
+        std::vector<Cluster> clusters_;
+        std::vector<uint32_t> cluster_polygons_;
+        std::vector<uint32_t> cluster_vertex_blocks_;
+    };
+
+} // namespace pv
+
+#endif // PV_CLUSTERHIERARCHY_H
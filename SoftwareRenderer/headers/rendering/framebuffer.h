@@ -4,6 +4,8 @@
 #include <cstddef>
 #include <vector>
 #include <array>
+#include "headers/rendering/spankernels.h"
+#include "headers/rendering/trianglerasterizer.h"
 
 namespace pv {
 
@@ -13,21 +15,62 @@ namespace pv {
         ARGB32
     };
 
+    enum class DEPTH_TEST {
+        LESS,
+        LESS_EQUAL
+    };
+
+    // Depth is always passed in as view-space distance; the format only decides
+    // how it is stored. FLOAT32_REVERSED_Z keeps near / z, so precision is spread
+    // evenly over the range, UNORM24 keeps the usual [0, 1] window depth in the
+    // low 24 bits of a 32-bit word. Both need the range from SetDepthRange.
+    enum class DEPTH_FORMAT {
+        FLOAT64,
+        FLOAT32_REVERSED_Z,
+        UNORM24
+    };
+
     class FrameBuffer {
     public:
+        // Clears are deferred per tile of this size and only carried out once the
+        // tile is first touched, or by ResolveClears for tiles nobody drew into.
+        static constexpr size_t CLEAR_TILE_SIZE = 64;
+
         FrameBuffer(size_t width, size_t height, COLOR_MODEL clrModel);
         ~FrameBuffer();
 
-        void CopyToUcharArray(uchar* extBuffer) const;
+        // Keeps the depth buffer alive across frames and only reallocates it when
+        // the size actually changes. The attached color buffer belongs to the
+        // caller and has to hold width * height pixels; contentsPreserved
+        // promises it is the previous buffer, untouched since.
+        void AttachColorBuffer(uchar* externalBuffer, size_t width, size_t height, bool contentsPreserved = false);
+
         void DrawPixel(size_t x, size_t y, uchar a, uchar r, uchar g, uchar b);
         void DrawPixel(size_t x, size_t y, const std::array<uchar, 4>&  argb);
         void ZBufferDrawPixel(size_t x, size_t y, double z, const std::array<uchar, 4>&  argb);
 
+        SpanMask ZBufferTestSpan(size_t x, size_t y, const double* z, SpanMask mask, DEPTH_TEST depthTest = DEPTH_TEST::LESS) const;
+        void ZBufferWriteDepth(size_t x, size_t y, double z);
+
+        // Coarse test against the farthest depth stored in each RASTER_BLOCK_SIZE block
+        // the rect touches; false means every pixel in it already holds something
+        // closer than nearestDepth. Block bounds are refreshed lazily after writes,
+        // so concurrent callers have to stay within disjoint sets of blocks.
+        bool ZBufferTestRect(const ScreenRect& rect, double nearestDepth, DEPTH_TEST depthTest = DEPTH_TEST::LESS) const;
+
         void DrawLine(float x1, float y1, float x2, float y2, const std::array<uchar, 4>&  argb);
         void Clear(uchar shade);
+        void ResolveClears() const;
 
         void EnableZBuffer();
         void ClearZBuffer();
+        bool IsZBufferEnabled() const;
+
+        // Changing the format reallocates an enabled depth buffer, its contents
+        // have to be cleared afterwards.
+        void SetDepthFormat(DEPTH_FORMAT depthFormat);
+        DEPTH_FORMAT GetDepthFormat() const;
+        void SetDepthRange(double near, double far);
 
         size_t GetWidth() const;
         size_t GetHeight() const;
@@ -39,12 +82,54 @@ namespace pv {
         FrameBuffer& operator=(FrameBuffer&&) = delete;
 
     private:
+        enum class TILE_STATE : uchar {
+            DRAWN,
+            CLEAR_PENDING,
+            CLEARED
+        };
+
+        void ReleaseColorBuffer();
+        void ResetColorTiles();
+        size_t GetClearTileCount() const;
+        size_t GetClearTileIndex(size_t x, size_t y) const;
+        ScreenRect GetClearTileRect(size_t tileIndex) const;
+        void ResolveColorTile(size_t tileIndex) const;
+        void PrepareColorWrite(size_t x, size_t y);
+        void AllocateDepthBuffer();
+        void ReallocateDepthBuffer();
+        size_t GetDepthBufferSize() const;
+        void MarkDepthBlockDirty(size_t x, size_t y);
+
+        template<DEPTH_FORMAT FORMAT> void ZBufferDrawPixel(size_t x, size_t y, double z, const std::array<uchar, 4>&  argb);
+        template<DEPTH_FORMAT FORMAT> bool ZBufferTestPixel(size_t x, size_t y, double z, DEPTH_TEST depthTest) const;
+        template<DEPTH_FORMAT FORMAT> SpanMask ZBufferTestSpan(size_t x, size_t y, const double* z, SpanMask mask, DEPTH_TEST depthTest) const;
+        template<DEPTH_FORMAT FORMAT> void ZBufferWriteDepth(size_t x, size_t y, double z);
+        template<DEPTH_FORMAT FORMAT> bool ZBufferTestRect(const ScreenRect& rect, double nearestDepth, DEPTH_TEST depthTest) const;
+        template<DEPTH_FORMAT FORMAT> double GetBlockFarthestDepthKey(size_t blockX, size_t blockY) const;
+        template<DEPTH_FORMAT FORMAT> void ClearZBuffer();
+        template<DEPTH_FORMAT FORMAT> void PrepareDepthAccess(size_t x, size_t y, bool write) const;
+
         int components_count_;
         uchar* buffer_pointer_;
+        bool owns_color_buffer_;
         size_t width_;
         size_t height_;
 
-        double* depth_buffer_pointer_;
+        // A tile in CLEARED state still holds exactly what the last resolve wrote,
+        // so clearing it again to the same value costs nothing.
+        uint32_t clear_color_word_;
+        mutable std::vector<TILE_STATE> color_tile_states_;
+        mutable std::vector<TILE_STATE> depth_tile_states_;
+
+        uchar* depth_buffer_pointer_;
+        DEPTH_FORMAT depth_format_;
+        double depth_near_;
+        double depth_far_;
+
+        size_t depth_blocks_x_;
+        size_t depth_blocks_y_;
+        mutable std::vector<double> block_farthest_depth_;
+        mutable std::vector<uchar> block_depth_dirty_;
 
         static int const inline MODEL_COMPONENTS_COUNT[] = { 4 };
     };
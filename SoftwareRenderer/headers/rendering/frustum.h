@@ -0,0 +1,32 @@
+#ifndef PV_FRUSTUM_H
+#define PV_FRUSTUM_H
+
+#include <array>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include "headers/rendering/boundingbox.h"
+
+namespace pv {
+
+    // View frustum as six inward facing planes, taken from a transform into
+    // clip space with 0 <= z <= w, as GetFrustumProjection builds. The planes
+    // are in the space the transform starts from, so a full model-view-projection
+    // gives a frustum that object space bounds are tested against directly.
+    class Frustum {
+    public:
+        explicit Frustum(const glm::mat4& clipTransform);
+
+        // Conservative: boxes close to the frustum's edges may be reported as
+        // intersecting although they are just outside.
+        bool IntersectsBox(const BoundingBox& box) const;
+
+        // Whether all of box lies within the frustum.
+        bool ContainsBox(const BoundingBox& box) const;
+
+    private:
+        std::array<glm::vec4, 6> planes_;
+    };
+
+} // namespace pv
+
+#endif // PV_FRUSTUM_H
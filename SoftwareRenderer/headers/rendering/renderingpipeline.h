@@ -2,30 +2,49 @@
 #define PV_RENDERINGPIPELINE_H
 
 #include "headers/matrix_transform/animation.h"
+#include "headers/rendering/clusterhierarchy.h"
 #include "headers/rendering/scenedata.h"
+#include "headers/rendering/streamedmesh.h"
 #include "headers/rendering/framebuffer.h"
+#include "headers/rendering/renderstats.h"
+#include "headers/rendering/tilebinner.h"
+#include "headers/rendering/transformedvertices.h"
+#include "headers/rendering/triangleclipper.h"
+#include "headers/rendering/vertexkernels.h"
+#include "headers/rendering/viewportpoints.h"
 #include "headers/matrix_transform/camera.h"
-#include "headers/rendering/polygonedge.h"
-#include "headers/rendering/viewportpolygonmargins.h"
 #include "headers/shading/lightsource.h"
 #include "headers/shading/shadingmodel.h"
+#include "headers/threading/threadpool.h"
 #include <vector>
 #include <memory>
-#include <optional>
-#include <QVector>
+#include <utility>
 #include <glm/mat4x4.hpp>
 
 namespace pv {
 
     using AnimationHolder = std::unique_ptr<Animation>;
     using ShadingModelHolder = std::unique_ptr<ShadingModel>;
-    using ViewportPoint = glm::vec4;
 
     class RenderingPipeline {
     public:
         RenderingPipeline(const SceneData&);
 
-        void DoRender(size_t width, size_t height, uchar* renderedImage);
+        // Renders straight into renderedImage (width * height ARGB32 pixels);
+        // the depth buffer is kept between calls of the same size. With
+        // imagePreserved the image is the one from the previous call, untouched
+        // since, so parts that stayed background are not cleared again.
+        void DoRender(size_t width, size_t height, uchar* renderedImage, bool imagePreserved = false);
+        const RenderStats& GetLastFrameStats() const;
+
+        // Renders the chunks of streamedMesh in view instead of the scene data
+        // the pipeline was made with; nullptr goes back to the latter. The mesh
+        // is not owned and has to outlive its use here.
+        void SetStreamedMesh(StreamedMesh* streamedMesh);
+
+        // Rebuilds the cluster hierarchy the scene data the pipeline was made
+        // with is culled by. Has to be called whenever that scene data changed.
+        void UpdateSceneClusters();
 
         void SetNearPlaneDistance(float near);
         void SetFarPlaneDistance(float far);
@@ -33,6 +52,7 @@ namespace pv {
         void SetModelScaleFactor(float scaleFactor);
 
         void SetAnimationType(ANIMATION_TYPE animationType);
+        void AdvanceAnimation(float elapsedSeconds);
         void SetShadingModelType(SHADING_MODEL shadingType);
 
         void SetDrawWorldAxis(bool drawWorldAxis);
@@ -44,6 +64,7 @@ namespace pv {
         void SetZCameraView();
 
         void UpdateCameraPosition(int deltaX, int deltaY);
+        void RotateCamera(float azimuthDegrees, float inclinationDegrees);
         void SetOrbitCameraDistance(float distance);
 
         void SetNewPenColor(const std::array<uchar, 4>& argbPenColor);
@@ -51,6 +72,9 @@ namespace pv {
 
         void SetEnableZBuffering(bool enableZBuffering);
         void SetEnableBackfaceCulling(bool enableBackfaceCulling);
+        void SetEnableDepthPrepass(bool enableDepthPrepass);
+        void SetDepthFormat(DEPTH_FORMAT depthFormat);
+        void SetEnableDetailedProfiling(bool enableDetailedProfiling);
 
         void SetLightSources(std::vector<std::shared_ptr<LightSource>> lightSources);
 
@@ -65,39 +89,49 @@ namespace pv {
     private:
         void ApplyScaleFactor(glm::mat4& modelMatrix);
 
-        bool WCoordinateIsNonZero(float w);
-        bool PointIsWithinCanonicalViewVolume(const glm::vec4& point);
-        bool PointIsWithinViewportBoundaries(size_t width, size_t height, const glm::vec3& point);
-
-        std::vector<std::optional<ViewportPoint>> GetViewPortPoints(const std::vector<glm::vec3>& points, float aspectRatio, size_t width, size_t height);
+        void UpdateModelViewMatrices();
+        VertexTransformSetup GetVertexTransformSetup(float aspectRatio, size_t width, size_t height);
+        ViewportPoints GetViewPortPoints(const std::vector<glm::vec3>& points, float aspectRatio, size_t width, size_t height);
+        bool CullSceneClusters(const ClusterHierarchy& sceneClusters, float aspectRatio);
+        void TransformSceneVertices(const SceneData& sceneData, const ClusterHierarchy* culledClusters,
+                                    float aspectRatio, size_t width, size_t height);
         glm::mat4 GetFrustumProjection(float aspectRatio);
         glm::mat4 GetViewportTransform(size_t width, size_t height);
         float GetRadianAngle(float degreeAngle);
 
+        void RenderSceneData(FrameBuffer& frameBuffer, const SceneData& sceneData, const ClusterHierarchy* sceneClusters,
+                             size_t width, size_t height);
         void RenderWorldAxes(FrameBuffer& frameBuffer);
-        void RenderPolygonMesh(FrameBuffer& frameBuffer, const std::vector<std::optional<ViewportPoint>>& viewportPoints, const SceneData&);
-        void ZBufferRenderPolygonMesh(FrameBuffer& frameBuffer, const std::vector<std::optional<ViewportPoint>>& viewportPoints, const SceneData&);
+        void RenderPolygonMesh(FrameBuffer& frameBuffer, const ViewportPoints& viewportPoints, const SceneData&);
+        void ZBufferRenderPolygonMesh(FrameBuffer& frameBuffer, const ViewportPoints& viewportPoints, const SceneData&);
         using InterpolationPoint = glm::vec<3,double>;
         std::vector<InterpolationPoint> GetLineInterpolationPoints(const ViewportPoint& firstPoint, const ViewportPoint& secondPoint);
 
-        void RenderVertices(FrameBuffer& frameBuffer, const std::vector<std::optional<ViewportPoint>>& viewportPoints);
-        void RenderRasterizedPolygons(FrameBuffer& frameBuffer, const std::vector<std::optional<ViewportPoint>>& viewportPoints, const SceneData&);
-        void ZBufferRenderRasterizedPolygons(FrameBuffer& frameBuffer, const std::vector<std::optional<ViewportPoint>>& viewportPoints, const SceneData&);
+        void RenderVertices(FrameBuffer& frameBuffer, const ViewportPoints& viewportPoints);
+        void RenderRasterizedPolygons(FrameBuffer& frameBuffer);
+        void ZBufferRenderRasterizedPolygons(FrameBuffer& frameBuffer, const SceneData&);
+        void ZBufferRenderTileDepth(FrameBuffer& frameBuffer, size_t tileIndex);
 
-        bool AllPolygonVerticesVisible(const std::vector<std::optional<ViewportPoint> > &viewportPoints, const std::vector<int> &vertexIndices);
-        ViewportPolygonMargins GetViewportPolygonMargins(const std::vector<std::optional<ViewportPoint> > &viewportPoints, const std::vector<int> &vertexIndices);
+        struct TriangleSetupChunk;
 
-        std::vector<PolygonEdge> GetPolygonEdges(const std::vector<std::optional<ViewportPoint> > &viewportPoints, const std::vector<int> &vertexIndices);
-
-        std::vector<IntersectionPoint> GetIntersectionPoints(const std::vector<PolygonEdge>& polygonEdges, float currScanlineY);
-        void TryFixThreePointsIntersectionCase(std::vector<IntersectionPoint>&);
-
-        bool PolygonIsBackFacing(const Polygon& polygon, const std::vector<glm::vec3>& vertices);
+        void SetupScreenTriangles(const ViewportPoints& viewportPoints, const SceneData&, const ClusterHierarchy* culledClusters,
+                                  size_t width, size_t height, bool trianglesNeeded);
+        void AppendScreenTriangles(size_t polygonIndex,
+                                   int firstIndex, int secondIndex, int thirdIndex,
+                                   const ViewportPoints& viewportPoints,
+                                   size_t width, size_t height,
+                                   TriangleSetupChunk& setupChunk);
+        bool PolygonIsBackFacing(const int* vertexIndices, const ViewportPoints& viewportPoints) const;
+        bool PolygonIsCulled(size_t polygonIndex) const;
+        void MergeTileStats(double rasterizationMs);
 
         void SetAnimationHolder(AnimationHolder animationHolder);
         void SetShadingModelHolder(ShadingModelHolder shadingModelHolder);
 
         const SceneData& scene_data_;
+        ClusterHierarchy scene_clusters_;
+        std::vector<uint32_t> visible_clusters_;
+        StreamedMesh* streamed_mesh_;
         float fovy_;
         float near_;
         float far_;
@@ -105,6 +139,8 @@ namespace pv {
 
         AnimationHolder animation_holder_;
         ShadingModelHolder shading_model_holder_;
+        // Stands in for the selected shading model on scenes without normals.
+        NoShading unlit_shading_model_;
         Camera camera_;
 
         bool draw_polygon_mesh_;
@@ -117,11 +153,52 @@ namespace pv {
 
         bool z_buffer_enabled_;
         bool backface_culling_enabled_;
+        bool depth_prepass_enabled_;
+        DEPTH_FORMAT depth_format_;
+        bool detailed_profiling_enabled_;
 
         glm::mat4 curr_model_matrix_;
         glm::mat4 curr_view_matrix_;
 
         std::vector<std::shared_ptr<LightSource>> light_sources_;
+
+        // Only front-facing triangles that cover pixels of the viewport make it
+        // into the list. The rasterizer has their edge functions set up, with
+        // the viewport as scissor, for every tile and pass to start from.
+        struct ScreenTriangle {
+            ViewportPoint firstPoint;
+            ViewportPoint secondPoint;
+            ViewportPoint thirdPoint;
+            SourceVertexWeights sourceWeights;
+            uint32_t polygonIndex;
+            TriangleRasterizer rasterizer;
+        };
+
+        // Output of one chunk of polygons of the triangle setup, merged in
+        // polygon order once all chunks are done.
+        struct TriangleSetupChunk {
+            std::vector<ScreenTriangle> screenTriangles;
+            size_t firstTriangle;
+            RenderStats stats;
+        };
+
+        bool ScreenTriangleIsOccluded(const FrameBuffer& frameBuffer, const ScreenTriangle& screenTriangle,
+                                      const ScreenRect& triangleRect, DEPTH_TEST depthTest);
+
+        FrameBuffer frame_buffer_;
+        RenderStats render_stats_;
+        std::vector<RenderStats> tile_stats_;
+        std::vector<uchar> polygon_culled_;
+
+        TransformedVertices transformed_vertices_;
+        ViewportPoints viewport_points_;
+        std::vector<uchar> vertex_block_needed_;
+        std::vector<std::pair<size_t, size_t>> vertex_chunks_;
+        TriangleClipper triangle_clipper_;
+        std::vector<TriangleSetupChunk> triangle_setup_chunks_;
+        std::vector<ScreenTriangle> screen_triangles_;
+        TileBinner tile_binner_;
+        ThreadPool thread_pool_;
     };
 
 } // namespace pv
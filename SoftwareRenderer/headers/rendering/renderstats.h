@@ -0,0 +1,74 @@
+#ifndef PV_RENDERSTATS_H
+#define PV_RENDERSTATS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace pv {
+
+    enum class RENDER_STAGE {
+        CLEAR, VERTEX_TRANSFORM, CULLING, TRIANGLE_SETUP, RASTERIZATION, DEPTH_TEST, SHADING, RESOLVE
+    };
+    constexpr size_t RENDER_STAGE_COUNT = 8;
+
+    enum class RENDER_COUNTER {
+        TRIANGLES_IN, TRIANGLES_CULLED, TRIANGLES_CLIPPED,
+        PIXELS_SHADED, DEPTH_TESTS_PASSED, DEPTH_TESTS_FAILED
+    };
+    constexpr size_t RENDER_COUNTER_COUNT = 6;
+
+    // Where the time of one frame went and how much work it did. Stage times are
+    // exclusive and add up to the frame time. Depth test and shading run inside
+    // rasterization and are only split out of it, together with the per-pixel
+    // counters, when detailed profiling is on; otherwise they stay at zero.
+    struct RenderStats {
+        double frameMs = 0.0;
+        std::array<double, RENDER_STAGE_COUNT> stageMs {};
+        std::array<uint64_t, RENDER_COUNTER_COUNT> counters {};
+        bool detailed = false;
+
+        double GetStageMs(RENDER_STAGE stage) const { return stageMs[static_cast<size_t>(stage)]; }
+        uint64_t GetCounter(RENDER_COUNTER counter) const { return counters[static_cast<size_t>(counter)]; }
+
+        void AddStageMs(RENDER_STAGE stage, double milliseconds) { stageMs[static_cast<size_t>(stage)] += milliseconds; }
+        void AddCount(RENDER_COUNTER counter, uint64_t count) { counters[static_cast<size_t>(counter)] += count; }
+
+        void Merge(const RenderStats& other);
+
+        static const char* GetStageName(RENDER_STAGE stage);
+        static const char* GetCounterName(RENDER_COUNTER counter);
+    };
+
+    // Adds the lifetime of the scope to a stage; does nothing, not even reading
+    // the clock, when no stats are given.
+    class ScopedStageTimer {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        ScopedStageTimer(RenderStats* renderStats, RENDER_STAGE stage) :
+            render_stats_(renderStats),
+            stage_(stage)
+        {
+            if (render_stats_) start_ = Clock::now();
+        }
+
+        ~ScopedStageTimer() {
+            if (render_stats_){
+                render_stats_->AddStageMs(stage_, std::chrono::duration<double, std::milli>(Clock::now() - start_).count());
+            }
+        }
+
+        ScopedStageTimer(const ScopedStageTimer&) = delete;
+        ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+    private:
+        RenderStats* render_stats_;
+        RENDER_STAGE stage_;
+        Clock::time_point start_;
+    };
+
+} // namespace pv
+
+#endif // PV_RENDERSTATS_H
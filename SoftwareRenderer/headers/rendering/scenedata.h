@@ -1,25 +1,44 @@
 #ifndef PV_SCENEDATA_H
 #define PV_SCENEDATA_H
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <glm/vec3.hpp>
 
 namespace pv {
 
-    struct Polygon {
-        std::vector<int> vertex_indices;
-        std::vector<int> texture_indices;
-        std::vector<int> normal_indices;
-    };
-
+    // Vertex attributes live in one array each, and polygons are compressed rows
+    // over a flat corner index array instead of objects owning their own index
+    // lists: polygon p is made of the corners [polygon_offsets[p], polygon_offsets[p + 1]),
+    // and corner c uses vertex vertex_indices[c]. Vertices are welded, so that one
+    // index selects the position, texture coordinate and normal; the latter two
+    // arrays are either empty or hold one entry per vertex. Once all polygons are
+    // triangles, corners come in fixed strides of three.
     struct SceneData {
     public:
         SceneData();
 
+        size_t GetPolygonCount() const { return polygon_offsets.size() - 1; }
+        size_t GetFirstCorner(size_t polygonIndex) const { return polygon_offsets[polygonIndex]; }
+        size_t GetCornerCount(size_t polygonIndex) const { return polygon_offsets[polygonIndex + 1] - polygon_offsets[polygonIndex]; }
+
+        bool HasTextureCoords() const { return !vertex_textures.empty(); }
+        bool HasNormals() const { return !vertex_normals.empty(); }
+
+        // Ends a polygon made of the corners appended since the previous one.
+        void EndPolygon();
+
+        // Splits each quad (0, 1, 2, 3) into (0, 1, 2) in its place and (2, 3, 0)
+        // appended after all polygons.
+        void SplitQuadsIntoTriangles();
+
         std::vector<glm::vec3> vertices;
         std::vector<glm::vec3> vertex_textures;
         std::vector<glm::vec3> vertex_normals;
-        std::vector<Polygon> polygons;
+
+        std::vector<uint32_t> polygon_offsets;
+        std::vector<int> vertex_indices;
     };
 
 } // namespace pv
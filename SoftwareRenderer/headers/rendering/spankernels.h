@@ -0,0 +1,69 @@
+#ifndef PV_SPANKERNELS_H
+#define PV_SPANKERNELS_H
+
+#include <cstdint>
+
+namespace pv {
+
+    // Pixels are pushed through the per-fragment stages in horizontal spans of
+    // SPAN_WIDTH, one bit of a SpanMask per pixel. Every stage has a scalar
+    // implementation and SSE2 / AVX2 ones picked once at runtime; all of them
+    // produce bit-identical results, so depth-equal tests stay valid across paths.
+    constexpr int SPAN_WIDTH = 8;
+    using SpanMask = uint32_t;
+
+    enum class SIMD_LEVEL { SCALAR, SSE2, AVX2 };
+
+    struct EdgeSpanSetup {
+        double xStep[3];
+        int uEdge;
+        int vEdge;
+        double uBias;
+        double vBias;
+        double inverseDoubleArea;
+    };
+
+    struct DepthSpanSetup {
+        double inverseWOrigin;
+        double inverseWUDelta;
+        double inverseWVDelta;
+    };
+
+    struct LightingSpan {
+        float positionX[SPAN_WIDTH];
+        float positionY[SPAN_WIDTH];
+        float positionZ[SPAN_WIDTH];
+
+        float normalX[SPAN_WIDTH];
+        float normalY[SPAN_WIDTH];
+        float normalZ[SPAN_WIDTH];
+    };
+
+    struct SpanKernels {
+        // Coverage of `count` pixels starting at the given edge values, plus the
+        // barycentric weights of the second and third vertex for each of them.
+        SpanMask (*EvaluateEdges)(const EdgeSpanSetup& setup, const int64_t (&edgeValues)[3], int count,
+                                  double* u, double* v);
+
+        // Perspective-correct depth; drops lanes that end up behind the eye.
+        SpanMask (*InterpolateDepth)(const DepthSpanSetup& setup, const double* u, const double* v,
+                                     SpanMask mask, double* depth);
+
+        // Depth tests per storage format; reversed-Z keeps the larger value.
+        SpanMask (*DepthTest)(const double* storedDepth, const double* depth, SpanMask mask, bool acceptEqual);
+        SpanMask (*DepthTestReversedFloat)(const float* storedDepth, const float* depth, SpanMask mask, bool acceptEqual);
+        SpanMask (*DepthTestUnorm)(const uint32_t* storedDepth, const uint32_t* depth, SpanMask mask, bool acceptEqual);
+
+        // Per-light Phong terms in camera space: clamped N.L and clamped R.V,
+        // with the normal and light direction normalized per lane.
+        void (*EvaluateLighting)(const LightingSpan& span, const float (&lightPosition)[3], int count,
+                                 float* lambertTerm, float* reflectionTerm);
+    };
+
+    SIMD_LEVEL GetSupportedSimdLevel();
+    const SpanKernels& GetSpanKernels(SIMD_LEVEL simdLevel);
+    const SpanKernels& GetSpanKernels();
+
+} // namespace pv
+
+#endif // PV_SPANKERNELS_H
@@ -0,0 +1,113 @@
+#ifndef PV_STREAMEDMESH_H
+#define PV_STREAMEDMESH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include "headers/object_file_parser/mappedfile.h"
+#include "headers/rendering/boundingbox.h"
+#include "headers/rendering/frustum.h"
+#include "headers/rendering/scenedata.h"
+
+namespace pv {
+
+    class ObjectFileParser;
+
+    // Mesh kept on disk as spatial chunks, of which only the ones in view are
+    // held in memory. A chunk file starts with a header recording the OBJ file
+    // content and settings it was made from and a table of chunk bounding boxes,
+    // followed by every chunk as a self-contained triangle mesh with its own
+    // welded vertices. Each frame UpdateResidency pages in the visible chunks,
+    // nearest first, and evicts the least recently visible ones to stay within
+    // the memory budget. Visible chunks that don't fit are skipped.
+    class StreamedMesh {
+    public:
+        static constexpr size_t DEFAULT_TRIANGLES_PER_CHUNK = 32768;
+
+        // Throws std::runtime_error if the file is missing or not a chunk file.
+        // Chunks are only checked once they are loaded, so UpdateResidency
+        // throws for a chunk whose triangles refer to vertices it doesn't have.
+        StreamedMesh(const std::string& chunkFilePath, size_t memoryBudgetBytes);
+
+        // Reads the OBJ file through objectFileParser, which applies the YZ axes
+        // fix if asked to, and writes it as chunks of at most trianglesPerChunk
+        // triangles. The mesh never has to fit in memory: its attributes and
+        // triangles go to scratch files next to the chunk file, the triangles
+        // are binned on disk into spatial cells of bounded size, and only then
+        // is each cell split into chunks by recursive median splits of the
+        // triangle centroids along the longest axis. Throws std::runtime_error
+        // for unreadable or malformed files and files without triangles.
+        static void WriteChunkFile(ObjectFileParser& objectFileParser,
+                                   const std::string& objectFilePath,
+                                   const std::string& chunkFilePath,
+                                   size_t trianglesPerChunk = DEFAULT_TRIANGLES_PER_CHUNK);
+
+        // True when chunkFilePath holds a chunk file that WriteChunkFile made
+        // from the current content of the OBJ file, with the same YZ axes fix
+        // and chunk size; only then can it be used instead of writing it again.
+        static bool ChunkFileIsUpToDate(const ObjectFileParser& objectFileParser,
+                                        const std::string& objectFilePath,
+                                        const std::string& chunkFilePath,
+                                        size_t trianglesPerChunk = DEFAULT_TRIANGLES_PER_CHUNK);
+
+        void SetMemoryBudget(size_t memoryBudgetBytes);
+        size_t GetMemoryBudget() const;
+
+        // frustum and viewPoint are in the object space of the mesh.
+        void UpdateResidency(const Frustum& frustum, const glm::vec3& viewPoint);
+
+        // Chunks found visible and resident by the last UpdateResidency.
+        const std::vector<const SceneData*>& GetVisibleChunks() const;
+
+        bool HasTextureCoords() const;
+        bool HasNormals() const;
+
+        size_t GetChunkCount() const;
+        size_t GetResidentChunkCount() const;
+        size_t GetResidentBytes() const;
+        const BoundingBox& GetBounds() const;
+
+        StreamedMesh(const StreamedMesh&) = delete;
+        StreamedMesh(StreamedMesh&&) = delete;
+
+        StreamedMesh& operator=(const StreamedMesh&) = delete;
+        StreamedMesh& operator=(StreamedMesh&&) = delete;
+
+    private:
+        struct MeshChunk {
+            BoundingBox bounds;
+            uint32_t vertexCount;
+            uint32_t triangleCount;
+            uint64_t fileOffset;
+            size_t byteSize;
+
+            std::unique_ptr<SceneData> sceneData;
+            uint64_t lastVisibleFrame;
+            std::list<size_t>::iterator residentPosition;
+        };
+
+        void LoadChunk(size_t chunkIndex);
+        bool EvictLeastRecentlyVisibleChunk();
+
+        std::string chunk_file_path_;
+        MappedFile chunk_file_;
+        bool has_texture_coords_;
+        bool has_normals_;
+        BoundingBox bounds_;
+
+        std::vector<MeshChunk> chunks_;
+        // Resident chunks, most recently visible first.
+        std::list<size_t> resident_chunks_;
+        size_t resident_bytes_;
+        size_t memory_budget_bytes_;
+        uint64_t frame_index_;
+
+        std::vector<const SceneData*> visible_chunks_;
+    };
+
+} // namespace pv
+
+#endif // PV_STREAMEDMESH_H
@@ -0,0 +1,40 @@
+#ifndef PV_TILEBINNER_H
+#define PV_TILEBINNER_H
+
+#include "headers/rendering/trianglerasterizer.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pv {
+
+    // Sorts screen-space triangles into fixed-size screen tiles. Each tile keeps the
+    // indices of the triangles whose bounding box touches it, in submission order, so
+    // tiles can be rasterized independently without changing the depth-test outcome.
+    class TileBinner {
+    public:
+        static constexpr int TILE_SIZE = 64;
+
+        TileBinner();
+
+        void Reset(size_t width, size_t height);
+        // boundingRect is the pixel bounding box of the triangle, as its
+        // rasterizer has it.
+        void BinTriangle(uint32_t triangleIndex, const ScreenRect& boundingRect);
+
+        size_t GetTileCount() const;
+        ScreenRect GetTileRect(size_t tileIndex) const;
+        const std::vector<uint32_t>& GetTileTriangles(size_t tileIndex) const;
+
+    private:
+        size_t width_;
+        size_t height_;
+        size_t tiles_x_;
+        size_t tiles_y_;
+
+        std::vector<std::vector<uint32_t>> tile_bins_;
+    };
+
+} // namespace pv
+
+#endif // PV_TILEBINNER_H
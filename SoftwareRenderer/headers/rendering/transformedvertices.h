@@ -0,0 +1,28 @@
+#ifndef PV_TRANSFORMEDVERTICES_H
+#define PV_TRANSFORMEDVERTICES_H
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+
+namespace pv {
+
+    // Post-transform vertex cache. The vertex stage fills it once per frame,
+    // one entry per scene vertex, and every triangle sharing a vertex reads it
+    // from here instead of transforming it again. Camera space normals are not
+    // normalized; cameraNormals is empty when the scene has no normals.
+    struct TransformedVertices {
+        glm::mat4 view;
+        glm::mat4 modelView;
+        glm::mat3 modelViewNormal;
+
+        std::vector<glm::vec4> clipPositions;
+        std::vector<glm::vec3> cameraPositions;
+        std::vector<glm::vec3> cameraNormals;
+    };
+
+} // namespace pv
+
+#endif // PV_TRANSFORMEDVERTICES_H
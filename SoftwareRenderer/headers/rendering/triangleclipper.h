@@ -0,0 +1,53 @@
+#ifndef PV_TRIANGLECLIPPER_H
+#define PV_TRIANGLECLIPPER_H
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <array>
+#include <cstddef>
+
+namespace pv {
+
+    // Sutherland-Hodgman clipping of clip-space triangles. Near and far are clipped
+    // exactly; x and y are only clipped against a guard band several times wider than
+    // the viewport, the rasterizer scissor takes care of the rest. Each output vertex
+    // carries its barycentric weights relative to the three input vertices, so
+    // per-vertex attributes can be interpolated the same way as the position.
+    class TriangleClipper {
+    public:
+        using ClipSpacePoint = glm::vec4;
+
+        static constexpr float DEFAULT_GUARD_BAND_SCALE = 8.0F;
+        static constexpr size_t MAX_CLIPPED_VERTICES = 9;
+
+        struct ClipVertex {
+            ClipSpacePoint position;
+            glm::vec3 sourceWeights;
+        };
+
+        struct ClippedPolygon {
+            std::array<ClipVertex, MAX_CLIPPED_VERTICES> vertices;
+            size_t vertexCount;
+        };
+
+        explicit TriangleClipper(float guardBandScale = DEFAULT_GUARD_BAND_SCALE);
+
+        // Returns false when nothing of the triangle is left inside the view frustum.
+        bool ClipTriangle(const ClipSpacePoint& firstPoint,
+                          const ClipSpacePoint& secondPoint,
+                          const ClipSpacePoint& thirdPoint,
+                          ClippedPolygon& clippedPolygon) const;
+
+    private:
+        enum CLIP_PLANE { NEAR_PLANE, FAR_PLANE, LEFT_PLANE, RIGHT_PLANE, BOTTOM_PLANE, TOP_PLANE, CLIP_PLANE_COUNT };
+
+        float GetPlaneDistance(int clipPlane, const ClipSpacePoint& point, float planeScale) const;
+        unsigned GetOutcode(const ClipSpacePoint& point, float planeScale) const;
+        void ClipAgainstPlane(int clipPlane, ClippedPolygon& clippedPolygon) const;
+
+        float guard_band_scale_;
+    };
+
+} // namespace pv
+
+#endif // PV_TRIANGLECLIPPER_H
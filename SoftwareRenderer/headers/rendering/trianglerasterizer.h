@@ -0,0 +1,181 @@
+#ifndef PV_TRIANGLERASTERIZER_H
+#define PV_TRIANGLERASTERIZER_H
+
+#include "headers/rendering/spankernels.h"
+#include <glm/vec4.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace pv {
+
+    struct ScreenRect {
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+    // Spans are walked in screen-aligned square blocks of this size, the same
+    // granularity the frame buffer keeps its hierarchical depth at.
+    constexpr int RASTER_BLOCK_SIZE = SPAN_WIDTH;
+
+    constexpr ScreenRect UNBOUNDED_SCREEN_RECT {
+        std::numeric_limits<int>::min() / 2, std::numeric_limits<int>::min() / 2,
+        std::numeric_limits<int>::max() / 2, std::numeric_limits<int>::max() / 2
+    };
+
+    // Half-space rasterizer: edge functions are evaluated once per triangle in
+    // 28.4 fixed point and then stepped incrementally over the bounding box.
+    // Pixels are sampled at integer coordinates, shared edges follow the top-left rule.
+    class TriangleRasterizer {
+    public:
+        using ViewportPoint = glm::vec4;
+        using EdgeValues = int64_t[3];
+
+        // An empty rasterizer, covering no pixels.
+        TriangleRasterizer();
+
+        TriangleRasterizer(const ViewportPoint& firstPoint,
+                           const ViewportPoint& secondPoint,
+                           const ViewportPoint& thirdPoint,
+                           const ScreenRect& scissorRect = UNBOUNDED_SCREEN_RECT);
+
+        // Reuses the edge functions of triangleSetup and only cuts its bounding
+        // box down to scissorRect, the same as setting up the triangle again
+        // with the intersection of both scissor rects.
+        TriangleRasterizer(const TriangleRasterizer& triangleSetup, const ScreenRect& scissorRect);
+
+        bool IsEmpty() const;
+        const ScreenRect& GetBoundingRect() const;
+
+        template<typename PixelCallback>
+        void ForEachCoveredPixel(PixelCallback&& pixelCallback) const;
+
+        // Walks the bounding box in spans of SPAN_WIDTH pixels and hands out the
+        // coverage mask together with the barycentric weights of the second and
+        // third vertex, taken straight from the edge function values.
+        template<typename SpanCallback>
+        void ForEachCoveredSpan(SpanCallback&& spanCallback) const;
+
+        // Same walk, block by block; blockFilter(blockRect, u, v) gets the weights at
+        // the four corner pixels of each block and can skip it by returning false.
+        template<typename SpanCallback, typename BlockFilter>
+        void ForEachCoveredSpan(SpanCallback&& spanCallback, BlockFilter&& blockFilter) const;
+
+    private:
+        struct EdgeFunction {
+            int64_t xStep;
+            int64_t yStep;
+            int64_t originValue;
+        };
+
+        EdgeFunction GetEdgeFunction(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t& fillRuleBias) const;
+        int64_t GetEdgeValue(int edge, int x, int y) const;
+
+        static constexpr int SUBPIXEL_BITS = 4;
+        static constexpr int64_t SUBPIXEL_STEPS = 1 << SUBPIXEL_BITS;
+
+        EdgeFunction edges_[3];
+        EdgeSpanSetup span_setup_;
+        ScreenRect bounding_rect_;
+        bool is_empty_;
+    };
+
+    template<typename PixelCallback>
+    void TriangleRasterizer::ForEachCoveredPixel(PixelCallback&& pixelCallback) const {
+        if (is_empty_) return;
+
+        const int64_t startX = bounding_rect_.minX;
+        const int64_t startY = bounding_rect_.minY;
+
+        int64_t rowValue0 = edges_[0].originValue + edges_[0].xStep * startX + edges_[0].yStep * startY;
+        int64_t rowValue1 = edges_[1].originValue + edges_[1].xStep * startX + edges_[1].yStep * startY;
+        int64_t rowValue2 = edges_[2].originValue + edges_[2].xStep * startX + edges_[2].yStep * startY;
+
+        for (int y = bounding_rect_.minY; y <= bounding_rect_.maxY; ++y){
+            EdgeValues edgeValues = { rowValue0, rowValue1, rowValue2 };
+
+            for (int x = bounding_rect_.minX; x <= bounding_rect_.maxX; ++x){
+                if ((edgeValues[0] | edgeValues[1] | edgeValues[2]) >= 0){
+                    if constexpr (std::is_invocable_v<PixelCallback, int, int, const EdgeValues&>){
+                        pixelCallback(x, y, edgeValues);
+                    } else {
+                        pixelCallback(x, y);
+                    }
+                }
+
+                edgeValues[0] += edges_[0].xStep;
+                edgeValues[1] += edges_[1].xStep;
+                edgeValues[2] += edges_[2].xStep;
+            }
+
+            rowValue0 += edges_[0].yStep;
+            rowValue1 += edges_[1].yStep;
+            rowValue2 += edges_[2].yStep;
+        }
+    }
+
+    template<typename SpanCallback>
+    void TriangleRasterizer::ForEachCoveredSpan(SpanCallback&& spanCallback) const {
+        ForEachCoveredSpan(std::forward<SpanCallback>(spanCallback),
+                           [](const ScreenRect&, const double (&)[4], const double (&)[4]){ return true; });
+    }
+
+    template<typename SpanCallback, typename BlockFilter>
+    void TriangleRasterizer::ForEachCoveredSpan(SpanCallback&& spanCallback, BlockFilter&& blockFilter) const {
+        if (is_empty_) return;
+
+        const SpanKernels& spanKernels = GetSpanKernels();
+        double u[SPAN_WIDTH];
+        double v[SPAN_WIDTH];
+
+        const auto alignDown = [](int value){ return value - (((value % RASTER_BLOCK_SIZE) + RASTER_BLOCK_SIZE) % RASTER_BLOCK_SIZE); };
+
+        for (int blockY = alignDown(bounding_rect_.minY); blockY <= bounding_rect_.maxY; blockY += RASTER_BLOCK_SIZE){
+            for (int blockX = alignDown(bounding_rect_.minX); blockX <= bounding_rect_.maxX; blockX += RASTER_BLOCK_SIZE){
+                const ScreenRect blockRect {
+                    std::max(blockX, bounding_rect_.minX), std::max(blockY, bounding_rect_.minY),
+                    std::min(blockX + RASTER_BLOCK_SIZE - 1, bounding_rect_.maxX),
+                    std::min(blockY + RASTER_BLOCK_SIZE - 1, bounding_rect_.maxY)
+                };
+
+                double cornerU[4], cornerV[4];
+                for (int corner = 0; corner < 4; ++corner){
+                    const int x = (corner & 1) ? blockRect.maxX : blockRect.minX;
+                    const int y = (corner & 2) ? blockRect.maxY : blockRect.minY;
+                    cornerU[corner] = (static_cast<double>(GetEdgeValue(span_setup_.uEdge, x, y)) - span_setup_.uBias) * span_setup_.inverseDoubleArea;
+                    cornerV[corner] = (static_cast<double>(GetEdgeValue(span_setup_.vEdge, x, y)) - span_setup_.vBias) * span_setup_.inverseDoubleArea;
+                }
+
+                if (!blockFilter(blockRect, cornerU, cornerV)) continue;
+
+                // Spans start on the block boundary; lanes left of the bounding box are masked off.
+                const SpanMask leadingMask = ~((SpanMask{1} << (blockRect.minX - blockX)) - 1);
+                const int count = blockRect.maxX - blockX + 1;
+
+                for (int y = blockRect.minY; y <= blockRect.maxY; ++y){
+                    const int64_t edgeValues[3] = {
+                        GetEdgeValue(0, blockX, y),
+                        GetEdgeValue(1, blockX, y),
+                        GetEdgeValue(2, blockX, y)
+                    };
+
+                    const SpanMask coverageMask = spanKernels.EvaluateEdges(span_setup_, edgeValues, count, u, v) & leadingMask;
+                    if (coverageMask){
+                        spanCallback(blockX, y, coverageMask, u, v);
+                    }
+                }
+            }
+        }
+    }
+
+    inline int64_t TriangleRasterizer::GetEdgeValue(int edge, int x, int y) const {
+        return edges_[edge].originValue + edges_[edge].xStep * x + edges_[edge].yStep * y;
+    }
+
+} // namespace pv
+
+#endif // PV_TRIANGLERASTERIZER_H
@@ -0,0 +1,53 @@
+#ifndef PV_VERTEXKERNELS_H
+#define PV_VERTEXKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include "headers/rendering/spankernels.h"
+
+namespace pv {
+
+    // Object space positions go through the vertex stage in batches of four or
+    // eight lanes, the AoS input transposed into registers of one component
+    // each. As with the span kernels every implementation gives bit-identical
+    // results, the same that glm's mat4 * vec4 gives.
+    struct VertexTransformSetup {
+        glm::mat4 clipTransform;
+        glm::mat4 cameraTransform;
+
+        float viewportHalfWidth;
+        float viewportHalfHeight;
+        float viewportWidth;
+        float viewportHeight;
+    };
+
+    // Where the transformed vertices go, each pointer at the entry of the
+    // first vertex. The first vertex has to start a visibility mask word, as
+    // the words are written whole.
+    struct VertexTransformOutput {
+        glm::vec4* clipPositions;
+        glm::vec3* cameraPositions;
+
+        float* viewportX;
+        float* viewportY;
+        float* viewportZ;
+        float* inverseW;
+        uint64_t* visibleMasks;
+    };
+
+    struct VertexKernels {
+        // A vertex is visible when it has a non-zero w, lies within the
+        // canonical view volume and maps into the viewport.
+        void (*TransformVertices)(const VertexTransformSetup& setup, const glm::vec3* positions, size_t count,
+                                  const VertexTransformOutput& output);
+    };
+
+    const VertexKernels& GetVertexKernels(SIMD_LEVEL simdLevel);
+    const VertexKernels& GetVertexKernels();
+
+} // namespace pv
+
+#endif // PV_VERTEXKERNELS_H
@@ -0,0 +1,78 @@
+#ifndef PV_VERTEXWELDER_H
+#define PV_VERTEXWELDER_H
+
+#include "headers/rendering/scenedata.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pv {
+
+    // Welds corners that index positions, texture coordinates and normals separately,
+    // as OBJ faces do, into vertices that share one index for all attributes. Every
+    // distinct (position, texture coordinate, normal) combination becomes one vertex,
+    // so per-vertex work can be done once and shared by all polygons using it.
+    class VertexWelder {
+    public:
+        static constexpr int NO_INDEX = -1;
+
+        VertexWelder() = default;
+
+        void Reserve(size_t vertexCount);
+
+        // Index of the welded vertex for the combination, added on first use.
+        // textureIndex and normalIndex may be NO_INDEX.
+        int GetVertexIndex(int positionIndex, int textureIndex, int normalIndex);
+        size_t GetVertexCount() const;
+
+        // Position, texture coordinate and normal index the welded vertex stands for.
+        std::array<int, 3> GetAttributeIndices(size_t vertexIndex) const;
+
+        // Replaces the attribute arrays of sceneData, which the indices given so far
+        // refer to, with one entry per welded vertex. Texture coordinates or normals
+        // are dropped unless every vertex has one.
+        void WeldAttributes(SceneData& sceneData) const;
+
+    private:
+        static constexpr size_t MIN_SLOT_COUNT = 64;
+
+        struct WeldKey {
+            int positionIndex;
+            int textureIndex;
+            int normalIndex;
+
+            bool operator==(const WeldKey& other) const {
+                return positionIndex == other.positionIndex &&
+                       textureIndex == other.textureIndex &&
+                       normalIndex == other.normalIndex;
+            }
+        };
+
+        struct WeldKeyHash {
+            size_t operator()(const WeldKey& key) const {
+                uint64_t hash = static_cast<uint32_t>(key.positionIndex);
+                hash = hash * 0x9E3779B97F4A7C15ULL ^ static_cast<uint32_t>(key.textureIndex);
+                hash = hash * 0x9E3779B97F4A7C15ULL ^ static_cast<uint32_t>(key.normalIndex);
+                return static_cast<size_t>(hash ^ (hash >> 32));
+            }
+        };
+
+        int FindOrAddVertex(const WeldKey& key);
+        void Rehash(size_t slotCount);
+
+        // Open addressing table of welded vertex indices, NO_INDEX for free
+        // slots, so welding doesn't allocate per vertex. Its size is a power
+        // of two and at most half of it is used.
+        std::vector<WeldKey> welded_keys_;
+        std::vector<int> vertex_index_slots_;
+
+        // First vertex welded for each position below the reserved count. Most
+        // positions weld to a single vertex, and faces mostly refer to nearby
+        // positions, so this is checked before the hash table.
+        std::vector<int> vertex_index_by_position_;
+    };
+
+} // namespace pv
+
+#endif // PV_VERTEXWELDER_H
@@ -0,0 +1,47 @@
+#ifndef PV_VIEWPORTPOINTS_H
+#define PV_VIEWPORTPOINTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/vec4.hpp>
+
+namespace pv {
+
+    // x, y and depth in the viewport, and 1 / w of the clip space point.
+    using ViewportPoint = glm::vec4;
+
+    // Viewport points of a whole vertex array, one array per component, with
+    // a separate bit per vertex telling whether it landed within the view
+    // volume and the viewport. Components of vertices outside are undefined.
+    struct ViewportPoints {
+        static constexpr size_t MASK_BITS = 64;
+
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> inverseW;
+        std::vector<uint64_t> visibleMasks;
+
+        void Resize(size_t pointCount) {
+            x.resize(pointCount);
+            y.resize(pointCount);
+            z.resize(pointCount);
+            inverseW.resize(pointCount);
+            visibleMasks.resize((pointCount + MASK_BITS - 1) / MASK_BITS);
+        }
+
+        size_t GetSize() const { return x.size(); }
+
+        bool IsVisible(size_t pointIndex) const {
+            return (visibleMasks[pointIndex / MASK_BITS] >> (pointIndex % MASK_BITS)) & 1;
+        }
+
+        ViewportPoint GetPoint(size_t pointIndex) const {
+            return { x[pointIndex], y[pointIndex], z[pointIndex], inverseW[pointIndex] };
+        }
+    };
+
+} // namespace pv
+
+#endif // PV_VIEWPORTPOINTS_H
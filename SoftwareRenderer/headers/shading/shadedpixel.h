@@ -5,6 +5,9 @@
 #include <array>
 #include <vector>
 #include <glm/mat4x4.hpp>
+#include "headers/rendering/renderstats.h"
+#include "headers/rendering/spankernels.h"
+#include "headers/rendering/trianglerasterizer.h"
 
 namespace pv{
 
@@ -17,6 +20,36 @@ namespace pv{
         std::array<uchar, 4> shadeColor;
     };
 
+    class ShadedPixelSink {
+    public:
+        virtual ~ShadedPixelSink() = default;
+
+        // Called before a fragment is shaded, so hidden fragments never pay for lighting.
+        virtual bool DepthTestPassed(const InterpolationPoint&) { return true; }
+
+        // Span form of the test; depth holds SPAN_WIDTH values for the pixels starting at (x, y).
+        virtual SpanMask DepthTestSpan(int x, int y, const double* depth, SpanMask mask) {
+            for (int lane = 0; lane < SPAN_WIDTH; ++lane){
+                if ((mask & (SpanMask{1} << lane)) &&
+                    !DepthTestPassed(InterpolationPoint{x + lane, y, depth[lane]}))
+                {
+                    mask &= ~(SpanMask{1} << lane);
+                }
+            }
+            return mask;
+        }
+
+        // Coarse test for a whole block of pixels none of which lies closer than
+        // nearestDepth; returning false skips the block without rasterizing it.
+        virtual bool DepthTestBlock(const ScreenRect&, double /*nearestDepth*/) { return true; }
+
+        // Stats that shading time inside the fragment loop goes to; null unless
+        // detailed profiling is on.
+        virtual RenderStats* GetProfilingStats() { return nullptr; }
+
+        virtual void DrawShadedPixel(const ShadedPixel& shadedPixel) = 0;
+    };
+
 }
 
 #endif // SHADEDPIXEL_H
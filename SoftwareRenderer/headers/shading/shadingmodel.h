@@ -6,11 +6,13 @@
 #include <vector>
 #include <glm/mat4x4.hpp>
 #include <memory>
+#include <type_traits>
 #include "headers/shading/lightsource.h"
 #include "headers/rendering/scenedata.h"
-#include "headers/rendering/polygonedge.h"
-#include "headers/rendering/viewportpolygonmargins.h"
+#include "headers/rendering/transformedvertices.h"
 #include "headers/shading/shadedpixel.h"
+#include "headers/rendering/trianglerasterizer.h"
+#include "headers/rendering/attributeinterpolation.h"
 #include "headers/texturing/texture.h"
 
 namespace pv {
@@ -28,15 +30,18 @@ namespace pv {
         virtual ~ShadingModel() = default;
 
         //------
-        virtual std::vector<ShadedPixel>
-        GetShadedPixels
+        virtual void
+        ShadeTriangle
         (
                 const ViewportPoint&, const ViewportPoint&, const ViewportPoint&,
-                const Polygon&,
+                const SourceVertexWeights&,
+                const TriangleRasterizer&,
+                size_t,
                 const SceneData&,
                 std::array<uchar, 4>,
                 const std::vector<std::shared_ptr<LightSource>>&,
-                const glm::mat4&, const glm::mat4&
+                const TransformedVertices&,
+                ShadedPixelSink&
         ) const = 0;
         //------
 
@@ -49,18 +54,19 @@ namespace pv {
         void SetSpecularTexture(TextureHolder specularTexture);
 
     protected:
-        mutable bool normal_interpolation_needed_;
-        mutable std::vector<glm::vec3>* normal_vectors_ptr_;
-        mutable std::vector<glm::vec3>* interpolated_normal_vectors_ptr_;
-
-        mutable bool camera_space_interpolation_needed_;
-        mutable std::vector<glm::vec3>* camera_space_pos_ptr_;
-        mutable std::vector<glm::vec3>* interpolated_camera_space_pos_ptr_;
-
-        mutable bool texture_coord_interpolation_needed_;
-        mutable std::vector<glm::vec3>* texture_coords_ptr_;
-        mutable std::vector<glm::vec3>* interpolated_texture_coords_ptr_;
-
+        // Depth-tests every span the rasterizer covers against the sink first and
+        // only interpolates attributes and runs the fragment shader for survivors.
+        // The shader either takes one InterpolatedFragment and returns its color,
+        // or takes a whole InterpolatedFragmentSpan and writes one color per
+        // fragment.
+        template<typename FragmentShader>
+        void ShadeInterpolatedFragments
+        (
+                const TriangleRasterizer&,
+                const AttributeInterpolation&,
+                ShadedPixelSink&,
+                FragmentShader&&
+        ) const;
 
         bool diffuse_texturing_enabled_;
         bool normal_texturing_enabled_;
@@ -69,30 +75,74 @@ namespace pv {
         TextureHolder diffuse_texture_;
         TextureHolder normal_texture_;
         TextureHolder specular_texture_;
-
-    private:
-        std::vector<InterpolationPoint> GetTriangleInterpolationPoints(const ViewportPoint& firstPoint, const ViewportPoint& secondPoint, const ViewportPoint& thirdPoint) const;
-        ViewportPolygonMargins GetViewportTriangleMargins(const ViewportPoint& firstPoint, const ViewportPoint& secondPoint, const ViewportPoint& thirdPoint) const;
-        std::vector<PolygonEdge> GetTriangleEdges(const ViewportPoint& firstPoint, const ViewportPoint& secondPoint, const ViewportPoint& thirdPoint) const;
-        std::vector<IntersectionPoint> GetIntersectionPoints(const std::vector<PolygonEdge>& polygonEdges, float currScanlineY) const;
-        void TryFixThreePointsIntersectionCase(std::vector<IntersectionPoint>&) const;
     };
 
+    template<typename FragmentShader>
+    void ShadingModel::ShadeInterpolatedFragments
+    (
+            const TriangleRasterizer& triangleRasterizer,
+            const AttributeInterpolation& attrInterpolation,
+            ShadedPixelSink& pixelSink,
+            FragmentShader&& fragmentShader
+    ) const {
+
+        InterpolatedFragmentSpan fragmentSpan;
+        RenderStats* const profilingStats = pixelSink.GetProfilingStats();
+
+        const auto blockFilter = [&](const ScreenRect& blockRect, const double (&cornerU)[4], const double (&cornerV)[4]){
+            return pixelSink.DepthTestBlock(blockRect, attrInterpolation.GetNearestDepth(cornerU, cornerV));
+        };
+
+        triangleRasterizer.ForEachCoveredSpan([&](int x, int y, SpanMask coverageMask, const double* u, const double* v){
+            double depth[SPAN_WIDTH];
+            SpanMask mask = attrInterpolation.InterpolateDepthSpan(u, v, coverageMask, depth);
+            if (mask) mask = pixelSink.DepthTestSpan(x, y, depth, mask);
+            if (!mask) return;
+
+            fragmentSpan.count = 0;
+            for (int lane = 0; lane < SPAN_WIDTH; ++lane){
+                if (!(mask & (SpanMask{1} << lane))) continue;
+
+                InterpolatedFragment& fragment = fragmentSpan.fragments[fragmentSpan.count++];
+                fragment.interpolatedPoint = InterpolationPoint{x + lane, y, depth[lane]};
+                attrInterpolation.InterpolateAttributes(u[lane], v[lane], fragment);
+            }
+
+            ScopedStageTimer shadingTimer(profilingStats, RENDER_STAGE::SHADING);
+            if constexpr (std::is_invocable_v<FragmentShader, const InterpolatedFragmentSpan&, ShadeColor*>){
+                ShadeColor shadeColors[SPAN_WIDTH];
+                fragmentShader(fragmentSpan, shadeColors);
+
+                for (int idx = 0; idx < fragmentSpan.count; ++idx){
+                    pixelSink.DrawShadedPixel({fragmentSpan.fragments[idx].interpolatedPoint, shadeColors[idx]});
+                }
+            } else {
+                for (int idx = 0; idx < fragmentSpan.count; ++idx){
+                    const InterpolatedFragment& fragment = fragmentSpan.fragments[idx];
+                    pixelSink.DrawShadedPixel({fragment.interpolatedPoint, fragmentShader(fragment)});
+                }
+            }
+        }, blockFilter);
+    }
+
     class NoShading : public ShadingModel {
     public:
         NoShading() = default;
         virtual ~NoShading() = default;
 
         //------
-        virtual std::vector<ShadedPixel>
-        GetShadedPixels
+        virtual void
+        ShadeTriangle
         (
                 const ViewportPoint&, const ViewportPoint&, const ViewportPoint&,
-                const Polygon&,
+                const SourceVertexWeights&,
+                const TriangleRasterizer&,
+                size_t,
                 const SceneData&,
                 std::array<uchar, 4>,
                 const std::vector<std::shared_ptr<LightSource>>&,
-                const glm::mat4&, const glm::mat4&
+                const TransformedVertices&,
+                ShadedPixelSink&
         ) const override;
         //------
     };
@@ -104,34 +154,31 @@ namespace pv {
         virtual ~LambertianShading() = default;
 
         //------
-        virtual std::vector<ShadedPixel>
-        GetShadedPixels
+        virtual void
+        ShadeTriangle
         (
                 const ViewportPoint&, const ViewportPoint&, const ViewportPoint&,
-                const Polygon&,
+                const SourceVertexWeights&,
+                const TriangleRasterizer&,
+                size_t,
                 const SceneData&,
                 std::array<uchar, 4>,
                 const std::vector<std::shared_ptr<LightSource>>&,
-                const glm::mat4&, const glm::mat4&
+                const TransformedVertices&,
+                ShadedPixelSink&
         ) const override;
         //------
 
     private:
-        std::array<uchar, 4> GetShadeColor(const Polygon& polygon,
+        std::array<uchar, 4> GetShadeColor(size_t polygonIndex,
                                            const SceneData& sceneData,
                                            std::array<uchar, 4> materialColor,
                                            const LightSource& lightSource,
-                                           const glm::mat4 &model,
-                                           const glm::mat4 &view) const;
-
-        std::vector<glm::vec3> GetPolygonVertices(const std::vector<int>& vertexIndices, const std::vector<glm::vec3>& vertices) const;
-        std::vector<glm::vec3> GetPolygonVertexNormals(const std::vector<int>& normalIndices, const std::vector<glm::vec3>& normals) const;
-
-        glm::mat3 GetMatrix3x3(const glm::mat4& modelView) const;
+                                           const TransformedVertices& transformedVertices) const;
 
         std::array<uchar, 4> GetAverageMaterialLightColor(std::array<uchar, 4> materialColor, std::array<uchar, 4> lightColor) const;
 
-        std::array<uchar, 4> GetFinalAverageShade(const std::vector<std::array<uchar, 4>>& shades) const;
+        std::array<uchar, 4> GetFinalAverageShade(const std::array<std::array<uchar, 4>, 3>& shades) const;
     };
 
 
@@ -141,39 +188,42 @@ namespace pv {
         virtual ~PhongShading() = default;
 
         //------
-        virtual std::vector<ShadedPixel>
-        GetShadedPixels
+        virtual void
+        ShadeTriangle
         (
                 const ViewportPoint&, const ViewportPoint&, const ViewportPoint&,
-                const Polygon&,
+                const SourceVertexWeights&,
+                const TriangleRasterizer&,
+                size_t,
                 const SceneData&,
                 std::array<uchar, 4>,
                 const std::vector<std::shared_ptr<LightSource>>&,
-                const glm::mat4&, const glm::mat4&
+                const TransformedVertices&,
+                ShadedPixelSink&
         ) const override;
         //------
 
     private:
 
-        std::vector<glm::vec3> GetPolygonVertexNormals(const std::vector<int> &normalIndices,
-                                                       const std::vector<glm::vec3> &normals) const;
-
-        std::vector<glm::vec3> GetPolygonVertexTextureCoords(const std::vector<int> &textureIndices,
-                                                             const std::vector<glm::vec3> &vertexTextures) const;
+        std::array<VertexAttributes, 3> GetPolygonVertexAttributes(size_t polygonIndex,
+                                                                   const SceneData& sceneData,
+                                                                   const TransformedVertices& transformedVertices) const;
 
-        std::vector<glm::vec3> GetPolygonVerticesInCameraSpace(const std::vector<int> &vertexIndices,
-                                                               const std::vector<glm::vec3> &vertices,
-                                                               const glm::mat4& model,
-                                                               const glm::mat4& view) const;
+        void GetFragmentSpanShade(const InterpolatedFragmentSpan& fragmentSpan,
+                                  std::array<uchar, 4> materialColor,
+                                  const std::vector<std::shared_ptr<LightSource>>& lightSources,
+                                  const glm::mat4& view,
+                                  const glm::mat3& modelViewNormal,
+                                  ShadeColor* shadeColors) const;
 
-        glm::vec3 GetTextureNormal(glm::vec3&) const;
-        float GetTextureSpecular(glm::vec3&) const;
+        glm::vec3 GetTextureNormal(const glm::vec3&) const;
+        float GetTextureSpecular(const glm::vec3&) const;
 
         std::array<uchar, 4> GetAmbientShade(std::array<uchar, 4>) const;
-        std::array<uchar, 4> GetTextureAmbientShade(glm::vec3&) const;
+        std::array<uchar, 4> GetTextureAmbientShade(const glm::vec3&) const;
 
-        std::array<uchar, 4> GetDiffuseShade(const std::shared_ptr<LightSource>&, glm::vec3&, glm::vec3&) const;
-        std::array<uchar, 4> GetSpecularShade(const std::shared_ptr<LightSource>&, glm::vec3&, glm::vec3&, glm::vec3&) const;
+        std::array<uchar, 4> GetDiffuseShade(const std::shared_ptr<LightSource>&, float lambertTerm) const;
+        std::array<uchar, 4> GetSpecularShade(const std::shared_ptr<LightSource>&, float reflectionTerm) const;
     };
 
 } // namespace pv
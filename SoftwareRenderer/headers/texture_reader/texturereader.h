@@ -2,6 +2,7 @@
 #define TEXTUREREADER_H
 
 #include <QString>
+#include <memory>
 #include "headers/texturing/texture.h"
 
 namespace pv {
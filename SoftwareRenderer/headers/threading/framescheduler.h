@@ -0,0 +1,56 @@
+#ifndef PV_FRAMESCHEDULER_H
+#define PV_FRAMESCHEDULER_H
+
+#include <chrono>
+#include <cstddef>
+
+namespace pv {
+
+    // Paces frames to a target rate and keeps their cost inside its budget. Frames
+    // start no sooner than one frame period after the previous one, animations are
+    // advanced by the time that actually passed in between, and when frames take
+    // longer than the budget the render scale drops, in steps, until they fit again.
+    // The scale only comes back up once the larger frame is predicted to fit.
+    class FrameScheduler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit FrameScheduler(double targetFps = 60.0);
+
+        void SetTargetFps(double targetFps);
+        double GetTargetFps() const;
+        double GetFrameBudgetMs() const;
+
+        void SetAdaptiveResolution(bool adaptiveResolution);
+
+        // When the next frame should start; in the past if it is already due.
+        Clock::time_point GetNextFrameTime() const;
+
+        // Marks the start of a frame and returns the animation time since the
+        // previous one, capped so that a stall does not make animations jump.
+        float BeginFrame(Clock::time_point frameStart);
+
+        // Feeds back how long the frame took to render at the current scale.
+        void EndFrame(double renderMs);
+
+        // Fraction of the full resolution, per axis, the next frame renders at.
+        float GetRenderScale() const;
+        size_t GetScaledSize(size_t fullSize) const;
+
+    private:
+        void ChangeRenderScale(float renderScale);
+
+        double target_fps_;
+        bool adaptive_resolution_;
+
+        bool frame_started_;
+        Clock::time_point last_frame_start_;
+
+        float render_scale_;
+        double smoothed_render_ms_;
+        size_t frames_at_scale_;
+    };
+
+} // namespace pv
+
+#endif // PV_FRAMESCHEDULER_H
@@ -0,0 +1,111 @@
+#ifndef PV_RENDERTHREAD_H
+#define PV_RENDERTHREAD_H
+
+#include "headers/rendering/renderingpipeline.h"
+#include "headers/threading/framescheduler.h"
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pv {
+
+    // Owns a pipeline and renders with it on a dedicated thread. Other threads never
+    // touch the pipeline directly: they post commands, which are applied in order
+    // right before the next frame starts. Frames go through three image buffers, so
+    // the renderer can start a new frame while the newest finished one is waiting to
+    // be presented and an older one is still being displayed.
+    //
+    // A FrameScheduler paces the frames and may render them below the full size to
+    // stay within the frame budget; the presenter scales such frames up. Once the
+    // renderer goes idle after a reduced frame, it renders one more at full size.
+    class RenderThread {
+    public:
+        using Command = std::function<void(RenderingPipeline&)>;
+        using FrameReadyCallback = std::function<void()>;
+
+        // frameReady is called from the render thread after every finished frame.
+        RenderThread(const SceneData& sceneData, size_t width, size_t height, FrameReadyCallback frameReady);
+        ~RenderThread();
+
+        void Post(Command command);
+        void RequestFrame();
+
+        // Keeps rendering frames back to back without waiting for commands.
+        void SetContinuousRendering(bool continuousRendering);
+
+        void SetTargetFps(double targetFps);
+        void SetAdaptiveResolution(bool adaptiveResolution);
+
+        // Runs task on the calling thread while no frame is being rendered, for
+        // changes to data the pipeline only references, like the scene. The
+        // pipeline's clusters of the scene are rebuilt afterwards.
+        void RunBetweenFrames(const std::function<void()>& task);
+
+        // Makes the newest finished frame the presented one. Returns false when no
+        // frame finished since the last call; rethrows what a frame threw.
+        bool AcquireLatestFrame();
+
+        // Valid until the next AcquireLatestFrame call. The image holds
+        // GetPresentedWidth() * GetPresentedHeight() pixels, at most the full size.
+        const uchar* GetPresentedImage() const;
+        size_t GetPresentedWidth() const;
+        size_t GetPresentedHeight() const;
+        const RenderStats& GetPresentedStats() const;
+
+        RenderThread(const RenderThread&) = delete;
+        RenderThread(RenderThread&&) = delete;
+
+        RenderThread& operator=(const RenderThread&) = delete;
+        RenderThread& operator=(RenderThread&&) = delete;
+
+    private:
+        struct FrameSlot {
+            std::vector<uchar> image;
+            size_t width = 0;
+            size_t height = 0;
+            RenderStats stats;
+        };
+
+        void RenderLoop();
+        void RenderFrame(std::vector<Command>& commands, bool refinementFrame);
+
+        RenderingPipeline pipeline_;
+        const size_t width_;
+        const size_t height_;
+        const FrameReadyCallback frame_ready_;
+
+        // Only used by the render thread.
+        FrameScheduler frame_scheduler_;
+        bool refinement_pending_;
+
+        std::mutex mutex_;
+        std::condition_variable work_available_;
+        std::vector<Command> pending_commands_;
+        bool frame_requested_;
+        bool continuous_rendering_;
+        bool stopping_;
+        std::exception_ptr frame_exception_;
+        double target_fps_;
+        bool adaptive_resolution_;
+        bool frame_pacing_changed_;
+
+        // Held for a whole frame, commands included.
+        std::mutex pipeline_mutex_;
+
+        std::array<FrameSlot, 3> frame_slots_;
+        size_t rendered_slot_;
+        size_t ready_slot_;
+        size_t presented_slot_;
+        bool ready_slot_is_new_;
+
+        std::thread render_thread_;
+    };
+
+} // namespace pv
+
+#endif // PV_RENDERTHREAD_H
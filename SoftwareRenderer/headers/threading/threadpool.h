@@ -0,0 +1,58 @@
+#ifndef PV_THREADPOOL_H
+#define PV_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pv {
+
+    // Fixed set of workers that execute index-based tasks. The calling thread takes part
+    // in ParallelFor and the call returns once every index has been processed.
+    // ParallelFor must not be called from inside one of its own tasks.
+    class ThreadPool {
+    public:
+        using Task = std::function<void(size_t)>;
+
+        explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        size_t GetThreadCount() const;
+
+        void ParallelFor(size_t taskCount, const Task& task);
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool(ThreadPool&&) = delete;
+
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ThreadPool& operator=(ThreadPool&&) = delete;
+
+    private:
+        void WorkerLoop();
+        void RunPendingTasks();
+
+        std::vector<std::thread> workers_;
+
+        std::mutex mutex_;
+        std::condition_variable work_available_;
+        std::condition_variable work_finished_;
+
+        const Task* current_task_;
+        size_t task_count_;
+        std::atomic<size_t> next_task_index_;
+        size_t busy_workers_;
+        uint64_t generation_;
+        bool stopping_;
+
+        std::exception_ptr first_exception_;
+    };
+
+} // namespace pv
+
+#endif // PV_THREADPOOL_H
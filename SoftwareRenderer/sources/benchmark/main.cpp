@@ -0,0 +1,539 @@
+#include "headers/object_file_parser/objectfileparser.h"
+#include "headers/rendering/renderingpipeline.h"
+#include "headers/rendering/spankernels.h"
+#include "headers/texturing/texturingmode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace pv {
+
+    // Fixed scenes, cameras and settings rendered with every shading model and
+    // texturing mode; prints one JSON document so runs can be diffed over time.
+    // Frames are not animated, every frame of a case renders the same image.
+    struct BenchmarkOptions {
+        string objPath;
+        bool applyYZAxesFix = true;
+
+        size_t width = 1280;
+        size_t height = 720;
+        size_t frameCount = 30;
+        size_t warmupFrameCount = 3;
+        string filter;
+        string outputPath;
+    };
+
+    struct BenchmarkScene {
+        string name;
+        SceneData sceneData;
+        float modelScale;
+        float cameraAzimuthDegrees;
+        float cameraInclinationDegrees;
+    };
+
+    struct BenchmarkCase {
+        const BenchmarkScene* scene;
+        SHADING_MODEL shadingModel;
+        TexturingMode texturingMode;
+    };
+
+    struct BenchmarkResult {
+        string name;
+        const BenchmarkCase* benchmarkCase;
+        size_t sceneTriangles;
+        vector<double> frameMs;
+        RenderStats meanStats;
+        RenderStats profiledStats;
+    };
+
+    // Scenes are scaled to roughly the same on-screen size; with the default
+    // camera distance a model radius of 0.6 spans about two thirds of the frame height.
+    constexpr float SCREEN_FILLING_RADIUS = 0.6F;
+
+    constexpr size_t SPHERE_STACKS = 256;
+    constexpr size_t SPHERE_SLICES = 512;
+    constexpr size_t PLANE_QUADS_PER_SIDE = 384;
+    constexpr size_t TEXTURE_SIZE = 512;
+
+    void PrintUsage(const char* programName) {
+        cout << "Usage: " << programName << " [options]\n"
+                "\n"
+                "  --obj FILE           add a high-poly Wavefront OBJ scene\n"
+                "  --no-yz-fix          keep the OBJ model's Y and Z axes as they are\n"
+                "  --size WIDTHxHEIGHT  frame size (default 1280x720)\n"
+                "  --frames N           measured frames per case (default 30)\n"
+                "  --warmup N           unmeasured frames per case (default 3)\n"
+                "  --filter TEXT        only run cases whose name contains TEXT\n"
+                "  --output FILE        write the JSON report to FILE instead of stdout\n";
+    }
+
+    size_t ParseCount(const string& value, const string& option) {
+        try {
+            size_t parsedLength = 0;
+            const unsigned long result = stoul(value, &parsedLength);
+            if (parsedLength == value.size() && value[0] != '-') return result;
+        } catch (const logic_error&) { }
+
+        throw runtime_error("Invalid count '" + value + "' for " + option);
+    }
+
+    BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+        BenchmarkOptions options;
+
+        for (int argIndex = 1; argIndex < argc; ++argIndex){
+            const string option = argv[argIndex];
+
+            const auto nextValue = [&]() -> string {
+                if (argIndex + 1 >= argc) throw runtime_error("Missing value for " + option);
+                return argv[++argIndex];
+            };
+
+            if      (option == "--obj")       options.objPath = nextValue();
+            else if (option == "--no-yz-fix") options.applyYZAxesFix = false;
+            else if (option == "--frames")    options.frameCount = ParseCount(nextValue(), option);
+            else if (option == "--warmup")    options.warmupFrameCount = ParseCount(nextValue(), option);
+            else if (option == "--filter")    options.filter = nextValue();
+            else if (option == "--output")    options.outputPath = nextValue();
+            else if (option == "--size"){
+                const string size = nextValue();
+                const size_t separator = size.find('x');
+                if (separator == string::npos) throw runtime_error("Expected WIDTHxHEIGHT for --size");
+                options.width = ParseCount(size.substr(0, separator), option);
+                options.height = ParseCount(size.substr(separator + 1), option);
+                if (options.width == 0 || options.height == 0) throw runtime_error("Frame size must not be empty");
+            }
+            else if (option == "--help" || option == "-h"){
+                PrintUsage(argv[0]);
+                exit(0);
+            }
+            else throw runtime_error("Unknown option " + option);
+        }
+
+        if (options.frameCount == 0){
+            throw runtime_error("At least one measured frame is needed");
+        }
+
+        return options;
+    }
+
+    void AddTriangle(SceneData& sceneData, int first, int second, int third) {
+        sceneData.vertex_indices.insert(sceneData.vertex_indices.end(), { first, second, third });
+        sceneData.EndPolygon();
+    }
+
+    // Unit UV sphere.
+    SceneData GetSphereSceneData(size_t stacks, size_t slices) {
+        SceneData sceneData;
+
+        for (size_t stack = 0; stack <= stacks; ++stack){
+            const float theta = static_cast<float>(M_PI * stack / stacks);
+
+            for (size_t slice = 0; slice <= slices; ++slice){
+                const float phi = static_cast<float>(2.0 * M_PI * slice / slices);
+                const glm::vec3 point { sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta) };
+
+                sceneData.vertices.push_back(point);
+                sceneData.vertex_normals.push_back(point);
+                sceneData.vertex_textures.push_back({ static_cast<float>(slice) / slices,
+                                                      static_cast<float>(stack) / stacks, 0.0F });
+            }
+        }
+
+        const auto vertexIndex = [slices](size_t stack, size_t slice){
+            return static_cast<int>(stack * (slices + 1) + slice);
+        };
+
+        for (size_t stack = 0; stack < stacks; ++stack){
+            for (size_t slice = 0; slice < slices; ++slice){
+                AddTriangle(sceneData, vertexIndex(stack, slice), vertexIndex(stack + 1, slice), vertexIndex(stack + 1, slice + 1));
+                AddTriangle(sceneData, vertexIndex(stack, slice), vertexIndex(stack + 1, slice + 1), vertexIndex(stack, slice + 1));
+            }
+        }
+
+        return sceneData;
+    }
+
+    // Square of side 2 in the XY plane facing +Z, split into quadsPerSide^2 quads.
+    SceneData GetPlaneSceneData(size_t quadsPerSide) {
+        SceneData sceneData;
+
+        for (size_t row = 0; row <= quadsPerSide; ++row){
+            for (size_t column = 0; column <= quadsPerSide; ++column){
+                const float s = static_cast<float>(column) / quadsPerSide;
+                const float t = static_cast<float>(row) / quadsPerSide;
+
+                sceneData.vertices.push_back({ 2.0F * s - 1.0F, 2.0F * t - 1.0F, 0.0F });
+                sceneData.vertex_normals.push_back({ 0.0F, 0.0F, 1.0F });
+                sceneData.vertex_textures.push_back({ s, t, 0.0F });
+            }
+        }
+
+        const auto vertexIndex = [quadsPerSide](size_t row, size_t column){
+            return static_cast<int>(row * (quadsPerSide + 1) + column);
+        };
+
+        for (size_t row = 0; row < quadsPerSide; ++row){
+            for (size_t column = 0; column < quadsPerSide; ++column){
+                AddTriangle(sceneData, vertexIndex(row, column), vertexIndex(row, column + 1), vertexIndex(row + 1, column + 1));
+                AddTriangle(sceneData, vertexIndex(row, column), vertexIndex(row + 1, column + 1), vertexIndex(row + 1, column));
+            }
+        }
+
+        return sceneData;
+    }
+
+    // Around the model origin, which is what the camera orbits.
+    float GetBoundingRadius(const SceneData& sceneData) {
+        float radius = 0.0F;
+        for (const glm::vec3& vertex : sceneData.vertices){
+            radius = max(radius, glm::length(vertex));
+        }
+        return radius;
+    }
+
+    size_t GetSceneTriangleCount(const SceneData& sceneData) {
+        size_t triangleCount = 0;
+        for (size_t polygonIndex = 0; polygonIndex < sceneData.GetPolygonCount(); ++polygonIndex){
+            const size_t cornerCount = sceneData.GetCornerCount(polygonIndex);
+            if (cornerCount >= 3) triangleCount += cornerCount - 2;
+        }
+        return triangleCount;
+    }
+
+    vector<BenchmarkScene> GetBenchmarkScenes(const BenchmarkOptions& options) {
+        vector<BenchmarkScene> scenes;
+        scenes.push_back({ "sphere", GetSphereSceneData(SPHERE_STACKS, SPHERE_SLICES), SCREEN_FILLING_RADIUS, 20.0F, 30.0F });
+        scenes.push_back({ "plane", GetPlaneSceneData(PLANE_QUADS_PER_SIDE), SCREEN_FILLING_RADIUS, 0.0F, -40.0F });
+
+        if (!options.objPath.empty()){
+            ObjectFileParser objectFileParser;
+            objectFileParser.SetDoApplyYZAxesFix(options.applyYZAxesFix);
+            SceneData sceneData = objectFileParser.GetSceneDataFromObjectFile(options.objPath);
+            if (sceneData.vertices.empty() || sceneData.GetPolygonCount() == 0){
+                throw runtime_error("No geometry found in " + options.objPath);
+            }
+
+            const float radius = GetBoundingRadius(sceneData);
+            const float modelScale = radius > 0.0F ? SCREEN_FILLING_RADIUS / radius : 1.0F;
+            scenes.push_back({ "obj_" + filesystem::path(options.objPath).stem().string(),
+                               std::move(sceneData), modelScale, 30.0F, 15.0F });
+        }
+
+        return scenes;
+    }
+
+    vector<BenchmarkCase> GetBenchmarkCases(const vector<BenchmarkScene>& scenes) {
+        vector<BenchmarkCase> cases;
+
+        for (const BenchmarkScene& scene : scenes){
+            cases.push_back({ &scene, SHADING_MODEL::NO_SHADING, TexturingMode::NO_TEXTURE });
+
+            if (scene.sceneData.vertex_normals.empty()) continue;
+            cases.push_back({ &scene, SHADING_MODEL::LAMBERTIAN_SHADING, TexturingMode::NO_TEXTURE });
+            cases.push_back({ &scene, SHADING_MODEL::PHONG_SHADING, TexturingMode::NO_TEXTURE });
+
+            // Only Phong samples textures.
+            if (scene.sceneData.vertex_textures.empty()) continue;
+            cases.push_back({ &scene, SHADING_MODEL::PHONG_SHADING, TexturingMode::DIFFUSE });
+            cases.push_back({ &scene, SHADING_MODEL::PHONG_SHADING, TexturingMode::DIFFUSE_NORMAL });
+            cases.push_back({ &scene, SHADING_MODEL::PHONG_SHADING, TexturingMode::DIFFUSE_NORMAL_SPECULAR });
+        }
+
+        return cases;
+    }
+
+    const char* GetShadingModelName(SHADING_MODEL shadingModel) {
+        switch (shadingModel){
+            case SHADING_MODEL::NO_SHADING:         return "none";
+            case SHADING_MODEL::LAMBERTIAN_SHADING: return "lambertian";
+            case SHADING_MODEL::PHONG_SHADING:      return "phong";
+        }
+        return "unknown";
+    }
+
+    const char* GetTexturingModeName(TexturingMode texturingMode) {
+        switch (texturingMode){
+            case TexturingMode::NO_TEXTURE:              return "none";
+            case TexturingMode::DIFFUSE:                 return "diffuse";
+            case TexturingMode::DIFFUSE_NORMAL:          return "diffuse_normal";
+            case TexturingMode::DIFFUSE_NORMAL_SPECULAR: return "diffuse_normal_specular";
+        }
+        return "unknown";
+    }
+
+    const char* GetSimdLevelName(SIMD_LEVEL simdLevel) {
+        switch (simdLevel){
+            case SIMD_LEVEL::SCALAR: return "scalar";
+            case SIMD_LEVEL::SSE2:   return "sse2";
+            case SIMD_LEVEL::AVX2:   return "avx2";
+        }
+        return "unknown";
+    }
+
+    string GetCaseName(const BenchmarkCase& benchmarkCase) {
+        return benchmarkCase.scene->name + "/" +
+               GetShadingModelName(benchmarkCase.shadingModel) + "/" +
+               GetTexturingModeName(benchmarkCase.texturingMode);
+    }
+
+    // Procedural textures, so results do not depend on files next to the binary.
+    TextureHolder GetCheckerTexture() {
+        constexpr size_t CHECKER_SIZE = 32;
+        auto texture = make_unique<Texture>(TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_COLOR_MODEL::RGB24);
+
+        vector<uchar> texels(TEXTURE_SIZE * TEXTURE_SIZE * 3);
+        for (size_t y = 0; y < TEXTURE_SIZE; ++y){
+            for (size_t x = 0; x < TEXTURE_SIZE; ++x){
+                const bool light = ((x / CHECKER_SIZE) + (y / CHECKER_SIZE)) % 2 == 0;
+                uchar* texel = &texels[(x + y * TEXTURE_SIZE) * 3];
+                texel[0] = light ? 230 : 40;
+                texel[1] = light ? 200 : 90;
+                texel[2] = light ? 120 : 160;
+            }
+        }
+        texture->SaveTexture(texels.data());
+
+        return texture;
+    }
+
+    TextureHolder GetBumpNormalTexture() {
+        constexpr double BUMP_FREQUENCY = 24.0 * M_PI / TEXTURE_SIZE;
+        auto texture = make_unique<Texture>(TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_COLOR_MODEL::RGB24);
+
+        vector<uchar> texels(TEXTURE_SIZE * TEXTURE_SIZE * 3);
+        for (size_t y = 0; y < TEXTURE_SIZE; ++y){
+            for (size_t x = 0; x < TEXTURE_SIZE; ++x){
+                const glm::vec3 normal = glm::normalize(glm::vec3{ 0.4 * sin(x * BUMP_FREQUENCY),
+                                                                   0.4 * sin(y * BUMP_FREQUENCY),
+                                                                   1.0 });
+                uchar* texel = &texels[(x + y * TEXTURE_SIZE) * 3];
+                for (int component = 0; component < 3; ++component){
+                    texel[component] = static_cast<uchar>(lround((normal[component] * 0.5 + 0.5) * 255.0));
+                }
+            }
+        }
+        texture->SaveTexture(texels.data());
+
+        return texture;
+    }
+
+    TextureHolder GetStripeSpecularTexture() {
+        constexpr size_t STRIPE_WIDTH = 16;
+        auto texture = make_unique<Texture>(TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_COLOR_MODEL::MONO8);
+
+        vector<uchar> texels(TEXTURE_SIZE * TEXTURE_SIZE);
+        for (size_t y = 0; y < TEXTURE_SIZE; ++y){
+            for (size_t x = 0; x < TEXTURE_SIZE; ++x){
+                texels[x + y * TEXTURE_SIZE] = ((x + y) / STRIPE_WIDTH) % 2 == 0 ? 255 : 32;
+            }
+        }
+        texture->SaveTexture(texels.data());
+
+        return texture;
+    }
+
+    void ConfigurePipeline(RenderingPipeline& pipeline, const BenchmarkCase& benchmarkCase) {
+        const BenchmarkScene& scene = *benchmarkCase.scene;
+
+        pipeline.SetRasterizePolygons(true);
+        pipeline.SetEnableZBuffering(true);
+        pipeline.SetModelScaleFactor(scene.modelScale);
+        pipeline.SetAnimationType(ANIMATION_TYPE::NO_ANIMATION);
+
+        pipeline.SetZCameraView();
+        pipeline.RotateCamera(scene.cameraAzimuthDegrees, scene.cameraInclinationDegrees);
+
+        auto keyLight = make_shared<LightSource>();
+        keyLight->UpdateLightSourcePosition(45.0F);
+        auto fillLight = make_shared<LightSource>();
+        fillLight->UpdateLightSourcePosition(200.0F);
+        fillLight->SetLightColor({ 255, 90, 110, 160 });
+        pipeline.SetLightSources({ keyLight, fillLight });
+
+        pipeline.SetShadingModelType(benchmarkCase.shadingModel);
+
+        const TexturingMode texturingMode = benchmarkCase.texturingMode;
+        if (texturingMode != TexturingMode::NO_TEXTURE){
+            pipeline.SetDiffuseTexture(GetCheckerTexture());
+            pipeline.SetEnableDiffuseTexturing(true);
+        }
+        if (texturingMode == TexturingMode::DIFFUSE_NORMAL || texturingMode == TexturingMode::DIFFUSE_NORMAL_SPECULAR){
+            pipeline.SetNormalTexture(GetBumpNormalTexture());
+            pipeline.SetEnableNormalTexturing(true);
+        }
+        if (texturingMode == TexturingMode::DIFFUSE_NORMAL_SPECULAR){
+            pipeline.SetSpecularTexture(GetStripeSpecularTexture());
+            pipeline.SetEnableSpecularTexturing(true);
+        }
+    }
+
+    BenchmarkResult RunBenchmarkCase(const BenchmarkCase& benchmarkCase, const BenchmarkOptions& options) {
+        RenderingPipeline pipeline(benchmarkCase.scene->sceneData);
+        ConfigurePipeline(pipeline, benchmarkCase);
+
+        vector<uchar> frameImage(options.width * options.height * 4);
+        for (size_t frameIndex = 0; frameIndex < options.warmupFrameCount; ++frameIndex){
+            pipeline.DoRender(options.width, options.height, frameImage.data(), frameIndex > 0);
+        }
+
+        BenchmarkResult result { GetCaseName(benchmarkCase), &benchmarkCase,
+                                 GetSceneTriangleCount(benchmarkCase.scene->sceneData), {}, {}, {} };
+        result.frameMs.reserve(options.frameCount);
+
+        for (size_t frameIndex = 0; frameIndex < options.frameCount; ++frameIndex){
+            pipeline.DoRender(options.width, options.height, frameImage.data(),
+                              options.warmupFrameCount > 0 || frameIndex > 0);
+
+            const RenderStats& frameStats = pipeline.GetLastFrameStats();
+            result.frameMs.push_back(frameStats.frameMs);
+            result.meanStats.Merge(frameStats);
+        }
+
+        const double frameCount = static_cast<double>(options.frameCount);
+        result.meanStats.frameMs /= frameCount;
+        for (double& stageMs : result.meanStats.stageMs){
+            stageMs /= frameCount;
+        }
+
+        // Detailed profiling slows the frame down, so it gets one frame of its
+        // own after the measured ones: the stage split and counters come from it.
+        pipeline.SetEnableDetailedProfiling(true);
+        pipeline.DoRender(options.width, options.height, frameImage.data(), true);
+        result.profiledStats = pipeline.GetLastFrameStats();
+
+        return result;
+    }
+
+    string GetJsonString(const string& value) {
+        string quoted = "\"";
+        for (char character : value){
+            if (character == '"' || character == '\\') quoted += '\\';
+            if (static_cast<unsigned char>(character) < 0x20) continue;
+            quoted += character;
+        }
+        return quoted + "\"";
+    }
+
+    string GetJsonNumber(double value) {
+        char number[32];
+        snprintf(number, sizeof(number), "%.4f", value);
+        return number;
+    }
+
+    string GetJsonKey(const char* name) {
+        string key = name;
+        replace(key.begin(), key.end(), ' ', '_');
+        return GetJsonString(key);
+    }
+
+    string GetJsonStageTimes(const RenderStats& renderStats) {
+        string stageTimes = "{ ";
+        for (size_t stage = 0; stage < RENDER_STAGE_COUNT; ++stage){
+            stageTimes += GetJsonKey(RenderStats::GetStageName(static_cast<RENDER_STAGE>(stage))) + ": " +
+                          GetJsonNumber(renderStats.stageMs[stage]) + (stage + 1 < RENDER_STAGE_COUNT ? ", " : " }");
+        }
+        return stageTimes;
+    }
+
+    string GetJsonCounters(const RenderStats& renderStats) {
+        string counters = "{ ";
+        for (size_t counter = 0; counter < RENDER_COUNTER_COUNT; ++counter){
+            counters += GetJsonKey(RenderStats::GetCounterName(static_cast<RENDER_COUNTER>(counter))) + ": " +
+                        to_string(renderStats.counters[counter]) + (counter + 1 < RENDER_COUNTER_COUNT ? ", " : " }");
+        }
+        return counters;
+    }
+
+    void WriteJsonReport(ostream& output, const BenchmarkOptions& options, const vector<BenchmarkResult>& results) {
+        output << "{\n"
+               << "  \"width\": " << options.width << ",\n"
+               << "  \"height\": " << options.height << ",\n"
+               << "  \"frames\": " << options.frameCount << ",\n"
+               << "  \"warmup_frames\": " << options.warmupFrameCount << ",\n"
+               << "  \"threads\": " << thread::hardware_concurrency() << ",\n"
+               << "  \"simd\": " << GetJsonString(GetSimdLevelName(GetSupportedSimdLevel())) << ",\n"
+               << "  \"results\": [";
+
+        for (size_t resultIndex = 0; resultIndex < results.size(); ++resultIndex){
+            const BenchmarkResult& result = results[resultIndex];
+            const RenderStats& meanStats = result.meanStats;
+
+            vector<double> sortedFrameMs = result.frameMs;
+            sort(sortedFrameMs.begin(), sortedFrameMs.end());
+            const double medianMs = sortedFrameMs[sortedFrameMs.size() / 2];
+            const double meanSeconds = meanStats.frameMs / 1000.0;
+
+            output << (resultIndex > 0 ? "," : "") << "\n"
+                   << "    {\n"
+                   << "      \"name\": " << GetJsonString(result.name) << ",\n"
+                   << "      \"scene\": " << GetJsonString(result.benchmarkCase->scene->name) << ",\n"
+                   << "      \"shading\": " << GetJsonString(GetShadingModelName(result.benchmarkCase->shadingModel)) << ",\n"
+                   << "      \"texturing\": " << GetJsonString(GetTexturingModeName(result.benchmarkCase->texturingMode)) << ",\n"
+                   << "      \"scene_triangles\": " << result.sceneTriangles << ",\n"
+                   << "      \"frame_ms\": { "
+                   <<          "\"mean\": " << GetJsonNumber(meanStats.frameMs) << ", "
+                   <<          "\"median\": " << GetJsonNumber(medianMs) << ", "
+                   <<          "\"min\": " << GetJsonNumber(sortedFrameMs.front()) << ", "
+                   <<          "\"max\": " << GetJsonNumber(sortedFrameMs.back()) << " },\n"
+                   << "      \"stage_mean_ms\": " << GetJsonStageTimes(meanStats) << ",\n"
+                   << "      \"profiled_frame\": {\n"
+                   << "        \"frame_ms\": " << GetJsonNumber(result.profiledStats.frameMs) << ",\n"
+                   << "        \"stage_ms\": " << GetJsonStageTimes(result.profiledStats) << ",\n"
+                   << "        \"counters\": " << GetJsonCounters(result.profiledStats) << "\n"
+                   << "      },\n"
+                   << "      \"triangles_per_second\": " << GetJsonNumber(result.sceneTriangles / meanSeconds) << ",\n"
+                   << "      \"pixels_per_second\": " << GetJsonNumber(options.width * options.height / meanSeconds) << "\n"
+                   << "    }";
+        }
+
+        output << "\n  ]\n}\n";
+    }
+
+} // namespace pv
+
+int main(int argc, char *argv[])
+{
+    using namespace pv;
+
+    try {
+        const BenchmarkOptions options = ParseOptions(argc, argv);
+        const vector<BenchmarkScene> scenes = GetBenchmarkScenes(options);
+        const vector<BenchmarkCase> cases = GetBenchmarkCases(scenes);
+
+        vector<BenchmarkResult> results;
+        for (const BenchmarkCase& benchmarkCase : cases){
+            const string caseName = GetCaseName(benchmarkCase);
+            if (caseName.find(options.filter) == string::npos) continue;
+
+            cerr << caseName << "..." << flush;
+            results.push_back(RunBenchmarkCase(benchmarkCase, options));
+            cerr << " " << results.back().meanStats.frameMs << " ms/frame" << endl;
+        }
+
+        if (options.outputPath.empty()){
+            WriteJsonReport(cout, options, results);
+        } else {
+            ofstream output(options.outputPath);
+            if (!output) throw runtime_error("Cannot open " + options.outputPath + " for writing");
+            WriteJsonReport(output, options, results);
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        cerr << "Run with --help for usage." << endl;
+        return 1;
+    }
+
+    return 0;
+}
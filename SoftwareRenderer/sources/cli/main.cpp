@@ -0,0 +1,389 @@
+#include "headers/image_writer/ppmwriter.h"
+#include "headers/object_file_parser/objectfileparser.h"
+#include "headers/rendering/renderingpipeline.h"
+#include "headers/texture_reader/bmpreader.h"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace pv {
+
+    // Headless front end: renders an OBJ with the same pipeline as the GUI and
+    // writes every frame as a PPM file, so it runs on machines without a display.
+    struct LightOptions {
+        float azimuthDegrees;
+        std::array<uchar, 4> argbColor;
+        float specularPower;
+    };
+
+    struct RenderOptions {
+        string objPath;
+        bool applyYZAxesFix = true;
+        bool useMeshCache = true;
+
+        bool streamMesh = false;
+        size_t trianglesPerChunk = StreamedMesh::DEFAULT_TRIANGLES_PER_CHUNK;
+        size_t memoryBudgetMegabytes = 512;
+
+        string diffuseTexturePath;
+        string normalTexturePath;
+        string specularTexturePath;
+
+        SHADING_MODEL shadingModel = SHADING_MODEL::PHONG_SHADING;
+        ANIMATION_TYPE animationType = ANIMATION_TYPE::NO_ANIMATION;
+        vector<LightOptions> lights;
+
+        optional<char> cameraView;
+        float cameraAzimuthDegrees = 0.0F;
+        float cameraInclinationDegrees = 0.0F;
+        optional<float> orbitDistance;
+        optional<float> fovyDegrees;
+        optional<float> nearPlane;
+        optional<float> farPlane;
+        float modelScale = 1.0F;
+
+        size_t width = 800;
+        size_t height = 600;
+        size_t frameCount = 1;
+        float framesPerSecond = 60.0F;
+        string outputDirectory = ".";
+
+        bool drawPolygonMesh = false;
+        bool drawWorldAxes = false;
+        bool zBuffering = true;
+        bool backfaceCulling = false;
+        bool depthPrepass = false;
+        DEPTH_FORMAT depthFormat = DEPTH_FORMAT::FLOAT64;
+    };
+
+    void PrintUsage(const char* programName) {
+        cout << "Usage: " << programName << " --obj FILE [options]\n"
+                "\n"
+                "Scene:\n"
+                "  --obj FILE                       Wavefront OBJ model (required)\n"
+                "  --no-yz-fix                      keep the model's Y and Z axes as they are\n"
+                "  --no-mesh-cache                  neither read nor write FILE.pvmesh\n"
+                "  --stream                         render from spatial chunks in FILE.pvchunks, paging\n"
+                "                                   in the visible ones; the chunk file is made\n"
+                "                                   again unless it was made from the same FILE\n"
+                "                                   content, --no-yz-fix and --chunk-triangles\n"
+                "  --chunk-triangles N              triangles per chunk when making it (default 32768)\n"
+                "  --memory-budget MB               memory for resident chunks (default 512)\n"
+                "  --diffuse FILE                   24-bit BMP diffuse texture\n"
+                "  --normal FILE                    24-bit BMP normal map\n"
+                "  --specular FILE                  8-bit BMP specular map\n"
+                "  --shading none|lambertian|phong  shading model (default phong); models without\n"
+                "                                   vertex normals are drawn with none\n"
+                "  --light AZIMUTH[,R,G,B[,POWER]]  add a light source, repeatable (default one light)\n"
+                "  --scale FACTOR                   model scale factor (default 1)\n"
+                "  --animation none|x|y|z|carousel  model animation (default none)\n"
+                "\n"
+                "Camera:\n"
+                "  --view x|y|z                     look along one of the world axes\n"
+                "  --camera AZIMUTH,INCLINATION     orbit the camera by the given degrees\n"
+                "  --distance R                     orbit distance\n"
+                "  --fovy DEGREES, --near D, --far D\n"
+                "\n"
+                "Output:\n"
+                "  --size WIDTHxHEIGHT              frame size (default 800x600)\n"
+                "  --frames N                       number of frames to render (default 1)\n"
+                "  --fps RATE                       animation time between frames is 1/RATE s (default 60)\n"
+                "  --output DIR                     writes DIR/frame_0000.ppm, ... (default .)\n"
+                "\n"
+                "Rendering:\n"
+                "  --mesh, --axes                   draw the polygon mesh / world axes\n"
+                "  --no-zbuffer, --backface-culling, --depth-prepass\n"
+                "  --depth-format float64|float32|unorm24\n";
+    }
+
+    vector<string> SplitList(const string& value, char separator) {
+        vector<string> items;
+        stringstream stream(value);
+        string item;
+        while (getline(stream, item, separator)){
+            items.push_back(item);
+        }
+        return items;
+    }
+
+    float ParseFloat(const string& value, const string& option) {
+        try {
+            size_t parsedLength = 0;
+            const float result = stof(value, &parsedLength);
+            if (parsedLength == value.size()) return result;
+        } catch (const logic_error&) { }
+
+        throw runtime_error("Invalid number '" + value + "' for " + option);
+    }
+
+    size_t ParseCount(const string& value, const string& option) {
+        try {
+            size_t parsedLength = 0;
+            const unsigned long result = stoul(value, &parsedLength);
+            if (parsedLength == value.size() && value[0] != '-') return result;
+        } catch (const logic_error&) { }
+
+        throw runtime_error("Invalid count '" + value + "' for " + option);
+    }
+
+    SHADING_MODEL ParseShadingModel(const string& value) {
+        if (value == "none") return SHADING_MODEL::NO_SHADING;
+        if (value == "lambertian") return SHADING_MODEL::LAMBERTIAN_SHADING;
+        if (value == "phong") return SHADING_MODEL::PHONG_SHADING;
+        throw runtime_error("Unknown shading model '" + value + "'");
+    }
+
+    ANIMATION_TYPE ParseAnimationType(const string& value) {
+        if (value == "none") return ANIMATION_TYPE::NO_ANIMATION;
+        if (value == "x") return ANIMATION_TYPE::X_ROTATION;
+        if (value == "y") return ANIMATION_TYPE::Y_ROTATION;
+        if (value == "z") return ANIMATION_TYPE::Z_ROTATION;
+        if (value == "carousel") return ANIMATION_TYPE::CAROUSEL;
+        throw runtime_error("Unknown animation '" + value + "'");
+    }
+
+    DEPTH_FORMAT ParseDepthFormat(const string& value) {
+        if (value == "float64") return DEPTH_FORMAT::FLOAT64;
+        if (value == "float32") return DEPTH_FORMAT::FLOAT32_REVERSED_Z;
+        if (value == "unorm24") return DEPTH_FORMAT::UNORM24;
+        throw runtime_error("Unknown depth format '" + value + "'");
+    }
+
+    LightOptions ParseLight(const string& value) {
+        const vector<string> items = SplitList(value, ',');
+        if (items.size() != 1 && items.size() != 4 && items.size() != 5){
+            throw runtime_error("Expected AZIMUTH[,R,G,B[,POWER]] for --light, got '" + value + "'");
+        }
+
+        const LightSource defaultLight;
+        LightOptions light { ParseFloat(items[0], "--light"), defaultLight.GetLightColor(), defaultLight.GetSpecularPower() };
+
+        if (items.size() >= 4){
+            for (size_t component = 0; component < 3; ++component){
+                const size_t channel = ParseCount(items[component + 1], "--light");
+                if (channel > 255) throw runtime_error("Light color components must be within 0..255");
+                light.argbColor[component + 1] = static_cast<uchar>(channel);
+            }
+        }
+        if (items.size() == 5){
+            light.specularPower = ParseFloat(items[4], "--light");
+        }
+
+        return light;
+    }
+
+    RenderOptions ParseOptions(int argc, char* argv[]) {
+        RenderOptions options;
+
+        for (int argIndex = 1; argIndex < argc; ++argIndex){
+            const string option = argv[argIndex];
+
+            const auto nextValue = [&]() -> string {
+                if (argIndex + 1 >= argc) throw runtime_error("Missing value for " + option);
+                return argv[++argIndex];
+            };
+
+            if      (option == "--obj")              options.objPath = nextValue();
+            else if (option == "--no-yz-fix")        options.applyYZAxesFix = false;
+            else if (option == "--no-mesh-cache")    options.useMeshCache = false;
+            else if (option == "--stream")           options.streamMesh = true;
+            else if (option == "--chunk-triangles"){
+                options.trianglesPerChunk = ParseCount(nextValue(), option);
+                if (options.trianglesPerChunk == 0) throw runtime_error("Chunks must hold at least one triangle");
+            }
+            else if (option == "--memory-budget")    options.memoryBudgetMegabytes = ParseCount(nextValue(), option);
+            else if (option == "--diffuse")          options.diffuseTexturePath = nextValue();
+            else if (option == "--normal")           options.normalTexturePath = nextValue();
+            else if (option == "--specular")         options.specularTexturePath = nextValue();
+            else if (option == "--shading")          options.shadingModel = ParseShadingModel(nextValue());
+            else if (option == "--animation")        options.animationType = ParseAnimationType(nextValue());
+            else if (option == "--light")            options.lights.push_back(ParseLight(nextValue()));
+            else if (option == "--scale")            options.modelScale = ParseFloat(nextValue(), option);
+            else if (option == "--distance")         options.orbitDistance = ParseFloat(nextValue(), option);
+            else if (option == "--fovy")             options.fovyDegrees = ParseFloat(nextValue(), option);
+            else if (option == "--near")             options.nearPlane = ParseFloat(nextValue(), option);
+            else if (option == "--far")              options.farPlane = ParseFloat(nextValue(), option);
+            else if (option == "--frames")           options.frameCount = ParseCount(nextValue(), option);
+            else if (option == "--fps"){
+                options.framesPerSecond = ParseFloat(nextValue(), option);
+                if (!(options.framesPerSecond > 0.0F)) throw runtime_error("Frame rate must be positive");
+            }
+            else if (option == "--output")           options.outputDirectory = nextValue();
+            else if (option == "--mesh")             options.drawPolygonMesh = true;
+            else if (option == "--axes")             options.drawWorldAxes = true;
+            else if (option == "--no-zbuffer")       options.zBuffering = false;
+            else if (option == "--backface-culling") options.backfaceCulling = true;
+            else if (option == "--depth-prepass")    options.depthPrepass = true;
+            else if (option == "--depth-format")     options.depthFormat = ParseDepthFormat(nextValue());
+            else if (option == "--view"){
+                const string view = nextValue();
+                if (view != "x" && view != "y" && view != "z") throw runtime_error("Unknown view '" + view + "'");
+                options.cameraView = view[0];
+            }
+            else if (option == "--camera"){
+                const vector<string> angles = SplitList(nextValue(), ',');
+                if (angles.size() != 2) throw runtime_error("Expected AZIMUTH,INCLINATION for --camera");
+                options.cameraAzimuthDegrees = ParseFloat(angles[0], option);
+                options.cameraInclinationDegrees = ParseFloat(angles[1], option);
+            }
+            else if (option == "--size"){
+                const vector<string> size = SplitList(nextValue(), 'x');
+                if (size.size() != 2) throw runtime_error("Expected WIDTHxHEIGHT for --size");
+                options.width = ParseCount(size[0], option);
+                options.height = ParseCount(size[1], option);
+                if (options.width == 0 || options.height == 0) throw runtime_error("Frame size must not be empty");
+            }
+            else if (option == "--help" || option == "-h"){
+                PrintUsage(argv[0]);
+                exit(0);
+            }
+            else throw runtime_error("Unknown option " + option);
+        }
+
+        if (options.objPath.empty()){
+            throw runtime_error("No model given, use --obj FILE");
+        }
+        if (options.lights.empty()){
+            const LightSource defaultLight;
+            options.lights.push_back({ defaultLight.GetLightSourcePositionDegrees(),
+                                       defaultLight.GetLightColor(),
+                                       defaultLight.GetSpecularPower() });
+        }
+
+        return options;
+    }
+
+    void ConfigurePipeline(RenderingPipeline& pipeline, const RenderOptions& options, bool hasTextureCoords) {
+        pipeline.SetRasterizePolygons(true);
+        pipeline.SetDrawPolygonMesh(options.drawPolygonMesh);
+        pipeline.SetDrawWorldAxis(options.drawWorldAxes);
+        pipeline.SetEnableZBuffering(options.zBuffering);
+        pipeline.SetEnableBackfaceCulling(options.backfaceCulling);
+        pipeline.SetEnableDepthPrepass(options.depthPrepass);
+        pipeline.SetDepthFormat(options.depthFormat);
+
+        pipeline.SetShadingModelType(options.shadingModel);
+        pipeline.SetAnimationType(options.animationType);
+        pipeline.SetModelScaleFactor(options.modelScale);
+
+        if (options.fovyDegrees) pipeline.SetFOVYDegreeAngle(*options.fovyDegrees);
+        if (options.nearPlane) pipeline.SetNearPlaneDistance(*options.nearPlane);
+        if (options.farPlane) pipeline.SetFarPlaneDistance(*options.farPlane);
+
+        switch (options.cameraView.value_or('z')){
+            case 'x': pipeline.SetXCameraView(); break;
+            case 'y': pipeline.SetYCameraView(); break;
+            default:  pipeline.SetZCameraView(); break;
+        }
+        if (options.orbitDistance) pipeline.SetOrbitCameraDistance(*options.orbitDistance);
+        if (options.cameraAzimuthDegrees != 0.0F || options.cameraInclinationDegrees != 0.0F){
+            pipeline.RotateCamera(options.cameraAzimuthDegrees, options.cameraInclinationDegrees);
+        }
+
+        vector<shared_ptr<LightSource>> lightSources;
+        for (const LightOptions& lightOptions : options.lights){
+            auto lightSource = make_shared<LightSource>();
+            lightSource->UpdateLightSourcePosition(lightOptions.azimuthDegrees);
+            lightSource->SetLightColor(lightOptions.argbColor);
+            lightSource->SetSpecularPower(lightOptions.specularPower);
+            lightSources.push_back(std::move(lightSource));
+        }
+        pipeline.SetLightSources(std::move(lightSources));
+
+        const bool texturesRequested = !options.diffuseTexturePath.empty() ||
+                                       !options.normalTexturePath.empty() ||
+                                       !options.specularTexturePath.empty();
+        if (texturesRequested && !hasTextureCoords){
+            throw runtime_error("Textures given, but " + options.objPath + " has no texture coordinates");
+        }
+
+        BMPReader textureReader;
+        if (!options.diffuseTexturePath.empty()){
+            pipeline.SetDiffuseTexture(textureReader.GetTexture(QString::fromStdString(options.diffuseTexturePath), TEXTURE_COLOR_MODEL::RGB24));
+            pipeline.SetEnableDiffuseTexturing(true);
+        }
+        if (!options.normalTexturePath.empty()){
+            pipeline.SetNormalTexture(textureReader.GetTexture(QString::fromStdString(options.normalTexturePath), TEXTURE_COLOR_MODEL::RGB24));
+            pipeline.SetEnableNormalTexturing(true);
+        }
+        if (!options.specularTexturePath.empty()){
+            pipeline.SetSpecularTexture(textureReader.GetTexture(QString::fromStdString(options.specularTexturePath), TEXTURE_COLOR_MODEL::MONO8));
+            pipeline.SetEnableSpecularTexturing(true);
+        }
+    }
+
+    SceneData LoadSceneData(const RenderOptions& options) {
+        ObjectFileParser objectFileParser;
+        objectFileParser.SetDoApplyYZAxesFix(options.applyYZAxesFix);
+        objectFileParser.SetUseMeshCache(options.useMeshCache);
+        SceneData sceneData = objectFileParser.GetSceneDataFromObjectFile(options.objPath);
+        if (sceneData.vertices.empty() || sceneData.GetPolygonCount() == 0){
+            throw runtime_error("No geometry found in " + options.objPath);
+        }
+        return sceneData;
+    }
+
+    string GetFramePath(const string& outputDirectory, size_t frameIndex) {
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "frame_%04zu.ppm", frameIndex);
+        return (filesystem::path(outputDirectory) / fileName).string();
+    }
+
+} // namespace pv
+
+int main(int argc, char *argv[])
+{
+    using namespace pv;
+
+    try {
+        const RenderOptions options = ParseOptions(argc, argv);
+
+        SceneData sceneData;
+        unique_ptr<StreamedMesh> streamedMesh;
+
+        if (options.streamMesh){
+            const string chunkFilePath = options.objPath + ".pvchunks";
+            ObjectFileParser objectFileParser;
+            objectFileParser.SetDoApplyYZAxesFix(options.applyYZAxesFix);
+            if (!StreamedMesh::ChunkFileIsUpToDate(objectFileParser, options.objPath, chunkFilePath, options.trianglesPerChunk)){
+                StreamedMesh::WriteChunkFile(objectFileParser, options.objPath, chunkFilePath, options.trianglesPerChunk);
+            }
+            streamedMesh = make_unique<StreamedMesh>(chunkFilePath, options.memoryBudgetMegabytes << 20);
+        } else {
+            sceneData = LoadSceneData(options);
+        }
+
+        RenderingPipeline pipeline(sceneData);
+        pipeline.SetStreamedMesh(streamedMesh.get());
+        ConfigurePipeline(pipeline, options, streamedMesh ? streamedMesh->HasTextureCoords() : sceneData.HasTextureCoords());
+
+        filesystem::create_directories(options.outputDirectory);
+
+        const PPMWriter imageWriter;
+        vector<uchar> frameImage(options.width * options.height * 4);
+
+        for (size_t frameIndex = 0; frameIndex < options.frameCount; ++frameIndex){
+            pipeline.AdvanceAnimation(1.0F / options.framesPerSecond);
+            pipeline.DoRender(options.width, options.height, frameImage.data(), frameIndex > 0);
+            imageWriter.WriteImage(GetFramePath(options.outputDirectory, frameIndex),
+                                   frameImage.data(), options.width, options.height);
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        cerr << "Run with --help for usage." << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,133 +1,285 @@
 #include "headers/gui/display.h"
 #include "qevent.h"
+#include <QFontDatabase>
+#include <QStyle>
+#include <QStringList>
+#include <array>
 #include <cassert>
+#include <exception>
 
 namespace pv {
 
+    constexpr std::array<double, 3> TARGET_FPS_CHOICES { 30.0, 60.0, 120.0 };
+    constexpr size_t DEFAULT_TARGET_FPS_INDEX = 1;
+
+    inline bool LightSourcesDiffer(const LightSource& first, const LightSource& second) {
+        return first.GetLightSourcePositionDegrees() != second.GetLightSourcePositionDegrees() ||
+               first.GetLightColor() != second.GetLightColor() ||
+               first.GetSpecularPower() != second.GetSpecularPower();
+    }
+
+    // Frames are rendered on the render thread; the GUI thread only posts changes
+    // to it and blits whatever frame finished last, so input never waits for a render.
     Display::Display(size_t width, size_t height, const SceneData& sceneData, QWidget *parent):
         QLabel{parent},
         width_(width),
         height_(height),
-        rend_pipeline_(sceneData),
+        render_thread_(sceneData, width, height, [this]{
+            QMetaObject::invokeMethod(this, [this]{ update(); }, Qt::QueuedConnection);
+        }),
         mouse_pressed_(false),
+        profiler_overlay_visible_(false),
+        target_fps_index_(DEFAULT_TARGET_FPS_INDEX),
+        adaptive_resolution_(true),
         pressed_x_(0),
-        pressed_y_(0) { }
+        pressed_y_(0)
+    {
+        setMinimumSize(static_cast<int>(width), static_cast<int>(height));
+        render_thread_.SetTargetFps(TARGET_FPS_CHOICES[target_fps_index_]);
+        render_thread_.SetAdaptiveResolution(adaptive_resolution_);
+        render_thread_.RequestFrame();
+    }
+
+    void Display::UpdateSceneData(const std::function<void()>& sceneUpdate) {
+        render_thread_.RunBetweenFrames(sceneUpdate);
+        render_thread_.RequestFrame();
+    }
 
     void Display::DeferAnimationType(ANIMATION_TYPE animationType) {
-        rend_pipeline_.SetAnimationType(animationType);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetAnimationType(animationType); });
+        render_thread_.SetContinuousRendering(animationType != ANIMATION_TYPE::NO_ANIMATION);
     }
 
     void Display::DeferShadingType(SHADING_MODEL shadingType) {
-        rend_pipeline_.SetShadingModelType(shadingType);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetShadingModelType(shadingType); });
     }
 
     void Display::DeferXCameraView() {
-        rend_pipeline_.SetXCameraView();
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetXCameraView(); });
     }
 
     void Display::DeferYCameraView() {
-        rend_pipeline_.SetYCameraView();
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetYCameraView(); });
     }
 
     void Display::DeferZCameraView() {
-        rend_pipeline_.SetZCameraView();
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetZCameraView(); });
     }
 
     void Display::DeferNewFovYAngleValue(float fovy) {
-        rend_pipeline_.SetFOVYDegreeAngle(fovy);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetFOVYDegreeAngle(fovy); });
     }
 
     void Display::DeferNewNearPlaneDistance(float near) {
-        rend_pipeline_.SetNearPlaneDistance(near);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetNearPlaneDistance(near); });
     }
 
     void Display::DeferNewFarPlaneDistance(float far) {
-        rend_pipeline_.SetFarPlaneDistance(far);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetFarPlaneDistance(far); });
     }
 
     void Display::DeferDrawWorldAxis(bool drawWorldAxis) {
-        rend_pipeline_.SetDrawWorldAxis(drawWorldAxis);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetDrawWorldAxis(drawWorldAxis); });
     }
 
     void Display::DeferDrawPolygonMesh(bool drawPolygonMesh) {
-        rend_pipeline_.SetDrawPolygonMesh(drawPolygonMesh);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetDrawPolygonMesh(drawPolygonMesh); });
     }
 
     void Display::DeferRasterizePolygons(bool rasterizePolygons) {
-        rend_pipeline_.SetRasterizePolygons(rasterizePolygons);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetRasterizePolygons(rasterizePolygons); });
     }
 
     void Display::DeferNewOrbitCameraDistance(float distance) {
-        rend_pipeline_.SetOrbitCameraDistance(distance);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetOrbitCameraDistance(distance); });
     }
 
     void Display::DeferNewPenColor(QColor &penColor) {
-        rend_pipeline_.SetNewPenColor({255,
-                                       static_cast<unsigned char>(penColor.red()),
-                                       static_cast<unsigned char>(penColor.green()),
-                                       static_cast<unsigned char>(penColor.blue())});
+        const std::array<uchar, 4> argbPenColor {255,
+                                                 static_cast<unsigned char>(penColor.red()),
+                                                 static_cast<unsigned char>(penColor.green()),
+                                                 static_cast<unsigned char>(penColor.blue())};
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetNewPenColor(argbPenColor); });
     }
 
     void Display::DeferNewBrushColor(QColor &penColor) {
-        rend_pipeline_.SetNewBrushColor({255,
-                                         static_cast<unsigned char>(penColor.red()),
-                                         static_cast<unsigned char>(penColor.green()),
-                                         static_cast<unsigned char>(penColor.blue())});
+        const std::array<uchar, 4> argbBrushColor {255,
+                                                   static_cast<unsigned char>(penColor.red()),
+                                                   static_cast<unsigned char>(penColor.green()),
+                                                   static_cast<unsigned char>(penColor.blue())};
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetNewBrushColor(argbBrushColor); });
     }
 
     void Display::DeferEnableZBuffering(bool enableZBuffering) {
-        rend_pipeline_.SetEnableZBuffering(enableZBuffering);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetEnableZBuffering(enableZBuffering); });
     }
 
     void Display::DeferEnableBackfaceCulling(bool enableBackfaceCulling) {
-        rend_pipeline_.SetEnableBackfaceCulling(enableBackfaceCulling);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetEnableBackfaceCulling(enableBackfaceCulling); });
+    }
+
+    void Display::DeferEnableDepthPrepass(bool enableDepthPrepass) {
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetEnableDepthPrepass(enableDepthPrepass); });
+    }
+
+    void Display::DeferDepthFormat(DEPTH_FORMAT depthFormat) {
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetDepthFormat(depthFormat); });
     }
 
     void Display::DeferUpdatedLightSourceListModel(const LightSourceListModel *model) {
-        rend_pipeline_.SetLightSources(model->GetLightSourceItems());
+        light_sources_ = model->GetLightSourceItems();
+        PostLightSources();
     }
 
     void Display::DeferEnableDiffuseTexturing(bool diffuseEnable) {
-        rend_pipeline_.SetEnableDiffuseTexturing(diffuseEnable);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetEnableDiffuseTexturing(diffuseEnable); });
     }
 
     void Display::DeferEnableNormalTexturing(bool normalEnable) {
-        rend_pipeline_.SetEnableNormalTexturing(normalEnable);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetEnableNormalTexturing(normalEnable); });
     }
 
     void Display::DeferEnableSpecularTexturing(bool specularEnable) {
-        rend_pipeline_.SetEnableSpecularTexturing(specularEnable);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetEnableSpecularTexturing(specularEnable); });
     }
 
     void Display::DeferDiffuseTexture(TextureHolder diffuseTexture) {
-        rend_pipeline_.SetDiffuseTexture(std::move(diffuseTexture));
+        auto texture = std::make_shared<TextureHolder>(std::move(diffuseTexture));
+        render_thread_.Post([texture](RenderingPipeline& pipeline){ pipeline.SetDiffuseTexture(std::move(*texture)); });
     }
 
     void Display::DeferNormalTexture(TextureHolder normalTexture) {
-        rend_pipeline_.SetNormalTexture(std::move(normalTexture));
+        auto texture = std::make_shared<TextureHolder>(std::move(normalTexture));
+        render_thread_.Post([texture](RenderingPipeline& pipeline){ pipeline.SetNormalTexture(std::move(*texture)); });
     }
 
     void Display::DeferSpecularTexture(TextureHolder specularTexture) {
-        rend_pipeline_.SetSpecularTexture(std::move(specularTexture));
+        auto texture = std::make_shared<TextureHolder>(std::move(specularTexture));
+        render_thread_.Post([texture](RenderingPipeline& pipeline){ pipeline.SetSpecularTexture(std::move(*texture)); });
     }
 
-    void renderedImageCleanup(void* renderedImage){
-        uchar* toBeDeleted = static_cast<uchar*>(renderedImage);
-        delete[] toBeDeleted;
+    // The overlay needs the depth test / shading split, which costs some speed,
+    // so detailed profiling only runs while it is shown.
+    void Display::ToggleProfilerOverlay() {
+        profiler_overlay_visible_ = !profiler_overlay_visible_;
+        const bool enableDetailedProfiling = profiler_overlay_visible_;
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetEnableDetailedProfiling(enableDetailedProfiling); });
     }
 
-    void Display::paintEvent(QPaintEvent *event) {
+    void Display::CycleTargetFps() {
+        target_fps_index_ = (target_fps_index_ + 1) % TARGET_FPS_CHOICES.size();
+        render_thread_.SetTargetFps(TARGET_FPS_CHOICES[target_fps_index_]);
+    }
+
+    void Display::ToggleAdaptiveResolution() {
+        adaptive_resolution_ = !adaptive_resolution_;
+        render_thread_.SetAdaptiveResolution(adaptive_resolution_);
+    }
+
+    void Display::DrawProfilerOverlay(QPainter &painter, const QRect &imageRect) const {
+        const RenderStats& renderStats = render_thread_.GetPresentedStats();
+
+        QStringList lines;
+        lines << QString("frame %1 ms (%2 fps)")
+                     .arg(renderStats.frameMs, 7, 'f', 2)
+                     .arg(renderStats.frameMs > 0.0 ? 1000.0 / renderStats.frameMs : 0.0, 0, 'f', 1);
+        lines << QString("target %1 fps, %2x%3%4")
+                     .arg(TARGET_FPS_CHOICES[target_fps_index_], 0, 'f', 0)
+                     .arg(render_thread_.GetPresentedWidth())
+                     .arg(render_thread_.GetPresentedHeight())
+                     .arg(adaptive_resolution_ ? QString(" adaptive") : QString());
+
+        for (size_t stage = 0; stage < RENDER_STAGE_COUNT; ++stage){
+            lines << QString("%1 %2 ms")
+                         .arg(QString::fromLatin1(RenderStats::GetStageName(static_cast<RENDER_STAGE>(stage))), -18)
+                         .arg(renderStats.stageMs[stage], 7, 'f', 2);
+        }
+        for (size_t counter = 0; counter < RENDER_COUNTER_COUNT; ++counter){
+            lines << QString("%1 %2")
+                         .arg(QString::fromLatin1(RenderStats::GetCounterName(static_cast<RENDER_COUNTER>(counter))), -18)
+                         .arg(renderStats.counters[counter], 10);
+        }
 
-        constexpr size_t ARGB32_COMP_COUNT = 4;
-        const size_t renderedImageLength = width_ * height_ * ARGB32_COMP_COUNT;
-        uchar* renderedImage = new uchar[renderedImageLength];
+        const QString overlayText = lines.join('\n');
 
-        rend_pipeline_.DoRender(width_, height_, renderedImage);
+        painter.setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        const QRect textRect = painter.fontMetrics()
+                                      .boundingRect(imageRect, Qt::AlignLeft | Qt::AlignTop, overlayText)
+                                      .translated(8, 8);
 
-        QImage image(renderedImage, width_, height_, QImage::Format::Format_ARGB32, renderedImageCleanup, renderedImage);
-        this->setPixmap(QPixmap::fromImage(image));
+        painter.fillRect(textRect.adjusted(-4, -4, 4, 4), QColor(0, 0, 0, 160));
+        painter.setPen(Qt::white);
+        painter.drawText(textRect, Qt::AlignLeft | Qt::AlignTop, overlayText);
+    }
+
+    void Display::DrawRenderError(QPainter &painter, const QRect &imageRect) const {
+        const QString errorText = QString("Rendering failed: %1").arg(render_error_);
+
+        const QRect textRect = painter.fontMetrics()
+                                      .boundingRect(imageRect, Qt::AlignLeft | Qt::AlignBottom | Qt::TextWordWrap, errorText)
+                                      .translated(8, -8);
+
+        painter.fillRect(textRect.adjusted(-4, -4, 4, 4), QColor(160, 0, 0, 200));
+        painter.setPen(Qt::white);
+        painter.drawText(textRect, Qt::AlignLeft | Qt::AlignBottom | Qt::TextWordWrap, errorText);
+    }
+
+    // Light source widgets edit the shared light objects in place, so the render
+    // thread gets its own copies, re-posted whenever the originals changed.
+    void Display::PostLightSources() {
+        bool lightSourcesChanged = light_sources_.size() != posted_light_sources_.size();
+        for (size_t idx = 0; !lightSourcesChanged && idx < light_sources_.size(); ++idx){
+            lightSourcesChanged = LightSourcesDiffer(*light_sources_[idx], *posted_light_sources_[idx]);
+        }
+        if (!lightSourcesChanged) return;
+
+        posted_light_sources_.clear();
+        for (const auto& lightSource : light_sources_){
+            posted_light_sources_.push_back(std::make_shared<LightSource>(*lightSource));
+        }
+
+        const auto lightSources = posted_light_sources_;
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetLightSources(lightSources); });
+    }
+
+    void Display::paintEvent(QPaintEvent *event) {
+        PostLightSources();
+
+        // Exceptions must not leave a Qt event handler. A failed frame leaves the
+        // presented one in place, so the last good frame stays on screen.
+        try {
+            if (render_thread_.AcquireLatestFrame()) render_error_.clear();
+        } catch (const std::exception& error) {
+            render_error_ = QString::fromLocal8Bit(error.what());
+        } catch (...) {
+            render_error_ = "unknown error";
+        }
+
+        {
+            // Wraps the presented frame without copying it; the render thread
+            // leaves that buffer alone until the next AcquireLatestFrame.
+            const QImage frameImage(render_thread_.GetPresentedImage(),
+                                    static_cast<int>(render_thread_.GetPresentedWidth()),
+                                    static_cast<int>(render_thread_.GetPresentedHeight()),
+                                    QImage::Format::Format_ARGB32);
+
+            QPainter painter(this);
+            const QSize displaySize(static_cast<int>(width_), static_cast<int>(height_));
+            const QRect imageRect = QStyle::alignedRect(layoutDirection(), alignment(), displaySize, contentsRect());
+
+            // Frames rendered below full size to hold the frame rate are scaled up here.
+            painter.setRenderHint(QPainter::SmoothPixmapTransform, frameImage.size() != displaySize);
+            painter.drawImage(imageRect, frameImage);
+
+            if (profiler_overlay_visible_){
+                DrawProfilerOverlay(painter, imageRect);
+            }
+            if (!render_error_.isEmpty()){
+                DrawRenderError(painter, imageRect);
+            }
+        }
 
-        QLabel::paintEvent(event);
+        QFrame::paintEvent(event);
     }
 
     void Display::wheelEvent(QWheelEvent *event) {
@@ -140,7 +292,7 @@ namespace pv {
             scaleFactor /= 1.5;
         }
 
-        rend_pipeline_.SetModelScaleFactor(scaleFactor);
+        render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.SetModelScaleFactor(scaleFactor); });
     }
 
     void Display::mousePressEvent(QMouseEvent *event) {
@@ -162,7 +314,7 @@ namespace pv {
             int deltaX = newX - pressed_x_;
             int deltaY = newY - pressed_y_;
 
-            rend_pipeline_.UpdateCameraPosition(deltaX, deltaY);
+            render_thread_.Post([=](RenderingPipeline& pipeline){ pipeline.UpdateCameraPosition(deltaX, deltaY); });
 
             pressed_x_ = newX;
             pressed_y_ = newY;
@@ -1,4 +1,5 @@
 #include <QFileDialog>
+#include <QMessageBox>
 #include <QFile>
 #include <QTextStream>
 #include <QColorDialog>
@@ -84,8 +85,16 @@ void MainWindow::on_openObjFilePushButton_clicked()
                 QString(),
                 objFilter,
                 &objFilter);
+    if (filePath.isEmpty()) return;
 
-    scene_data_ = obj_file_parser_.GetSceneDataFromObjectFile(filePath);
+    pv::SceneData sceneData;
+    try {
+        sceneData = obj_file_parser_.GetSceneDataFromObjectFile(QFile::encodeName(filePath).toStdString());
+    } catch (const std::exception& error) {
+        QMessageBox::warning(this, "Read Object File Data", error.what());
+        return;
+    }
+    display_->UpdateSceneData([&]{ scene_data_ = std::move(sceneData); });
     UpdateModelStatus();
 }
 
@@ -121,6 +130,15 @@ void MainWindow::keyPressEvent(QKeyEvent *event) {
         case  Qt::Key_Z:
         display_->DeferZCameraView();
             break;
+        case  Qt::Key_P:
+        display_->ToggleProfilerOverlay();
+            break;
+        case  Qt::Key_F:
+        display_->CycleTargetFps();
+            break;
+        case  Qt::Key_R:
+        display_->ToggleAdaptiveResolution();
+            break;
     }
 }
 
@@ -424,57 +442,6 @@ void MainWindow::InitTextureStatusStringColors() {
     texture_status_string_colors_[2] = "255, 0, 0";
 }
 
-void MainWindow::SplitQuadsIntoTriangles(vector<pv::Polygon> &polygons) {
-    vector<pv::Polygon> newTriangles;
-
-    for (auto& polygon : polygons){
-        if (polygon.vertex_indices.size() == 4){
-            pv::Polygon newTriangle;
-
-            {
-                int lastVertexIndex = polygon.vertex_indices.back();
-                polygon.vertex_indices.pop_back();
-
-                copy(polygon.vertex_indices.begin(),
-                         polygon.vertex_indices.end(),
-                         back_inserter(newTriangle.vertex_indices));
-
-                newTriangle.vertex_indices.at(1) = lastVertexIndex;
-                std::swap(newTriangle.vertex_indices.at(0), newTriangle.vertex_indices.at(2));
-            }
-
-            if (polygon.texture_indices.size() == 4){
-                int lastTextureIndex = polygon.texture_indices.back();
-                polygon.texture_indices.pop_back();
-
-                copy(polygon.texture_indices.begin(),
-                     polygon.texture_indices.end(),
-                     back_inserter(newTriangle.texture_indices));
-
-                newTriangle.texture_indices.at(1) = lastTextureIndex;
-                std::swap(newTriangle.texture_indices.at(0), newTriangle.texture_indices.at(2));
-            }
-
-            if (polygon.normal_indices.size() == 4){
-                int lastNormalIndex = polygon.normal_indices.back();
-                polygon.normal_indices.pop_back();
-
-                copy(polygon.normal_indices.begin(),
-                     polygon.normal_indices.end(),
-                     back_inserter(newTriangle.normal_indices));
-
-                newTriangle.normal_indices.at(1) = lastNormalIndex;
-                std::swap(newTriangle.normal_indices.at(0), newTriangle.normal_indices.at(2));
-            }
-
-            newTriangles.push_back(newTriangle);
-        }
-    }
-
-    polygons.reserve(polygons.size() + newTriangles.size());
-    copy(newTriangles.begin(), newTriangles.end(), back_inserter(polygons));
-}
-
 void MainWindow::DoEnableModifyButton(bool enableModifyButton) {
     ui_->modifyMeshButton->setEnabled(enableModifyButton);
 }
@@ -523,15 +490,16 @@ pv::MeshStatus MainWindow::GetMeshStatus() {
     using namespace pv;
 
     if (scene_data_.vertices.size() == 0 ||
-        scene_data_.polygons.size() == 0) { return  MeshStatus::NO_MODEL; }
+        scene_data_.GetPolygonCount() == 0) { return  MeshStatus::NO_MODEL; }
 
     MeshStatus meshStatus = MeshStatus::TRIANGLES_ONLY;
 
-    for (const auto& polygon : scene_data_.polygons){
-        if (polygon.vertex_indices.size() == 4){
+    for (size_t polygonIndex = 0; polygonIndex < scene_data_.GetPolygonCount(); ++polygonIndex){
+        const size_t cornerCount = scene_data_.GetCornerCount(polygonIndex);
+        if (cornerCount == 4){
             meshStatus = MeshStatus::CONVERTIBLE_TO_TRIANGLES;
         }
-        if (polygon.vertex_indices.size() > 4){
+        if (cornerCount > 4){
             return MeshStatus::NON_CONVERTIBLE_TO_TRIANGLES;
         }
     }
@@ -543,7 +511,7 @@ pv::NormalStatus MainWindow::GetNormalStatus() {
     using namespace pv;
 
     if (scene_data_.vertices.size() == 0 ||
-        scene_data_.polygons.size() == 0) { return  NormalStatus::NO_MODEL; }
+        scene_data_.GetPolygonCount() == 0) { return  NormalStatus::NO_MODEL; }
 
     if (scene_data_.vertex_normals.size() == 0){
         return NormalStatus::NO_NORMALS_PROVIDED;
@@ -556,7 +524,7 @@ pv::TextureStatus MainWindow::GetTextureStatus() {
     using namespace pv;
 
     if (scene_data_.vertices.size() == 0 ||
-        scene_data_.polygons.size() == 0) { return  TextureStatus::NO_MODEL; }
+        scene_data_.GetPolygonCount() == 0) { return  TextureStatus::NO_MODEL; }
 
     if (scene_data_.vertex_textures.size() == 0){
         return TextureStatus::NO_TEXTURE_COORD_PROVIDED;
@@ -601,7 +569,7 @@ void MainWindow::on_enableZBufferingCheckBox_stateChanged(int stateValue) {
 
 
 void MainWindow::on_modifyMeshButton_clicked() {
-    SplitQuadsIntoTriangles(scene_data_.polygons);
+    display_->UpdateSceneData([this]{ scene_data_.SplitQuadsIntoTriangles(); });
     UpdateMeshStatus();
 }
 
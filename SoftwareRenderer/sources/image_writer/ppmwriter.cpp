@@ -0,0 +1,37 @@
+#include "headers/image_writer/ppmwriter.h"
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace pv {
+
+    void PPMWriter::WriteImage(const std::string &path, const uchar *argbPixels, size_t width, size_t height) const {
+        ofstream outputFile(path, ios::binary);
+        if (!outputFile){
+            throw runtime_error("Cannot open " + path + " for writing!");
+        }
+
+        outputFile << "P6\n" << width << " " << height << "\n255\n";
+
+        constexpr size_t ARGB_COMPONENTS = 4, RGB_COMPONENTS = 3;
+        vector<char> rowData(width * RGB_COMPONENTS);
+
+        for (size_t y = 0; y < height; ++y){
+            const uchar* sourceRow = argbPixels + y * width * ARGB_COMPONENTS;
+
+            for (size_t x = 0; x < width; ++x){
+                rowData[x * RGB_COMPONENTS    ] = static_cast<char>(sourceRow[x * ARGB_COMPONENTS + 2]);
+                rowData[x * RGB_COMPONENTS + 1] = static_cast<char>(sourceRow[x * ARGB_COMPONENTS + 1]);
+                rowData[x * RGB_COMPONENTS + 2] = static_cast<char>(sourceRow[x * ARGB_COMPONENTS    ]);
+            }
+            outputFile.write(rowData.data(), static_cast<streamsize>(rowData.size()));
+        }
+
+        if (!outputFile){
+            throw runtime_error("Failed to write " + path + "!");
+        }
+    }
+
+} // namespace pv
@@ -1,17 +1,27 @@
 #include "headers/matrix_transform/animation.h"
+#include <cmath>
 
 namespace pv {
 
-glm::mat4 NoAnimation::GetModelMatrix() {
-    return glm::mat4(1.0);
+// The speeds the animations used to have when stepped once per frame at 60 fps.
+constexpr float ROTATION_DEGREES_PER_SECOND = 60.0F;
+constexpr float CAROUSEL_SPIN_DEGREES_PER_SECOND = 30.0F;
+constexpr float CAROUSEL_ORBIT_DEGREES_PER_SECOND = 9.0F;
+
+void Animation::Advance(float elapsedSeconds) {
+    elapsed_seconds_ += elapsedSeconds;
+}
+
+float Animation::GetDegreeAngle(float degreesPerSecond) const {
+    return static_cast<float>(std::fmod(elapsed_seconds_ * degreesPerSecond, 360.0));
 }
 
-glm::mat4 XAnimation::GetModelMatrix() {
-    static float rotationAngleInDegrees = 0.0;
-    rotationAngleInDegrees += 1.0;
+glm::mat4 NoAnimation::GetModelMatrix() const {
+    return glm::mat4(1.0);
+}
 
-    if (rotationAngleInDegrees > 360) { rotationAngleInDegrees = 0.0; }
-    float rotationAngleInRadians = GetRadianAngle(rotationAngleInDegrees);
+glm::mat4 XAnimation::GetModelMatrix() const {
+    float rotationAngleInRadians = GetRadianAngle(GetDegreeAngle(ROTATION_DEGREES_PER_SECOND));
 
     float cosineValue = cos(rotationAngleInRadians);
     float sineValue = sin(rotationAngleInRadians);
@@ -23,12 +33,8 @@ glm::mat4 XAnimation::GetModelMatrix() {
                     {0, 0, 0, 1});
 }
 
-glm::mat4 YAnimation::GetModelMatrix() {
-    static float rotationAngleInDegrees = 0.0;
-    rotationAngleInDegrees += 1.0;
-
-    if (rotationAngleInDegrees > 360) { rotationAngleInDegrees = 0.0; }
-    float rotationAngleInRadians = GetRadianAngle(rotationAngleInDegrees);
+glm::mat4 YAnimation::GetModelMatrix() const {
+    float rotationAngleInRadians = GetRadianAngle(GetDegreeAngle(ROTATION_DEGREES_PER_SECOND));
 
     float cosineValue = cos(rotationAngleInRadians);
     float sineValue = sin(rotationAngleInRadians);
@@ -40,12 +46,8 @@ glm::mat4 YAnimation::GetModelMatrix() {
                     {0, 0, 0, 1});
 }
 
-glm::mat4 ZAnimation::GetModelMatrix() {
-    static float rotationAngleInDegrees = 0.0;
-    rotationAngleInDegrees += 1.0;
-
-    if (rotationAngleInDegrees > 360) { rotationAngleInDegrees = 0.0; }
-    float rotationAngleInRadians = GetRadianAngle(rotationAngleInDegrees);
+glm::mat4 ZAnimation::GetModelMatrix() const {
+    float rotationAngleInRadians = GetRadianAngle(GetDegreeAngle(ROTATION_DEGREES_PER_SECOND));
 
     float cosineValue = cos(rotationAngleInRadians);
     float sineValue = sin(rotationAngleInRadians);
@@ -57,18 +59,9 @@ glm::mat4 ZAnimation::GetModelMatrix() {
                     {0, 0, 0, 1});
 }
 
-glm::mat4 CarouselAnimation::GetModelMatrix() {
-    static float zRotationAngleInDegrees = 0.0;
-    static float translationVectorAngle = 0.0;
-
-    zRotationAngleInDegrees += 0.5;
-    translationVectorAngle += 0.15;
-
-    if (zRotationAngleInDegrees > 360) { zRotationAngleInDegrees = 0.0; }
-    if (translationVectorAngle > 360)  {  translationVectorAngle = 0.0; }
-
-    float zRotationAngleInRadians = GetRadianAngle(zRotationAngleInDegrees);
-    float translationVectorAngleInRadians = GetRadianAngle(translationVectorAngle);
+glm::mat4 CarouselAnimation::GetModelMatrix() const {
+    float zRotationAngleInRadians = GetRadianAngle(GetDegreeAngle(CAROUSEL_SPIN_DEGREES_PER_SECOND));
+    float translationVectorAngleInRadians = GetRadianAngle(GetDegreeAngle(CAROUSEL_ORBIT_DEGREES_PER_SECOND));
 
     float ZCos = cos(zRotationAngleInRadians);
     float ZSin = sin(zRotationAngleInRadians);
@@ -0,0 +1,100 @@
+#include "headers/object_file_parser/mappedfile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace pv {
+
+#ifdef _WIN32
+
+    MappedFile::MappedFile(const std::string& filePath) : data_(nullptr), size_(0) {
+        HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE){
+            throw runtime_error("Can't open " + filePath);
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)){
+            CloseHandle(file);
+            throw runtime_error("Can't get the size of " + filePath);
+        }
+        size_ = static_cast<size_t>(fileSize.QuadPart);
+
+        // Empty files can't be mapped and are left as an empty view.
+        if (size_ != 0){
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping){
+                data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+
+        if (size_ != 0 && !data_){
+            throw runtime_error("Can't map " + filePath);
+        }
+    }
+
+    MappedFile::~MappedFile() {
+        if (data_) UnmapViewOfFile(data_);
+    }
+
+#else
+
+    MappedFile::MappedFile(const std::string& filePath) : data_(nullptr), size_(0) {
+        const int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+        if (fileDescriptor < 0){
+            throw runtime_error("Can't open " + filePath);
+        }
+
+        struct stat fileStatus;
+        if (fstat(fileDescriptor, &fileStatus) != 0){
+            close(fileDescriptor);
+            throw runtime_error("Can't get the size of " + filePath);
+        }
+        size_ = static_cast<size_t>(fileStatus.st_size);
+
+        // Empty files can't be mapped and are left as an empty view.
+        if (size_ != 0){
+            void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+            if (mapping != MAP_FAILED){
+                data_ = static_cast<const char*>(mapping);
+                madvise(mapping, size_, MADV_SEQUENTIAL);
+            }
+        }
+        close(fileDescriptor);
+
+        if (size_ != 0 && !data_){
+            throw runtime_error("Can't map " + filePath);
+        }
+    }
+
+    MappedFile::~MappedFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+    }
+
+#endif
+
+    const char* MappedFile::GetData() const {
+        return data_;
+    }
+
+    size_t MappedFile::GetSize() const {
+        return size_;
+    }
+
+    std::string_view MappedFile::GetView() const {
+        return { data_, size_ };
+    }
+
+} // namespace pv
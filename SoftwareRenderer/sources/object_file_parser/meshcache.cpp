@@ -0,0 +1,238 @@
+#include "headers/object_file_parser/meshcache.h"
+#include "headers/object_file_parser/mappedfile.h"
+#include "headers/threading/threadpool.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace pv {
+
+    constexpr char MESH_CACHE_MAGIC[8] = { 'P', 'V', 'M', 'E', 'S', 'H', '\0', '\0' };
+    constexpr uint32_t MESH_CACHE_VERSION = 1;
+    constexpr uint32_t MESH_CACHE_BYTE_ORDER_MARK = 0x01020304;
+    constexpr uint64_t MESH_CACHE_ALIGNMENT = 64;
+
+    constexpr size_t HASH_BLOCK_SIZE = 4 << 20;
+    constexpr uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float) && is_trivially_copyable_v<glm::vec3>,
+                  "Mesh cache arrays are stored as the in-memory glm::vec3 layout");
+
+    // Element count of an array and the byte offset of its first element from
+    // the start of the cache file.
+    struct MeshCacheArray {
+        uint64_t count;
+        uint64_t offset;
+    };
+
+    struct MeshCacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+
+        uint64_t sourceSize;
+        uint64_t sourceHash;
+
+        MeshCacheArray vertices;
+        MeshCacheArray vertexTextures;
+        MeshCacheArray vertexNormals;
+        MeshCacheArray polygonOffsets;
+        MeshCacheArray vertexIndices;
+    };
+
+    inline uint64_t AlignCacheOffset(uint64_t offset) {
+        return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+    }
+
+    inline uint64_t RotateLeft(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // Word at a time multiply-rotate hash; not cryptographic, only meant to
+    // tell whether the OBJ text changed since the cache was written.
+    inline uint64_t GetBytesHash(const char* data, size_t size, uint64_t seed) {
+        uint64_t hash = seed ^ (size * HASH_PRIME_1);
+        const auto mixWord = [&hash](uint64_t word){
+            hash = RotateLeft(hash ^ (word * HASH_PRIME_2), 31) * HASH_PRIME_1;
+        };
+
+        size_t offset = 0;
+        for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)){
+            uint64_t word;
+            memcpy(&word, data + offset, sizeof(word));
+            mixWord(word);
+        }
+        if (offset < size){
+            uint64_t word = 0;
+            memcpy(&word, data + offset, size - offset);
+            mixWord(word);
+        }
+
+        hash ^= hash >> 33;
+        hash *= HASH_PRIME_2;
+        hash ^= hash >> 29;
+        return hash;
+    }
+
+    // Blocks are hashed in parallel and the content hash is the hash of the
+    // block hashes, so it depends on HASH_BLOCK_SIZE but not on the thread count.
+    uint64_t GetContentHash(std::string_view text, ThreadPool& threadPool) {
+        const size_t blockCount = (text.size() + HASH_BLOCK_SIZE - 1) / HASH_BLOCK_SIZE;
+        vector<uint64_t> blockHashes(blockCount);
+
+        threadPool.ParallelFor(blockCount, [&](size_t blockIndex){
+            const size_t blockBegin = blockIndex * HASH_BLOCK_SIZE;
+            blockHashes[blockIndex] = GetBytesHash(text.data() + blockBegin,
+                                                   min(HASH_BLOCK_SIZE, text.size() - blockBegin),
+                                                   blockIndex);
+        });
+
+        return GetBytesHash(reinterpret_cast<const char*>(blockHashes.data()),
+                            blockHashes.size() * sizeof(uint64_t),
+                            text.size());
+    }
+
+    template<typename Element>
+    bool ReadCacheArray(std::string_view cacheData, const MeshCacheArray& array, std::vector<Element>& elements) {
+        if (array.offset % MESH_CACHE_ALIGNMENT != 0 || array.offset > cacheData.size() ||
+            array.count > (cacheData.size() - array.offset) / sizeof(Element)){
+            return false;
+        }
+
+        const Element* firstElement = reinterpret_cast<const Element*>(cacheData.data() + array.offset);
+        elements.assign(firstElement, firstElement + array.count);
+        return true;
+    }
+
+    // Guards the renderer against truncated or damaged cache files, whose
+    // indices would otherwise be used unchecked.
+    inline bool SceneDataIsConsistent(const SceneData& sceneData) {
+        const size_t vertexCount = sceneData.vertices.size();
+
+        if (!sceneData.vertex_textures.empty() && sceneData.vertex_textures.size() != vertexCount) return false;
+        if (!sceneData.vertex_normals.empty() && sceneData.vertex_normals.size() != vertexCount) return false;
+
+        const std::vector<uint32_t>& polygonOffsets = sceneData.polygon_offsets;
+        if (polygonOffsets.empty() || polygonOffsets.front() != 0 ||
+            polygonOffsets.back() != sceneData.vertex_indices.size() ||
+            !is_sorted(polygonOffsets.begin(), polygonOffsets.end())){
+            return false;
+        }
+
+        return all_of(sceneData.vertex_indices.begin(), sceneData.vertex_indices.end(), [vertexCount](int vertexIndex){
+            return vertexIndex >= 0 && static_cast<size_t>(vertexIndex) < vertexCount;
+        });
+    }
+
+    MeshCache::MeshCache(const std::string& objectFilePath, std::string_view objectFileText, ThreadPool& threadPool) :
+        cache_file_path_(objectFilePath + ".pvmesh"),
+        source_size_(objectFileText.size()),
+        source_hash_(GetContentHash(objectFileText, threadPool))
+    {}
+
+    bool MeshCache::Load(SceneData& sceneData) const {
+        error_code fileError;
+        if (!filesystem::is_regular_file(cache_file_path_, fileError)) return false;
+
+        SceneData cachedSceneData;
+        try {
+            const MappedFile cacheFile(cache_file_path_);
+            const std::string_view cacheData = cacheFile.GetView();
+
+            MeshCacheHeader header;
+            if (cacheData.size() < sizeof(header)) return false;
+            memcpy(&header, cacheData.data(), sizeof(header));
+
+            if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+                header.version != MESH_CACHE_VERSION ||
+                header.byteOrderMark != MESH_CACHE_BYTE_ORDER_MARK ||
+                header.sourceSize != source_size_ ||
+                header.sourceHash != source_hash_){
+                return false;
+            }
+
+            if (!ReadCacheArray(cacheData, header.vertices, cachedSceneData.vertices) ||
+                !ReadCacheArray(cacheData, header.vertexTextures, cachedSceneData.vertex_textures) ||
+                !ReadCacheArray(cacheData, header.vertexNormals, cachedSceneData.vertex_normals) ||
+                !ReadCacheArray(cacheData, header.polygonOffsets, cachedSceneData.polygon_offsets) ||
+                !ReadCacheArray(cacheData, header.vertexIndices, cachedSceneData.vertex_indices)){
+                return false;
+            }
+        } catch (const runtime_error&) {
+            return false;
+        }
+
+        if (!SceneDataIsConsistent(cachedSceneData)) return false;
+
+        sceneData = std::move(cachedSceneData);
+        return true;
+    }
+
+    bool MeshCache::Save(const SceneData& sceneData) const {
+        MeshCacheHeader header{};
+        memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+        header.version = MESH_CACHE_VERSION;
+        header.byteOrderMark = MESH_CACHE_BYTE_ORDER_MARK;
+        header.sourceSize = source_size_;
+        header.sourceHash = source_hash_;
+
+        uint64_t cacheSize = AlignCacheOffset(sizeof(header));
+        const auto placeArray = [&cacheSize](MeshCacheArray& array, size_t count, size_t elementSize){
+            array = { count, cacheSize };
+            cacheSize = AlignCacheOffset(cacheSize + count * elementSize);
+        };
+        placeArray(header.vertices, sceneData.vertices.size(), sizeof(glm::vec3));
+        placeArray(header.vertexTextures, sceneData.vertex_textures.size(), sizeof(glm::vec3));
+        placeArray(header.vertexNormals, sceneData.vertex_normals.size(), sizeof(glm::vec3));
+        placeArray(header.polygonOffsets, sceneData.polygon_offsets.size(), sizeof(uint32_t));
+        placeArray(header.vertexIndices, sceneData.vertex_indices.size(), sizeof(int));
+
+        const string temporaryFilePath = cache_file_path_ + ".tmp";
+        {
+            ofstream cacheFile(temporaryFilePath, ios::binary | ios::trunc);
+            if (!cacheFile) return false;
+
+            uint64_t writtenSize = 0;
+            const auto writeAt = [&](uint64_t offset, const void* data, size_t size){
+                static const char padding[MESH_CACHE_ALIGNMENT] = {};
+                cacheFile.write(padding, static_cast<streamsize>(offset - writtenSize));
+                cacheFile.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+                writtenSize = offset + size;
+            };
+
+            writeAt(0, &header, sizeof(header));
+            writeAt(header.vertices.offset, sceneData.vertices.data(), sceneData.vertices.size() * sizeof(glm::vec3));
+            writeAt(header.vertexTextures.offset, sceneData.vertex_textures.data(), sceneData.vertex_textures.size() * sizeof(glm::vec3));
+            writeAt(header.vertexNormals.offset, sceneData.vertex_normals.data(), sceneData.vertex_normals.size() * sizeof(glm::vec3));
+            writeAt(header.polygonOffsets.offset, sceneData.polygon_offsets.data(), sceneData.polygon_offsets.size() * sizeof(uint32_t));
+            writeAt(header.vertexIndices.offset, sceneData.vertex_indices.data(), sceneData.vertex_indices.size() * sizeof(int));
+
+            cacheFile.close();
+            if (!cacheFile){
+                error_code removeError;
+                filesystem::remove(temporaryFilePath, removeError);
+                return false;
+            }
+        }
+
+        error_code renameError;
+        filesystem::rename(temporaryFilePath, cache_file_path_, renameError);
+        if (renameError){
+            filesystem::remove(temporaryFilePath, renameError);
+            return false;
+        }
+        return true;
+    }
+
+    const std::string& MeshCache::GetCacheFilePath() const {
+        return cache_file_path_;
+    }
+
+} // namespace pv
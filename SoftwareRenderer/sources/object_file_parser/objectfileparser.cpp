@@ -1,54 +1,137 @@
 #include "headers/object_file_parser/objectfileparser.h"
-#include <QFile>
-#include <QTextStream>
+#include "headers/object_file_parser/mappedfile.h"
+#include "headers/object_file_parser/meshcache.h"
+#include "headers/rendering/vertexwelder.h"
+#include "headers/threading/threadpool.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
 #include <glm/mat3x3.hpp>
 
+using namespace std;
+
 namespace pv {
 
+    constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+    constexpr size_t CHUNKS_PER_THREAD = 4;
 
-ObjectFileParser::ObjectFileParser() : do_apply_yz_axes_fix_(false) {}
+    inline bool IsBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
 
-SceneData ObjectFileParser::GetSceneDataFromObjectFile(QString filePath) {
-        SceneData sceneData;
+    // Calls lineHandler with every line of text, without its line break.
+    template<typename LineHandler>
+    void ForEachLine(std::string_view text, LineHandler&& lineHandler) {
+        while (!text.empty()){
+            const void* lineBreak = memchr(text.data(), '\n', text.size());
+            const size_t lineLength = lineBreak ? static_cast<const char*>(lineBreak) - text.data() : text.size();
 
-        QFile inputFile(filePath);
-        inputFile.open(QIODevice::ReadOnly);
-        QTextStream in(&inputFile);
+            lineHandler(text.substr(0, lineLength));
+            text.remove_prefix(min(lineLength + 1, text.size()));
+        }
+    }
 
-        {
-            while (!in.atEnd()){
-                QString line = in.readLine();
-                if (line.size() != 0) {
-                    char firstChar = line[0].toLatin1();
-
-                    if (firstChar == 'v'){
-                            char secondChar = line[1].toLatin1();
-
-                            switch (secondChar){
-                                case ' ':
-                                sceneData.vertices.push_back(GetVertexData(line));
-                                    break;
-                                case 't':
-                                sceneData.vertex_textures.push_back(GetTextureData(line));
-                                    break;
-                                case 'n':
-                                sceneData.vertex_normals.push_back(GetNormalData(line));
-                                    break;
-                            }
-
-                    }
-                        else
-                    if (firstChar == 'f')
-                    {
-                        sceneData.polygons.push_back(GetPolygonData(line));
-                    }
+    // Cuts the next blank separated token off the front of line, empty once
+    // the line is used up.
+    inline std::string_view NextToken(std::string_view& line) {
+        size_t tokenBegin = 0;
+        while (tokenBegin < line.size() && IsBlank(line[tokenBegin])) ++tokenBegin;
+
+        size_t tokenEnd = tokenBegin;
+        while (tokenEnd < line.size() && !IsBlank(line[tokenEnd])) ++tokenEnd;
+
+        const std::string_view token = line.substr(tokenBegin, tokenEnd - tokenBegin);
+        line.remove_prefix(tokenEnd);
+        return token;
+    }
+
+    inline float GetFloatValue(std::string_view token) {
+        if (!token.empty() && token.front() == '+') token.remove_prefix(1);
+
+        // Values out of float range are read as 0 instead of failing the load.
+        float value = 0;
+        const auto [valueEnd, error] = from_chars(token.data(), token.data() + token.size(), value);
+        if (error == errc::invalid_argument || valueEnd != token.data() + token.size()){
+            throw runtime_error("Malformed number \"" + string(token) + "\"");
+        }
+        return value;
+    }
+
+    // OBJ indices are 1-based, and 0 and missing indices both come out as
+    // NO_INDEX. Negative indices count back from the last of the definedCount
+    // elements read so far and set isRelative.
+    inline int GetIndexValue(std::string_view token, const char* indexName, size_t definedCount, bool& isRelative) {
+        if (token.empty()) return VertexWelder::NO_INDEX;
+
+        int value = 0;
+        const auto [valueEnd, error] = from_chars(token.data(), token.data() + token.size(), value);
+        if (error != errc() || valueEnd != token.data() + token.size()){
+            throw runtime_error("Malformed " + string(indexName) + " index \"" + string(token) + "\"");
+        }
+
+        if (value < 0){
+            isRelative = true;
+            return static_cast<int>(definedCount) + value;
+        }
+        return value - 1;
+    }
+
+    // Offsets the relative corner indices of chunk by its elementOffsets, the
+    // elements of all earlier chunks.
+    inline void ResolveRelativeIndices(ObjectFileParser::ObjectFileChunk& chunk) {
+        for (ObjectFileParser::ObjectFileChunk::Corner& corner : chunk.corners){
+            if (!corner.relativeMask) continue;
+
+            for (size_t attribute = 0; attribute < corner.indices.size(); ++attribute){
+                if (!(corner.relativeMask & (1 << attribute))) continue;
+
+                corner.indices[attribute] += static_cast<int>(chunk.elementOffsets[attribute]);
+                if (corner.indices[attribute] < 0){
+                    throw runtime_error("Relative index refers to an element before the first one");
                 }
             }
         }
-        inputFile.close();
+    }
+
+    ObjectFileParser::ObjectFileParser() : do_apply_yz_axes_fix_(false), use_mesh_cache_(true) {}
+
+    SceneData ObjectFileParser::GetSceneDataFromObjectFile(const std::string& filePath) {
+        SceneData sceneData;
+
+        const MappedFile objectFile(filePath);
+        const std::string_view fileText = objectFile.GetView();
+
+        const size_t threadCount = max<size_t>(thread::hardware_concurrency(), 1);
+        const size_t chunkCount = clamp<size_t>(fileText.size() / MIN_CHUNK_SIZE, 1, threadCount * CHUNKS_PER_THREAD);
+        ThreadPool threadPool(chunkCount > 1 ? threadCount : 1);
+
+        // The cache holds the mesh as parsed, before the axes fix, so it
+        // serves loads with and without it.
+        std::optional<MeshCache> meshCache;
+        if (use_mesh_cache_) meshCache.emplace(filePath, fileText, threadPool);
+
+        if (!meshCache || !meshCache->Load(sceneData)){
+            VertexWelder vertexWelder;
+            {
+                std::vector<ObjectFileChunk> chunks = SplitIntoChunks(fileText, chunkCount);
+
+                threadPool.ParallelFor(chunks.size(), [&](size_t chunkIndex){
+                    ParseChunk(chunks[chunkIndex]);
+                });
+
+                MergeChunks(chunks, sceneData, vertexWelder, threadPool);
+            }
+            vertexWelder.WeldAttributes(sceneData);
+
+            if (meshCache) meshCache->Save(sceneData);
+        }
 
         if (do_apply_yz_axes_fix_){
-            this->DoApplyYZAxesFix(sceneData);
+            this->DoApplyYZAxesFix(sceneData, threadPool);
         }
 
         return sceneData;
@@ -58,121 +141,210 @@ SceneData ObjectFileParser::GetSceneDataFromObjectFile(QString filePath) {
         do_apply_yz_axes_fix_ = applyFix;
     }
 
-    glm::vec3 ObjectFileParser::GetVertexData(QString line) {
-        QStringList list = line.split(" ", Qt::SkipEmptyParts);
-
-        float x = list.at(1).toFloat();
-        float y = list.at(2).toFloat();
-        float z = list.at(3).toFloat();
+    bool ObjectFileParser::GetDoApplyYZAxesFix() const {
+        return do_apply_yz_axes_fix_;
+    }
 
-        return {x, y, z};
+    void ObjectFileParser::SetUseMeshCache(bool useMeshCache) {
+        use_mesh_cache_ = useMeshCache;
     }
 
-    glm::vec3 ObjectFileParser::GetTextureData(QString line) {
-        QStringList list = line.split(" ", Qt::SkipEmptyParts);
+    std::vector<ObjectFileParser::ObjectFileChunk>
+    ObjectFileParser::SplitIntoChunks(std::string_view fileText, size_t chunkCount) {
+        std::vector<ObjectFileChunk> chunks;
+        chunks.reserve(chunkCount);
 
-        float u = list.at(1).toFloat();
-        float v = 0, w = 0;
+        size_t chunkBegin = 0;
+        for (size_t chunkIndex = 1; chunkIndex <= chunkCount && chunkBegin < fileText.size(); ++chunkIndex){
+            size_t chunkEnd = fileText.size();
 
-        if (list.size() >= 3){
-            v = list.at(2).toFloat();
-        }
+            if (chunkIndex < chunkCount){
+                const size_t lineBreak = fileText.find('\n', max(chunkBegin, fileText.size() / chunkCount * chunkIndex));
+                if (lineBreak != std::string_view::npos) chunkEnd = lineBreak + 1;
+            }
 
-        if (list.size() == 4){
-            w = list.at(3).toFloat();
+            chunks.emplace_back();
+            chunks.back().text = fileText.substr(chunkBegin, chunkEnd - chunkBegin);
+            chunkBegin = chunkEnd;
         }
 
-        return {u, v, w};
+        return chunks;
     }
 
-    glm::vec3 ObjectFileParser::GetNormalData(QString line) {
-        QStringList list = line.split(" ", Qt::SkipEmptyParts);
+    void ObjectFileParser::ParseChunk(ObjectFileChunk& chunk) {
+        ReserveChunkData(chunk);
 
-        float i = list.at(1).toFloat();
-        float j = list.at(2).toFloat();
-        float k = list.at(3).toFloat();
+        ForEachLine(chunk.text, [&](std::string_view line){
+            const std::string_view keyword = NextToken(line);
 
-        return {i, j, k};
+            if (keyword == "v"){
+                chunk.vertices.push_back(GetVertexData(line));
+            }
+                else
+            if (keyword == "vt"){
+                chunk.vertexTextures.push_back(GetTextureData(line));
+            }
+                else
+            if (keyword == "vn"){
+                chunk.vertexNormals.push_back(GetNormalData(line));
+            }
+                else
+            if (keyword == "f"){
+                AppendPolygonData(line, chunk);
+            }
+        });
     }
 
-    Polygon ObjectFileParser::GetPolygonData(QString line) {
-        Polygon toReturn;
-        QStringList list = line.split(" ", Qt::SkipEmptyParts);
-        qsizetype doubleDashCount = list[1].count("//");
+    // Counts statements by their first two bytes only, which is cheap next to
+    // parsing and lets every array be allocated once. Faces are assumed to be
+    // triangles; files with larger polygons grow the corner array once more.
+    void ObjectFileParser::ReserveChunkData(ObjectFileChunk& chunk) {
+        size_t vertexCount = 0, textureCount = 0, normalCount = 0, polygonCount = 0;
 
-        switch (doubleDashCount){
-            case 1:{
-            toReturn = GetPolygonDataDoubleDash(list);
-                break;
-            }
-            default:{
-                qsizetype dashCount = list[1].count("/");
-                if (dashCount == 1)
-                    toReturn = GetPolygonDataOneDash(list);
-                else
-                    toReturn = GetPolygonDataTwoDashes(list);
+        ForEachLine(chunk.text, [&](std::string_view line){
+            if (line.size() < 2) return;
+
+            if (line[0] == 'v'){
+                if (IsBlank(line[1])) ++vertexCount;
+                else if (line[1] == 't') ++textureCount;
+                else if (line[1] == 'n') ++normalCount;
             }
+            else if (line[0] == 'f' && IsBlank(line[1])) ++polygonCount;
+        });
+
+        chunk.vertices.reserve(vertexCount);
+        chunk.vertexTextures.reserve(textureCount);
+        chunk.vertexNormals.reserve(normalCount);
+        chunk.corners.reserve(polygonCount * 3);
+        chunk.polygonCornerCounts.reserve(polygonCount);
+    }
+
+    // Prefix sums over the chunks give where each chunk's elements go, so
+    // copying them and fixing relative indices runs per chunk in parallel.
+    // Welding stays serial and in file order, which keeps the vertex order
+    // independent of how the file was split.
+    void ObjectFileParser::MergeChunks(std::vector<ObjectFileChunk>& chunks, SceneData& sceneData,
+                                       VertexWelder& vertexWelder, ThreadPool& threadPool) {
+        size_t vertexCount = 0, textureCount = 0, normalCount = 0, cornerCount = 0, polygonCount = 0;
+
+        for (ObjectFileChunk& chunk : chunks){
+            chunk.elementOffsets = { vertexCount, textureCount, normalCount };
+
+            vertexCount += chunk.vertices.size();
+            textureCount += chunk.vertexTextures.size();
+            normalCount += chunk.vertexNormals.size();
+            cornerCount += chunk.corners.size();
+            polygonCount += chunk.polygonCornerCounts.size();
         }
 
-        return toReturn;
-    }
+        sceneData.vertices.resize(vertexCount);
+        sceneData.vertex_textures.resize(textureCount);
+        sceneData.vertex_normals.resize(normalCount);
 
-    Polygon ObjectFileParser::GetPolygonDataOneDash(QStringList list) {
-        Polygon toReturn;
-        {
-            for (qsizetype itemIndex = 1; itemIndex < list.size(); ++itemIndex){
-                QStringList indices = list[itemIndex].split("/", Qt::SkipEmptyParts);
+        threadPool.ParallelFor(chunks.size(), [&](size_t chunkIndex){
+            ObjectFileChunk& chunk = chunks[chunkIndex];
+
+            copy(chunk.vertices.begin(), chunk.vertices.end(), sceneData.vertices.begin() + chunk.elementOffsets[0]);
+            copy(chunk.vertexTextures.begin(), chunk.vertexTextures.end(), sceneData.vertex_textures.begin() + chunk.elementOffsets[1]);
+            copy(chunk.vertexNormals.begin(), chunk.vertexNormals.end(), sceneData.vertex_normals.begin() + chunk.elementOffsets[2]);
+
+            std::vector<glm::vec3>().swap(chunk.vertices);
+            std::vector<glm::vec3>().swap(chunk.vertexTextures);
+            std::vector<glm::vec3>().swap(chunk.vertexNormals);
+
+            ResolveRelativeIndices(chunk);
+        });
+
+        vertexWelder.Reserve(vertexCount);
+        sceneData.vertex_indices.reserve(cornerCount);
+        sceneData.polygon_offsets.reserve(polygonCount + 1);
 
-                int vertexIndex = indices[0].toInt(); if (vertexIndex < 0) throw std::runtime_error("One dash - Negative vertex index!");
-                vertexIndex--;
-                toReturn.vertex_indices.push_back(vertexIndex);
+        for (const ObjectFileChunk& chunk : chunks){
+            const ObjectFileChunk::Corner* corner = chunk.corners.data();
 
-                int textureIndex = indices[1].toInt(); if (textureIndex < 0) throw std::runtime_error("One dash - Negative texture index!");
-                textureIndex--;
-                toReturn.texture_indices.push_back(textureIndex);
+            for (uint32_t polygonCornerCount : chunk.polygonCornerCounts){
+                for (uint32_t cornerIndex = 0; cornerIndex < polygonCornerCount; ++cornerIndex, ++corner){
+                    sceneData.vertex_indices.push_back(vertexWelder.GetVertexIndex(corner->indices[0],
+                                                                                   corner->indices[1],
+                                                                                   corner->indices[2]));
+                }
+                sceneData.EndPolygon();
             }
         }
-        return toReturn;
     }
 
-    Polygon ObjectFileParser::GetPolygonDataTwoDashes(QStringList list) {
-        Polygon toReturn;
-        {
-            for (qsizetype itemIndex = 1; itemIndex < list.size(); ++itemIndex){
-                QStringList indices = list[itemIndex].split("/", Qt::SkipEmptyParts);
+    glm::vec3 ObjectFileParser::GetVertexData(std::string_view line) {
+        float x = GetFloatValue(NextToken(line));
+        float y = GetFloatValue(NextToken(line));
+        float z = GetFloatValue(NextToken(line));
 
-                int vertexIndex = indices[0].toInt(); if (vertexIndex < 0) throw std::runtime_error("Two dashes - Negative vertex index!");
-                vertexIndex--;
-                toReturn.vertex_indices.push_back(vertexIndex);
+        return {x, y, z};
+    }
 
-                int textureIndex = indices[1].toInt(); if (textureIndex < 0) throw std::runtime_error("Two dashes - Negative texture index!");
-                textureIndex--;
-                toReturn.texture_indices.push_back(textureIndex);
+    glm::vec3 ObjectFileParser::GetTextureData(std::string_view line) {
+        float u = GetFloatValue(NextToken(line));
+        float v = 0, w = 0;
 
-                int normalIndex = indices[2].toInt(); if (normalIndex < 0) throw std::runtime_error("Two dashes - Negative normal index!");
-                normalIndex--;
-                toReturn.normal_indices.push_back(normalIndex);
-            }
+        const std::string_view vToken = NextToken(line);
+        if (!vToken.empty()){
+            v = GetFloatValue(vToken);
         }
-        return toReturn;
+
+        const std::string_view wToken = NextToken(line);
+        if (!wToken.empty()){
+            w = GetFloatValue(wToken);
+        }
+
+        return {u, v, w};
+    }
+
+    glm::vec3 ObjectFileParser::GetNormalData(std::string_view line) {
+        float i = GetFloatValue(NextToken(line));
+        float j = GetFloatValue(NextToken(line));
+        float k = GetFloatValue(NextToken(line));
+
+        return {i, j, k};
     }
 
-    Polygon ObjectFileParser::GetPolygonDataDoubleDash(QStringList list) {
-        Polygon toReturn;
+    // Corners come as v, v/vt, v/vt/vn or v//vn. Faces with fewer than three
+    // corners are dropped.
+    void ObjectFileParser::AppendPolygonData(std::string_view line, ObjectFileChunk& chunk) {
         {
-            for (qsizetype itemIndex = 1; itemIndex < list.size(); ++itemIndex){
-                QStringList indices = list[itemIndex].split("//", Qt::SkipEmptyParts);
+            std::string_view cornerTokens = line;
+            size_t cornerCount = 0;
+            while (cornerCount < 3 && !NextToken(cornerTokens).empty()) ++cornerCount;
+            if (cornerCount < 3) return;
+        }
+
+        uint32_t polygonCornerCount = 0;
+        for (std::string_view cornerToken = NextToken(line); !cornerToken.empty(); cornerToken = NextToken(line)){
+            bool relativeVertex = false, relativeTexture = false, relativeNormal = false;
+
+            const size_t firstSlash = cornerToken.find('/');
+            const int vertexIndex = GetIndexValue(cornerToken.substr(0, firstSlash), "vertex",
+                                                  chunk.vertices.size(), relativeVertex);
+
+            int textureIndex = VertexWelder::NO_INDEX;
+            int normalIndex = VertexWelder::NO_INDEX;
 
-                int vertexIndex = indices[0].toInt(); if (vertexIndex < 0) throw std::runtime_error("One dash - Negative vertex index!");
-                vertexIndex--;
-                toReturn.vertex_indices.push_back(vertexIndex);
+            if (firstSlash != std::string_view::npos){
+                const std::string_view textureAndNormal = cornerToken.substr(firstSlash + 1);
+                const size_t secondSlash = textureAndNormal.find('/');
 
-                int normalIndex = indices[1].toInt(); if (normalIndex < 0) throw std::runtime_error("Two dashes - Negative normal index!");
-                normalIndex--;
-                toReturn.normal_indices.push_back(normalIndex);
+                textureIndex = GetIndexValue(textureAndNormal.substr(0, secondSlash), "texture",
+                                             chunk.vertexTextures.size(), relativeTexture);
+                if (secondSlash != std::string_view::npos){
+                    normalIndex = GetIndexValue(textureAndNormal.substr(secondSlash + 1), "normal",
+                                                chunk.vertexNormals.size(), relativeNormal);
+                }
             }
+
+            const uint8_t relativeMask = (relativeVertex ? 1 : 0) | (relativeTexture ? 2 : 0) | (relativeNormal ? 4 : 0);
+            chunk.corners.push_back({ { vertexIndex, textureIndex, normalIndex }, relativeMask });
+            ++polygonCornerCount;
         }
-        return toReturn;
+
+        chunk.polygonCornerCounts.push_back(polygonCornerCount);
     }
 
     float GetRadianAngle(float degreeAngle) {
@@ -193,17 +365,75 @@ SceneData ObjectFileParser::GetSceneDataFromObjectFile(QString filePath) {
                         {0,  -sineValue, cosineValue});
     }
 
-    void ObjectFileParser::DoApplyYZAxesFix(SceneData &sceneData) {
-        auto fixMatrix = GetYZAxesFix();
+    void ObjectFileParser::DoApplyYZAxesFix(SceneData &sceneData, ThreadPool& threadPool) {
+        constexpr size_t FIX_BLOCK_SIZE = 1 << 16;
+        const auto fixMatrix = GetYZAxesFix();
 
-        for (auto& pointGlmVector : sceneData.vertices){
-            auto pointFixed = fixMatrix * pointGlmVector;
-            pointGlmVector = pointFixed;
+        for (auto* glmVectors : { &sceneData.vertices, &sceneData.vertex_normals }){
+            const size_t blockCount = (glmVectors->size() + FIX_BLOCK_SIZE - 1) / FIX_BLOCK_SIZE;
+
+            threadPool.ParallelFor(blockCount, [&](size_t blockIndex){
+                const auto blockBegin = glmVectors->begin() + blockIndex * FIX_BLOCK_SIZE;
+                const auto blockEnd = glmVectors->begin() + min((blockIndex + 1) * FIX_BLOCK_SIZE, glmVectors->size());
+
+                for (auto glmVector = blockBegin; glmVector != blockEnd; ++glmVector){
+                    *glmVector = fixMatrix * *glmVector;
+                }
+            });
         }
+    }
+
+    // Windows are cut at line breaks and split into chunks the same way as
+    // the whole file is for GetSceneDataFromObjectFile.
+    void ObjectFileParser::ReadObjectFileChunks(const std::string& filePath,
+                                                const std::function<void(const ObjectFileChunk&)>& chunkHandler) {
+        const MappedFile objectFile(filePath);
+        std::string_view fileText = objectFile.GetView();
+
+        const size_t threadCount = max<size_t>(thread::hardware_concurrency(), 1);
+        const size_t chunksPerWindow = threadCount * CHUNKS_PER_THREAD;
+        const size_t windowSize = chunksPerWindow * MIN_CHUNK_SIZE;
+        ThreadPool threadPool(threadCount);
+
+        const auto fixMatrix = GetYZAxesFix();
+        std::array<size_t, 3> elementCounts = {};
+
+        while (!fileText.empty()){
+            size_t windowEnd = fileText.size();
+            if (windowEnd > windowSize){
+                const size_t lineBreak = fileText.find('\n', windowSize);
+                if (lineBreak != std::string_view::npos) windowEnd = lineBreak + 1;
+            }
+
+            const size_t chunkCount = clamp<size_t>(windowEnd / MIN_CHUNK_SIZE, 1, chunksPerWindow);
+            std::vector<ObjectFileChunk> chunks = SplitIntoChunks(fileText.substr(0, windowEnd), chunkCount);
+            fileText.remove_prefix(windowEnd);
+
+            threadPool.ParallelFor(chunks.size(), [&](size_t chunkIndex){
+                ParseChunk(chunks[chunkIndex]);
+            });
+
+            for (ObjectFileChunk& chunk : chunks){
+                chunk.elementOffsets = elementCounts;
 
-        for (auto& normalGlmVector : sceneData.vertex_normals){
-            auto normalFixed = fixMatrix * normalGlmVector;
-            normalGlmVector = normalFixed;
+                elementCounts[0] += chunk.vertices.size();
+                elementCounts[1] += chunk.vertexTextures.size();
+                elementCounts[2] += chunk.vertexNormals.size();
+            }
+
+            threadPool.ParallelFor(chunks.size(), [&](size_t chunkIndex){
+                ObjectFileChunk& chunk = chunks[chunkIndex];
+                ResolveRelativeIndices(chunk);
+
+                if (do_apply_yz_axes_fix_){
+                    for (glm::vec3& vertex : chunk.vertices) vertex = fixMatrix * vertex;
+                    for (glm::vec3& vertexNormal : chunk.vertexNormals) vertexNormal = fixMatrix * vertexNormal;
+                }
+            });
+
+            for (const ObjectFileChunk& chunk : chunks){
+                chunkHandler(chunk);
+            }
         }
     }
 
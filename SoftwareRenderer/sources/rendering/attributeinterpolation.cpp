@@ -1,9 +1,20 @@
 #include "headers/rendering/attributeinterpolation.h"
+#include <algorithm>
+#include <limits>
 #include <stdexcept>
 using namespace std;
 
 namespace pv {
 
+  AttributeInterpolation::AttributeInterpolation() :
+      depth_setup_{},
+      normal_interpolation_needed_(false),
+      camera_space_interpolation_needed_(false),
+      texture_coord_interpolation_needed_(false),
+      normal_gradient_{},
+      camera_space_gradient_{},
+      texture_coord_gradient_{} { }
+
   void AttributeInterpolation::InterpolateDepthOverLine(
       std::vector<InterpolationPoint> & interpolationPoints,
       const ViewportPoint &firstPoint, const ViewportPoint &secondPoint) {
@@ -22,156 +33,141 @@ namespace pv {
 
 }
 
-std::vector<ShadedPixel> AttributeInterpolation::GetPixelsWithInterpolatedDepth(
-        const std::vector<InterpolationPoint>& interpolationPoints,
+void AttributeInterpolation::SetTriangle(
         const ViewportPoint &firstPoint,
         const ViewportPoint &secondPoint,
         const ViewportPoint &thirdPoint,
 
+        const std::array<VertexAttributes, 3>* vertexAttributesPtr,
         bool normalInterpolationNeeded,
-        std::vector<glm::vec3>* normalVectorsPtr,
-        std::vector<glm::vec3>* interpolatedNormalVectorsPtr,
-
         bool cameraSpaceInterpolationNeeded,
-        std::vector<glm::vec3>* cameraSpacePosPtr,
-        std::vector<glm::vec3>* interpolatedCameraSpacePosPtr,
-
-        bool textureCoordInterpolationNeeded,
-        std::vector<glm::vec3>* textureCoordsPtr,
-        std::vector<glm::vec3>* interpolatedTextureCoordsPtr)
+        bool textureCoordInterpolationNeeded)
 {
-    vector<ShadedPixel> toReturn; toReturn.reserve(interpolationPoints.size());
-    constexpr array<uchar, 4> blackColor{255, 0, 0, 0};
-
     const double inverseW1 = firstPoint.w;
     const double inverseW2 = secondPoint.w;
     const double inverseW3 = thirdPoint.w;
 
-    const double x0 = firstPoint.x;
-    const double y0 = firstPoint.y;
+    depth_setup_ = { inverseW1, inverseW2 - inverseW1, inverseW3 - inverseW1 };
 
-    const double x1 = secondPoint.x;
-    const double y1 = secondPoint.y;
+    if ((normalInterpolationNeeded || cameraSpaceInterpolationNeeded || textureCoordInterpolationNeeded) &&
+         vertexAttributesPtr == nullptr)
+    {
+        throw std::runtime_error("Vertex attributes are required for attribute interpolation!");
+    }
 
-    const double x2 = thirdPoint.x;
-    const double y2 = thirdPoint.y;
+    normal_interpolation_needed_ = normalInterpolationNeeded;
+    camera_space_interpolation_needed_ = cameraSpaceInterpolationNeeded;
+    texture_coord_interpolation_needed_ = textureCoordInterpolationNeeded;
 
-    const double triangleArea = 0.5 * abs(static_cast<double>((x2 - x0) * (y1 - y0) - (y2 - y0) * (x1 - x0)));
+    if (normal_interpolation_needed_){
+        const auto& vertexAttributes = *vertexAttributesPtr;
+        normal_gradient_ = GetAttributeGradient(vertexAttributes[0].normal * static_cast<float>(inverseW1),
+                                                vertexAttributes[1].normal * static_cast<float>(inverseW2),
+                                                vertexAttributes[2].normal * static_cast<float>(inverseW3));
+    }
 
-    size_t interpPointIdx = 0;
-    for (auto& interpolationPoint : interpolationPoints) {
-        double interpolatedDepth = std::numeric_limits<double>::max();
-        const double qx = interpolationPoint.x;
-        const double qy = interpolationPoint.y;
+    if (camera_space_interpolation_needed_){
+        const auto& vertexAttributes = *vertexAttributesPtr;
+        camera_space_gradient_ = GetAttributeGradient(vertexAttributes[0].cameraSpacePosition * static_cast<float>(inverseW1),
+                                                      vertexAttributes[1].cameraSpacePosition * static_cast<float>(inverseW2),
+                                                      vertexAttributes[2].cameraSpacePosition * static_cast<float>(inverseW3));
+    }
 
-        const double uArea = 0.5 * abs(static_cast<double>(( (x2 - x0) * (qy - y0) - (y2 - y0) * (qx - x0) )));
-        const double vArea = 0.5 * abs(static_cast<double>(( (qx - x0) * (y1 - y0) - (qy - y0) * (x1 - x0) )));
+    if (texture_coord_interpolation_needed_){
+        const auto& vertexAttributes = *vertexAttributesPtr;
+        texture_coord_gradient_ = GetAttributeGradient(vertexAttributes[0].textureCoord * static_cast<float>(inverseW1),
+                                                       vertexAttributes[1].textureCoord * static_cast<float>(inverseW2),
+                                                       vertexAttributes[2].textureCoord * static_cast<float>(inverseW3));
+    }
+}
 
-        double u = uArea / triangleArea;
-        double v = vArea / triangleArea;
+std::array<VertexAttributes, 3> AttributeInterpolation::GetClippedVertexAttributes(
+        const std::array<VertexAttributes, 3> &sourceAttributes,
+        const SourceVertexWeights &sourceWeights)
+{
+    std::array<VertexAttributes, 3> clippedAttributes;
 
-        constexpr double RELEVANT_BARYCENTRIC_COORD = 0.0000001;
-        if (u < RELEVANT_BARYCENTRIC_COORD ||
-            v < RELEVANT_BARYCENTRIC_COORD ||
-            1.0 - u - v < RELEVANT_BARYCENTRIC_COORD){
+    for (size_t vertexIdx = 0; vertexIdx < 3; ++vertexIdx){
+        const glm::vec3& weights = sourceWeights[vertexIdx];
+        auto& attributes = clippedAttributes[vertexIdx];
 
-            interpolatedDepth = std::numeric_limits<double>::max();
-            toReturn.push_back(
-                        ShadedPixel {
-                                InterpolationPoint{interpolationPoint.x, interpolationPoint.y, interpolatedDepth},
-                                ShadeColor{blackColor}
-                        });
+        attributes.normal = sourceAttributes[0].normal * weights[0] +
+                            sourceAttributes[1].normal * weights[1] +
+                            sourceAttributes[2].normal * weights[2];
 
-            interpPointIdx++;
-            continue;
-        }
+        attributes.cameraSpacePosition = sourceAttributes[0].cameraSpacePosition * weights[0] +
+                                         sourceAttributes[1].cameraSpacePosition * weights[1] +
+                                         sourceAttributes[2].cameraSpacePosition * weights[2];
 
-        double inverseDepthValue = inverseW1 * (1 - u - v) + inverseW2 * u + inverseW3 * v;
-
-        if (inverseDepthValue < 0.0){
-            interpolatedDepth = std::numeric_limits<double>::max();
-            toReturn.push_back(
-                        ShadedPixel {
-                                InterpolationPoint{interpolationPoint.x, interpolationPoint.y, interpolatedDepth},
-                                ShadeColor{blackColor}
-                        });
-        } else {
-            interpolatedDepth = 1.0 / inverseDepthValue;
-            toReturn.push_back(
-                        ShadedPixel {
-                                InterpolationPoint{interpolationPoint.x, interpolationPoint.y, interpolatedDepth},
-                                ShadeColor{blackColor}
-                        });
-        }
+        attributes.textureCoord = sourceAttributes[0].textureCoord * weights[0] +
+                                  sourceAttributes[1].textureCoord * weights[1] +
+                                  sourceAttributes[2].textureCoord * weights[2];
+    }
 
-        //===========================================================================================
-        if (normalInterpolationNeeded) {
-            if  ( (normalVectorsPtr->size() != 3) ||
-                  (interpolatedNormalVectorsPtr->size() != interpolationPoints.size()) )
-            {
-                throw std::runtime_error("Normal Interpolation Invariant violated!");
-            }
+    return clippedAttributes;
+}
 
-            glm::vec3 normal1 = (*normalVectorsPtr)[0];
-            glm::vec3 normal2 = (*normalVectorsPtr)[1];
-            glm::vec3 normal3 = (*normalVectorsPtr)[2];
+SpanMask AttributeInterpolation::InterpolateDepthSpan(const double *u, const double *v, SpanMask mask, double *depth) const {
+    return GetSpanKernels().InterpolateDepth(depth_setup_, u, v, mask, depth);
+}
 
-            glm::vec3 interpolatedNormal =
-                    normal1 * static_cast<float>(inverseW1) * static_cast<float>(1 - u - v) +
-                    normal2 * static_cast<float>(inverseW2) * static_cast<float>(u) +
-                    normal3 * static_cast<float>(inverseW3) * static_cast<float>(v);
+double AttributeInterpolation::GetNearestDepth() const {
+    return GetConservativeDepth(GetMaxVertexInverseDepth());
+}
 
-            interpolatedNormal *= interpolatedDepth;
+double AttributeInterpolation::GetNearestDepth(const double (&cornerU)[4], const double (&cornerV)[4]) const {
+    // 1/w is linear in screen space, so over a block it peaks at one of the corners.
+    double maxCornerInverseDepth = -numeric_limits<double>::max();
+    for (int corner = 0; corner < 4; ++corner){
+        const double inverseDepth = depth_setup_.inverseWOrigin +
+                                    depth_setup_.inverseWUDelta * cornerU[corner] +
+                                    depth_setup_.inverseWVDelta * cornerV[corner];
+        maxCornerInverseDepth = max(maxCornerInverseDepth, inverseDepth);
+    }
 
-            (*interpolatedNormalVectorsPtr)[interpPointIdx] = interpolatedNormal;
-        }
-        //===========================================================================================
-        if (cameraSpaceInterpolationNeeded) {
-            if  ( (cameraSpacePosPtr->size() != 3) ||
-                  (interpolatedCameraSpacePosPtr->size() != interpolationPoints.size()) )
-            {
-                throw std::runtime_error("Camera Space Interpolation Invariant violated!");
-            }
-
-            glm::vec3 camera1 = (*cameraSpacePosPtr)[0];
-            glm::vec3 camera2 = (*cameraSpacePosPtr)[1];
-            glm::vec3 camera3 = (*cameraSpacePosPtr)[2];
-
-            glm::vec3 interpolatedPointCamera =
-                    camera1 * static_cast<float>(inverseW1) * static_cast<float>(1 - u - v) +
-                    camera2 * static_cast<float>(inverseW2) * static_cast<float>(u) +
-                    camera3 * static_cast<float>(inverseW3) * static_cast<float>(v);
-
-            interpolatedPointCamera *= interpolatedDepth;
-
-            (*interpolatedCameraSpacePosPtr)[interpPointIdx] = interpolatedPointCamera;
-        }
-        //===========================================================================================
-        if (textureCoordInterpolationNeeded) {
-            if  ( (textureCoordsPtr->size() != 3) ||
-                  (interpolatedTextureCoordsPtr->size() != interpolationPoints.size()) )
-            {
-                throw std::runtime_error("Texture Coordinates Interpolation Invariant violated!");
-            }
-
-            glm::vec3 textureCoord1 = (*textureCoordsPtr)[0]; //cerr << textureCoord1.x << " " << textureCoord1.y << " " << textureCoord1.z << endl;
-            glm::vec3 textureCoord2 = (*textureCoordsPtr)[1]; //cerr << textureCoord2.x << " " << textureCoord2.y << " " << textureCoord2.z << endl;
-            glm::vec3 textureCoord3 = (*textureCoordsPtr)[2]; //cerr << textureCoord3.x << " " << textureCoord3.y << " " << textureCoord3.z << endl;
-
-            glm::vec3 interpolatedTextureCoord =
-                    textureCoord1 * static_cast<float>(inverseW1) * static_cast<float>(1 - u - v) +
-                    textureCoord2 * static_cast<float>(inverseW2) * static_cast<float>(u) +
-                    textureCoord3 * static_cast<float>(inverseW3) * static_cast<float>(v);
-
-            interpolatedTextureCoord *= interpolatedDepth;
-
-            (*interpolatedTextureCoordsPtr)[interpPointIdx] = interpolatedTextureCoord;
-        }
-        //===========================================================================================
-        interpPointIdx++;
+    return GetConservativeDepth(min(maxCornerInverseDepth, GetMaxVertexInverseDepth()));
+}
+
+double AttributeInterpolation::GetMaxVertexInverseDepth() const {
+    return max({ depth_setup_.inverseWOrigin,
+                 depth_setup_.inverseWOrigin + depth_setup_.inverseWUDelta,
+                 depth_setup_.inverseWOrigin + depth_setup_.inverseWVDelta });
+}
+
+double AttributeInterpolation::GetConservativeDepth(double maxInverseDepth) const {
+    // Pulled slightly towards the eye so rounding in the per-pixel path can never
+    // land in front of the bound.
+    constexpr double ROUNDING_MARGIN = 1e-9;
+
+    if (maxInverseDepth <= 0.0) return 0.0;
+    return (1.0 - ROUNDING_MARGIN) / maxInverseDepth;
+}
+
+void AttributeInterpolation::InterpolateAttributes(double u, double v, InterpolatedFragment &fragment) const {
+    const float fu = static_cast<float>(u);
+    const float fv = static_cast<float>(v);
+    const float depth = static_cast<float>(fragment.interpolatedPoint.z);
+
+    if (normal_interpolation_needed_){
+        fragment.normal = GetInterpolatedAttribute(normal_gradient_, fu, fv, depth);
+    }
+
+    if (camera_space_interpolation_needed_){
+        fragment.cameraSpacePosition = GetInterpolatedAttribute(camera_space_gradient_, fu, fv, depth);
+    }
+
+    if (texture_coord_interpolation_needed_){
+        fragment.textureCoord = GetInterpolatedAttribute(texture_coord_gradient_, fu, fv, depth);
     }
+}
+
+AttributeInterpolation::AttributeGradient
+AttributeInterpolation::GetAttributeGradient(const glm::vec3 &first, const glm::vec3 &second, const glm::vec3 &third) const {
+    return { first, second - first, third - first };
+}
 
-    return toReturn;
+glm::vec3 AttributeInterpolation::GetInterpolatedAttribute(const AttributeGradient &gradient, float u, float v, float depth) const {
+    return (gradient.origin + gradient.uDelta * u + gradient.vDelta * v) * depth;
 }
 
 } // namespace pv
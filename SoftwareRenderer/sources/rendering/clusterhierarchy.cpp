@@ -0,0 +1,149 @@
+#include "headers/rendering/clusterhierarchy.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace pv {
+
+    void ClusterHierarchy::Build(const SceneData& sceneData, size_t polygonsPerCluster) {
+        if (polygonsPerCluster == 0) throw runtime_error("A cluster must hold at least one polygon");
+
+        const size_t polygonCount = sceneData.GetPolygonCount();
+        if (polygonCount > UINT32_MAX) throw runtime_error("Too many polygons for a cluster hierarchy");
+
+        nodes_.clear();
+        clusters_.clear();
+        cluster_vertex_blocks_.clear();
+        cluster_polygons_.resize(polygonCount);
+
+        vector<glm::vec3> centroids(polygonCount);
+        for (size_t polygonIndex = 0; polygonIndex < polygonCount; ++polygonIndex){
+            const int* corners = sceneData.vertex_indices.data() + sceneData.GetFirstCorner(polygonIndex);
+            const size_t cornerCount = sceneData.GetCornerCount(polygonIndex);
+
+            glm::vec3 cornerSum(0.0F);
+            for (size_t idx = 0; idx < cornerCount; ++idx){
+                cornerSum += sceneData.vertices[corners[idx]];
+            }
+            centroids[polygonIndex] = cornerSum / static_cast<float>(max<size_t>(cornerCount, 1));
+            cluster_polygons_[polygonIndex] = static_cast<uint32_t>(polygonIndex);
+        }
+
+        if (polygonCount > 0){
+            BuildNode(sceneData, centroids, 0, polygonCount, polygonsPerCluster);
+        }
+    }
+
+    uint32_t ClusterHierarchy::BuildNode(
+            const SceneData& sceneData,
+            const std::vector<glm::vec3>& centroids,
+            size_t rangeBegin, size_t rangeEnd,
+            size_t polygonsPerCluster)
+    {
+        const uint32_t nodeIndex = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back({ BoundingBox{}, 0, static_cast<uint32_t>(clusters_.size()), 0 });
+
+        if (rangeEnd - rangeBegin <= polygonsPerCluster){
+            AddCluster(sceneData, rangeBegin, rangeEnd, nodes_[nodeIndex]);
+            return nodeIndex;
+        }
+
+        BoundingBox centroidBounds;
+        for (size_t idx = rangeBegin; idx < rangeEnd; ++idx){
+            centroidBounds.Extend(centroids[cluster_polygons_[idx]]);
+        }
+        const glm::vec3 extent = centroidBounds.GetExtent();
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+        const size_t rangeMiddle = rangeBegin + (rangeEnd - rangeBegin) / 2;
+        nth_element(cluster_polygons_.begin() + rangeBegin,
+                    cluster_polygons_.begin() + rangeMiddle,
+                    cluster_polygons_.begin() + rangeEnd,
+                    [&centroids, axis](uint32_t first, uint32_t second){
+                        return centroids[first][axis] < centroids[second][axis];
+                    });
+
+        const uint32_t firstChild = BuildNode(sceneData, centroids, rangeBegin, rangeMiddle, polygonsPerCluster);
+        const uint32_t secondChild = BuildNode(sceneData, centroids, rangeMiddle, rangeEnd, polygonsPerCluster);
+
+        Node& node = nodes_[nodeIndex];
+        node.bounds = nodes_[firstChild].bounds;
+        node.bounds.Extend(nodes_[secondChild].bounds);
+        node.secondChild = secondChild;
+        node.clusterCount = static_cast<uint32_t>(clusters_.size()) - node.firstCluster;
+        return nodeIndex;
+    }
+
+    void ClusterHierarchy::AddCluster(const SceneData& sceneData, size_t rangeBegin, size_t rangeEnd, Node& leaf) {
+        sort(cluster_polygons_.begin() + rangeBegin, cluster_polygons_.begin() + rangeEnd);
+
+        Cluster cluster{};
+        cluster.firstPolygon = static_cast<uint32_t>(rangeBegin);
+        cluster.polygonCount = static_cast<uint32_t>(rangeEnd - rangeBegin);
+        cluster.firstVertexBlock = static_cast<uint32_t>(cluster_vertex_blocks_.size());
+
+        for (size_t idx = rangeBegin; idx < rangeEnd; ++idx){
+            const size_t polygonIndex = cluster_polygons_[idx];
+            const int* corners = sceneData.vertex_indices.data() + sceneData.GetFirstCorner(polygonIndex);
+            const size_t cornerCount = sceneData.GetCornerCount(polygonIndex);
+
+            for (size_t corner = 0; corner < cornerCount; ++corner){
+                cluster.bounds.Extend(sceneData.vertices[corners[corner]]);
+                cluster_vertex_blocks_.push_back(static_cast<uint32_t>(corners[corner] / VERTEX_BLOCK_SIZE));
+            }
+        }
+
+        const auto blocksBegin = cluster_vertex_blocks_.begin() + cluster.firstVertexBlock;
+        sort(blocksBegin, cluster_vertex_blocks_.end());
+        cluster_vertex_blocks_.erase(unique(blocksBegin, cluster_vertex_blocks_.end()), cluster_vertex_blocks_.end());
+        cluster.vertexBlockCount = static_cast<uint32_t>(cluster_vertex_blocks_.size()) - cluster.firstVertexBlock;
+
+        leaf.bounds = cluster.bounds;
+        leaf.clusterCount = 1;
+        clusters_.push_back(cluster);
+    }
+
+    void ClusterHierarchy::GetVisibleClusters(const Frustum& frustum, std::vector<uint32_t>& visibleClusters) const {
+        visibleClusters.clear();
+        if (nodes_.empty()) return;
+
+        // Depth first, first child first, which visits the clusters in ascending order.
+        vector<uint32_t> pendingNodes { 0 };
+        while (!pendingNodes.empty()){
+            const uint32_t nodeIndex = pendingNodes.back();
+            const Node& node = nodes_[nodeIndex];
+            pendingNodes.pop_back();
+
+            if (!frustum.IntersectsBox(node.bounds)) continue;
+
+            // Everything below a node that lies wholly in view is visible as well.
+            if (node.secondChild == 0 || frustum.ContainsBox(node.bounds)){
+                for (uint32_t clusterIndex = node.firstCluster; clusterIndex < node.firstCluster + node.clusterCount; ++clusterIndex){
+                    visibleClusters.push_back(clusterIndex);
+                }
+                continue;
+            }
+
+            pendingNodes.push_back(node.secondChild);
+            pendingNodes.push_back(nodeIndex + 1);
+        }
+    }
+
+    size_t ClusterHierarchy::GetClusterCount() const {
+        return clusters_.size();
+    }
+
+    const ClusterHierarchy::Cluster& ClusterHierarchy::GetCluster(size_t clusterIndex) const {
+        return clusters_[clusterIndex];
+    }
+
+    const std::vector<uint32_t>& ClusterHierarchy::GetClusterPolygons() const {
+        return cluster_polygons_;
+    }
+
+    const std::vector<uint32_t>& ClusterHierarchy::GetClusterVertexBlocks() const {
+        return cluster_vertex_blocks_;
+    }
+
+} // namespace pv
@@ -2,20 +2,125 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
+#include <type_traits>
 
 namespace pv {
 
+    // GetDistanceKey maps a stored value onto a scale that grows away from the eye,
+    // which is what the per-block farthest depth is kept in.
+    template<DEPTH_FORMAT FORMAT> struct DepthFormatTraits;
+
+    template<> struct DepthFormatTraits<DEPTH_FORMAT::FLOAT64> {
+        using StoredDepth = double;
+        static constexpr StoredDepth CLEAR_VALUE = std::numeric_limits<double>::max();
+
+        static StoredDepth Encode(double z, double, double) {
+            return z;
+        }
+
+        static double GetDistanceKey(StoredDepth depth) {
+            return depth;
+        }
+
+        static bool IsCloser(StoredDepth depth, StoredDepth storedDepth, bool acceptEqual) {
+            return acceptEqual ? depth <= storedDepth : depth < storedDepth;
+        }
+
+        static SpanMask TestSpan(const StoredDepth* storedDepth, const StoredDepth* depth, SpanMask mask, bool acceptEqual) {
+            return GetSpanKernels().DepthTest(storedDepth, depth, mask, acceptEqual);
+        }
+    };
+
+    template<> struct DepthFormatTraits<DEPTH_FORMAT::FLOAT32_REVERSED_Z> {
+        using StoredDepth = float;
+        static constexpr StoredDepth CLEAR_VALUE = 0.0F;
+
+        static StoredDepth Encode(double z, double near, double) {
+            return static_cast<float>(near / z);
+        }
+
+        static double GetDistanceKey(StoredDepth depth) {
+            return -static_cast<double>(depth);
+        }
+
+        static bool IsCloser(StoredDepth depth, StoredDepth storedDepth, bool acceptEqual) {
+            return acceptEqual ? depth >= storedDepth : depth > storedDepth;
+        }
+
+        static SpanMask TestSpan(const StoredDepth* storedDepth, const StoredDepth* depth, SpanMask mask, bool acceptEqual) {
+            return GetSpanKernels().DepthTestReversedFloat(storedDepth, depth, mask, acceptEqual);
+        }
+    };
+
+    template<> struct DepthFormatTraits<DEPTH_FORMAT::UNORM24> {
+        using StoredDepth = uint32_t;
+        static constexpr StoredDepth CLEAR_VALUE = 0xFFFFFF;
+
+        static StoredDepth Encode(double z, double near, double far) {
+            const double windowDepth = far / (far - near) * (1.0 - near / z);
+            return static_cast<StoredDepth>(std::lround(std::clamp(windowDepth, 0.0, 1.0) * CLEAR_VALUE));
+        }
+
+        static double GetDistanceKey(StoredDepth depth) {
+            return static_cast<double>(depth);
+        }
+
+        static bool IsCloser(StoredDepth depth, StoredDepth storedDepth, bool acceptEqual) {
+            return acceptEqual ? depth <= storedDepth : depth < storedDepth;
+        }
+
+        static SpanMask TestSpan(const StoredDepth* storedDepth, const StoredDepth* depth, SpanMask mask, bool acceptEqual) {
+            return GetSpanKernels().DepthTestUnorm(storedDepth, depth, mask, acceptEqual);
+        }
+    };
+
+    template<DEPTH_FORMAT FORMAT>
+    inline typename DepthFormatTraits<FORMAT>::StoredDepth* GetDepthBuffer(uchar* depthBuffer) {
+        return reinterpret_cast<typename DepthFormatTraits<FORMAT>::StoredDepth*>(depthBuffer);
+    }
+
+    template<DEPTH_FORMAT FORMAT>
+    inline const typename DepthFormatTraits<FORMAT>::StoredDepth* GetDepthBuffer(const uchar* depthBuffer) {
+        return reinterpret_cast<const typename DepthFormatTraits<FORMAT>::StoredDepth*>(depthBuffer);
+    }
+
+    // Calls visitor with the format as a compile-time constant, so the per-pixel
+    // depth code is instantiated once per format instead of branching on it.
+    template<typename Visitor>
+    inline auto VisitDepthFormat(DEPTH_FORMAT depthFormat, Visitor&& visitor) {
+        switch (depthFormat){
+            case DEPTH_FORMAT::FLOAT32_REVERSED_Z:
+                return visitor(std::integral_constant<DEPTH_FORMAT, DEPTH_FORMAT::FLOAT32_REVERSED_Z>{});
+            case DEPTH_FORMAT::UNORM24:
+                return visitor(std::integral_constant<DEPTH_FORMAT, DEPTH_FORMAT::UNORM24>{});
+            default:
+                return visitor(std::integral_constant<DEPTH_FORMAT, DEPTH_FORMAT::FLOAT64>{});
+        }
+    }
+
     FrameBuffer::FrameBuffer(size_t width, size_t height, COLOR_MODEL clrModel) :
         components_count_(MODEL_COMPONENTS_COUNT[static_cast<int>(clrModel)]),
         buffer_pointer_(new uchar[width * height * components_count_]),
+        owns_color_buffer_(true),
         width_(width),
         height_(height),
-        depth_buffer_pointer_(nullptr){ }
+        clear_color_word_(0),
+        depth_buffer_pointer_(nullptr),
+        depth_format_(DEPTH_FORMAT::FLOAT64),
+        depth_near_(0.0),
+        depth_far_(1.0),
+        depth_blocks_x_(0),
+        depth_blocks_y_(0)
+    {
+        ResetColorTiles();
+    }
 
     FrameBuffer::~FrameBuffer() {
-        delete[] buffer_pointer_;
-        buffer_pointer_ = nullptr;
+        ReleaseColorBuffer();
 
         if (depth_buffer_pointer_){
             delete[] depth_buffer_pointer_;
@@ -23,16 +128,143 @@ namespace pv {
         }
     }
 
-    void FrameBuffer::CopyToUcharArray(uchar *extBuffer) const {
-        std::copy(buffer_pointer_,
-                  buffer_pointer_ + width_ * height_ * components_count_,
-                  extBuffer);
+    void FrameBuffer::AttachColorBuffer(uchar *externalBuffer, size_t width, size_t height, bool contentsPreserved) {
+        if (externalBuffer == nullptr){
+            throw std::runtime_error("External color buffer is null!");
+        }
+
+        const bool bufferChanged = (externalBuffer != buffer_pointer_ || !contentsPreserved);
+
+        ReleaseColorBuffer();
+        buffer_pointer_ = externalBuffer;
+        owns_color_buffer_ = false;
+
+        if (width != width_ || height != height_){
+            width_ = width;
+            height_ = height;
+            ResetColorTiles();
+            ReallocateDepthBuffer();
+        } else if (bufferChanged){
+            ResetColorTiles();
+        }
+    }
+
+    void FrameBuffer::ReleaseColorBuffer() {
+        if (owns_color_buffer_){
+            delete[] buffer_pointer_;
+        }
+        buffer_pointer_ = nullptr;
+        owns_color_buffer_ = false;
+    }
+
+    void FrameBuffer::ResetColorTiles() {
+        color_tile_states_.assign(GetClearTileCount(), TILE_STATE::DRAWN);
+    }
+
+    size_t FrameBuffer::GetClearTileCount() const {
+        return ((width_ + CLEAR_TILE_SIZE - 1) / CLEAR_TILE_SIZE) *
+               ((height_ + CLEAR_TILE_SIZE - 1) / CLEAR_TILE_SIZE);
+    }
+
+    size_t FrameBuffer::GetClearTileIndex(size_t x, size_t y) const {
+        return x / CLEAR_TILE_SIZE + (y / CLEAR_TILE_SIZE) * ((width_ + CLEAR_TILE_SIZE - 1) / CLEAR_TILE_SIZE);
+    }
+
+    ScreenRect FrameBuffer::GetClearTileRect(size_t tileIndex) const {
+        const size_t tilesX = (width_ + CLEAR_TILE_SIZE - 1) / CLEAR_TILE_SIZE;
+        const size_t minX = (tileIndex % tilesX) * CLEAR_TILE_SIZE;
+        const size_t minY = (tileIndex / tilesX) * CLEAR_TILE_SIZE;
+
+        return { static_cast<int>(minX), static_cast<int>(minY),
+                 static_cast<int>(std::min(minX + CLEAR_TILE_SIZE, width_)) - 1,
+                 static_cast<int>(std::min(minY + CLEAR_TILE_SIZE, height_)) - 1 };
+    }
+
+    void FrameBuffer::ResolveColorTile(size_t tileIndex) const {
+        const ScreenRect tileRect = GetClearTileRect(tileIndex);
+        uint32_t* colorWords = reinterpret_cast<uint32_t*>(buffer_pointer_);
+
+        for (int y = tileRect.minY; y <= tileRect.maxY; ++y){
+            std::fill(colorWords + tileRect.minX + y * width_,
+                      colorWords + tileRect.maxX + 1 + y * width_,
+                      clear_color_word_);
+        }
+    }
+
+    inline void FrameBuffer::PrepareColorWrite(size_t x, size_t y) {
+        TILE_STATE& tileState = color_tile_states_[GetClearTileIndex(x, y)];
+
+        if (tileState != TILE_STATE::DRAWN){
+            if (tileState == TILE_STATE::CLEAR_PENDING){
+                ResolveColorTile(GetClearTileIndex(x, y));
+            }
+            tileState = TILE_STATE::DRAWN;
+        }
+    }
+
+    void FrameBuffer::ResolveClears() const {
+        for (size_t tileIndex = 0; tileIndex < color_tile_states_.size(); ++tileIndex){
+            if (color_tile_states_[tileIndex] == TILE_STATE::CLEAR_PENDING){
+                ResolveColorTile(tileIndex);
+                color_tile_states_[tileIndex] = TILE_STATE::CLEARED;
+            }
+        }
+    }
+
+    template<DEPTH_FORMAT FORMAT>
+    void FrameBuffer::PrepareDepthAccess(size_t x, size_t y, bool write) const {
+        const size_t tileIndex = GetClearTileIndex(x, y);
+        TILE_STATE& tileState = depth_tile_states_[tileIndex];
+
+        if (tileState == TILE_STATE::CLEAR_PENDING){
+            const ScreenRect tileRect = GetClearTileRect(tileIndex);
+            auto* depthBuffer = GetDepthBuffer<FORMAT>(depth_buffer_pointer_);
+
+            for (int y = tileRect.minY; y <= tileRect.maxY; ++y){
+                std::fill(depthBuffer + tileRect.minX + y * width_,
+                          depthBuffer + tileRect.maxX + 1 + y * width_,
+                          DepthFormatTraits<FORMAT>::CLEAR_VALUE);
+            }
+            tileState = TILE_STATE::CLEARED;
+        }
+
+        if (write){
+            tileState = TILE_STATE::DRAWN;
+        }
+    }
+
+    void FrameBuffer::AllocateDepthBuffer() {
+        depth_buffer_pointer_ = new uchar[GetDepthBufferSize()];
+        depth_tile_states_.assign(GetClearTileCount(), TILE_STATE::DRAWN);
+
+        depth_blocks_x_ = (width_ + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE;
+        depth_blocks_y_ = (height_ + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE;
+        block_farthest_depth_.assign(depth_blocks_x_ * depth_blocks_y_, 0.0);
+        block_depth_dirty_.assign(depth_blocks_x_ * depth_blocks_y_, 1);
+    }
+
+    void FrameBuffer::ReallocateDepthBuffer() {
+        if (depth_buffer_pointer_){
+            delete[] depth_buffer_pointer_;
+            AllocateDepthBuffer();
+        }
+    }
+
+    void FrameBuffer::MarkDepthBlockDirty(size_t x, size_t y) {
+        block_depth_dirty_[x / RASTER_BLOCK_SIZE + (y / RASTER_BLOCK_SIZE) * depth_blocks_x_] = 1;
+    }
+
+    size_t FrameBuffer::GetDepthBufferSize() const {
+        return VisitDepthFormat(depth_format_, [this](auto format){
+            return width_ * height_ * sizeof(typename DepthFormatTraits<decltype(format)::value>::StoredDepth);
+        });
     }
 
     void FrameBuffer::DrawPixel(size_t x, size_t y, uchar a, uchar r, uchar g, uchar b) {
         if (x <= width_ - 1 &&
             y <= height_ - 1)
         {
+            PrepareColorWrite(x, y);
             size_t index = (x + y * width_) * components_count_;
 
             buffer_pointer_[index    ] = b;
@@ -46,6 +278,7 @@ namespace pv {
         if (x <= width_ - 1 &&
             y <= height_ - 1)
         {
+            PrepareColorWrite(x, y);
             size_t index = (x + y * width_) * components_count_;
 
             buffer_pointer_[index    ] = argb[3];
@@ -56,14 +289,48 @@ namespace pv {
     }
 
     void FrameBuffer::ZBufferDrawPixel(size_t x, size_t y, double z, const std::array<uchar, 4> &argb) {
+        VisitDepthFormat(depth_format_, [&](auto format){
+            ZBufferDrawPixel<decltype(format)::value>(x, y, z, argb);
+        });
+    }
+
+    SpanMask FrameBuffer::ZBufferTestSpan(size_t x, size_t y, const double *z, SpanMask mask, DEPTH_TEST depthTest) const {
+        return VisitDepthFormat(depth_format_, [&](auto format){
+            return ZBufferTestSpan<decltype(format)::value>(x, y, z, mask, depthTest);
+        });
+    }
+
+    bool FrameBuffer::ZBufferTestRect(const ScreenRect &rect, double nearestDepth, DEPTH_TEST depthTest) const {
+        return VisitDepthFormat(depth_format_, [&](auto format){
+            return ZBufferTestRect<decltype(format)::value>(rect, nearestDepth, depthTest);
+        });
+    }
+
+    void FrameBuffer::ZBufferWriteDepth(size_t x, size_t y, double z) {
+        VisitDepthFormat(depth_format_, [&](auto format){
+            ZBufferWriteDepth<decltype(format)::value>(x, y, z);
+        });
+    }
+
+    template<DEPTH_FORMAT FORMAT>
+    void FrameBuffer::ZBufferDrawPixel(size_t x, size_t y, double z, const std::array<uchar, 4> &argb) {
+        using Traits = DepthFormatTraits<FORMAT>;
+
         if (x <= width_ - 1 &&
             y <= height_ - 1)
         {
             size_t primaryBufferIndex = (x + y * width_) * components_count_;
             size_t depthBufferIndex = (x + y * width_);
 
-            if (z < depth_buffer_pointer_[depthBufferIndex]){
-                depth_buffer_pointer_[depthBufferIndex] = z;
+            PrepareDepthAccess<FORMAT>(x, y, false);
+            auto* depthBuffer = GetDepthBuffer<FORMAT>(depth_buffer_pointer_);
+            const auto depth = Traits::Encode(z, depth_near_, depth_far_);
+
+            if (Traits::IsCloser(depth, depthBuffer[depthBufferIndex], false)){
+                PrepareDepthAccess<FORMAT>(x, y, true);
+                PrepareColorWrite(x, y);
+                depthBuffer[depthBufferIndex] = depth;
+                MarkDepthBlockDirty(x, y);
 
                 buffer_pointer_[primaryBufferIndex    ] = argb[3];
                 buffer_pointer_[primaryBufferIndex + 1] = argb[2];
@@ -73,6 +340,117 @@ namespace pv {
         }
     }
 
+    template<DEPTH_FORMAT FORMAT>
+    bool FrameBuffer::ZBufferTestPixel(size_t x, size_t y, double z, DEPTH_TEST depthTest) const {
+        using Traits = DepthFormatTraits<FORMAT>;
+
+        if (x <= width_ - 1 &&
+            y <= height_ - 1)
+        {
+            PrepareDepthAccess<FORMAT>(x, y, false);
+            const auto storedDepth = GetDepthBuffer<FORMAT>(depth_buffer_pointer_)[x + y * width_];
+            return Traits::IsCloser(Traits::Encode(z, depth_near_, depth_far_), storedDepth,
+                                    depthTest == DEPTH_TEST::LESS_EQUAL);
+        }
+        return false;
+    }
+
+    template<DEPTH_FORMAT FORMAT>
+    SpanMask FrameBuffer::ZBufferTestSpan(size_t x, size_t y, const double *z, SpanMask mask, DEPTH_TEST depthTest) const {
+        using Traits = DepthFormatTraits<FORMAT>;
+
+        // A span never crosses a clear tile, its start is block aligned on this path.
+        if (y < height_ && x + SPAN_WIDTH <= width_ && x % SPAN_WIDTH == 0){
+            PrepareDepthAccess<FORMAT>(x, y, false);
+
+            typename Traits::StoredDepth depth[SPAN_WIDTH];
+            for (int lane = 0; lane < SPAN_WIDTH; ++lane){
+                depth[lane] = (mask & (SpanMask{1} << lane)) ? Traits::Encode(z[lane], depth_near_, depth_far_)
+                                                             : Traits::CLEAR_VALUE;
+            }
+
+            return Traits::TestSpan(GetDepthBuffer<FORMAT>(depth_buffer_pointer_) + x + y * width_, depth, mask,
+                                    depthTest == DEPTH_TEST::LESS_EQUAL);
+        }
+
+        for (int lane = 0; lane < SPAN_WIDTH; ++lane){
+            if ((mask & (SpanMask{1} << lane)) && !ZBufferTestPixel<FORMAT>(x + lane, y, z[lane], depthTest)){
+                mask &= ~(SpanMask{1} << lane);
+            }
+        }
+        return mask;
+    }
+
+    template<DEPTH_FORMAT FORMAT>
+    void FrameBuffer::ZBufferWriteDepth(size_t x, size_t y, double z) {
+        using Traits = DepthFormatTraits<FORMAT>;
+
+        if (x <= width_ - 1 &&
+            y <= height_ - 1)
+        {
+            size_t depthBufferIndex = (x + y * width_);
+
+            PrepareDepthAccess<FORMAT>(x, y, false);
+            auto* depthBuffer = GetDepthBuffer<FORMAT>(depth_buffer_pointer_);
+            const auto depth = Traits::Encode(z, depth_near_, depth_far_);
+
+            if (Traits::IsCloser(depth, depthBuffer[depthBufferIndex], false)){
+                PrepareDepthAccess<FORMAT>(x, y, true);
+                depthBuffer[depthBufferIndex] = depth;
+                MarkDepthBlockDirty(x, y);
+            }
+        }
+    }
+
+    template<DEPTH_FORMAT FORMAT>
+    bool FrameBuffer::ZBufferTestRect(const ScreenRect &rect, double nearestDepth, DEPTH_TEST depthTest) const {
+        using Traits = DepthFormatTraits<FORMAT>;
+
+        const int minX = std::max(rect.minX, 0);
+        const int minY = std::max(rect.minY, 0);
+        const int maxX = std::min(rect.maxX, static_cast<int>(width_) - 1);
+        const int maxY = std::min(rect.maxY, static_cast<int>(height_) - 1);
+        if (minX > maxX || minY > maxY) return false;
+
+        const double nearestKey = Traits::GetDistanceKey(Traits::Encode(nearestDepth, depth_near_, depth_far_));
+
+        for (size_t blockY = minY / RASTER_BLOCK_SIZE; blockY <= static_cast<size_t>(maxY) / RASTER_BLOCK_SIZE; ++blockY){
+            for (size_t blockX = minX / RASTER_BLOCK_SIZE; blockX <= static_cast<size_t>(maxX) / RASTER_BLOCK_SIZE; ++blockX){
+                const double farthestKey = GetBlockFarthestDepthKey<FORMAT>(blockX, blockY);
+
+                if (depthTest == DEPTH_TEST::LESS_EQUAL ? nearestKey <= farthestKey : nearestKey < farthestKey){
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    template<DEPTH_FORMAT FORMAT>
+    double FrameBuffer::GetBlockFarthestDepthKey(size_t blockX, size_t blockY) const {
+        using Traits = DepthFormatTraits<FORMAT>;
+
+        const size_t blockIndex = blockX + blockY * depth_blocks_x_;
+        if (block_depth_dirty_[blockIndex]){
+            const auto* depthBuffer = GetDepthBuffer<FORMAT>(depth_buffer_pointer_);
+
+            const size_t minX = blockX * RASTER_BLOCK_SIZE, maxX = std::min(minX + RASTER_BLOCK_SIZE, width_);
+            const size_t minY = blockY * RASTER_BLOCK_SIZE, maxY = std::min(minY + RASTER_BLOCK_SIZE, height_);
+
+            double farthestKey = -std::numeric_limits<double>::max();
+            for (size_t y = minY; y < maxY; ++y){
+                for (size_t x = minX; x < maxX; ++x){
+                    farthestKey = std::max(farthestKey, Traits::GetDistanceKey(depthBuffer[x + y * width_]));
+                }
+            }
+
+            block_farthest_depth_[blockIndex] = farthestKey;
+            block_depth_dirty_[blockIndex] = 0;
+        }
+
+        return block_farthest_depth_[blockIndex];
+    }
+
     void FrameBuffer::DrawLine(float x1, float y1, float x2, float y2, const std::array<uchar, 4> &argb) {
         size_t integerX1 = x1, integerY1 = y1, integerX2 = x2, integerY2 = y2;
         int deltaX = integerX2 - integerX1;
@@ -95,36 +473,76 @@ namespace pv {
     }
 
     void FrameBuffer::Clear(uchar shade) {
-        std::fill(buffer_pointer_,
-                  buffer_pointer_ + width_ * height_ * components_count_,
-                  shade);
+        // One word per pixel, laid out in memory as b, g, r, a like DrawPixel writes it.
+        const uchar clearPixel[4] = { shade, shade, shade, 0xFF };
+        uint32_t clearColorWord;
+        std::memcpy(&clearColorWord, clearPixel, sizeof(clearColorWord));
 
-        constexpr int alphaStride = 4;
-        const size_t componentsTotal = width_ * height_ * components_count_;
+        const bool clearColorChanged = (clearColorWord != clear_color_word_);
+        clear_color_word_ = clearColorWord;
 
-        for (size_t i = 3; i < componentsTotal; i += alphaStride){
-            buffer_pointer_[i] = 0xFF;
+        for (TILE_STATE& tileState : color_tile_states_){
+            if (tileState == TILE_STATE::DRAWN || clearColorChanged){
+                tileState = TILE_STATE::CLEAR_PENDING;
+            }
         }
     }
 
     void FrameBuffer::ClearZBuffer(){
         if (depth_buffer_pointer_){
-            std::fill(depth_buffer_pointer_,
-                      depth_buffer_pointer_ + width_ * height_,
-                      std::numeric_limits<double>::max());
+            VisitDepthFormat(depth_format_, [this](auto format){
+                ClearZBuffer<decltype(format)::value>();
+            });
         } else{
             throw std::runtime_error("Z buffer is not enabled!");
         }
     }
 
+    template<DEPTH_FORMAT FORMAT>
+    void FrameBuffer::ClearZBuffer(){
+        for (TILE_STATE& tileState : depth_tile_states_){
+            if (tileState == TILE_STATE::DRAWN){
+                tileState = TILE_STATE::CLEAR_PENDING;
+            }
+        }
+
+        std::fill(block_farthest_depth_.begin(), block_farthest_depth_.end(),
+                  DepthFormatTraits<FORMAT>::GetDistanceKey(DepthFormatTraits<FORMAT>::CLEAR_VALUE));
+        std::fill(block_depth_dirty_.begin(), block_depth_dirty_.end(), 0);
+    }
+
     void FrameBuffer::EnableZBuffer() {
         if (depth_buffer_pointer_ == nullptr){
-            depth_buffer_pointer_ = new double[width_ * height_];
+            AllocateDepthBuffer();
         } else{
             throw std::runtime_error("Z buffer already enabled!");
         }
     }
 
+    bool FrameBuffer::IsZBufferEnabled() const {
+        return depth_buffer_pointer_ != nullptr;
+    }
+
+    void FrameBuffer::SetDepthFormat(DEPTH_FORMAT depthFormat) {
+        if (depthFormat != depth_format_){
+            depth_format_ = depthFormat;
+            ReallocateDepthBuffer();
+        }
+    }
+
+    DEPTH_FORMAT FrameBuffer::GetDepthFormat() const {
+        return depth_format_;
+    }
+
+    void FrameBuffer::SetDepthRange(double near, double far) {
+        if (near <= 0.0 || far <= near){
+            throw std::runtime_error("Invalid depth range!");
+        }
+
+        depth_near_ = near;
+        depth_far_ = far;
+    }
+
     size_t FrameBuffer::GetWidth() const {
         return width_;
     }
@@ -0,0 +1,43 @@
+#include "headers/rendering/frustum.h"
+
+using namespace std;
+
+namespace pv {
+
+    Frustum::Frustum(const glm::mat4& clipTransform) {
+        const auto row = [&clipTransform](int rowIndex){
+            return glm::vec4(clipTransform[0][rowIndex], clipTransform[1][rowIndex],
+                             clipTransform[2][rowIndex], clipTransform[3][rowIndex]);
+        };
+
+        // -w <= x <= w, -w <= y <= w and 0 <= z <= w.
+        planes_ = { row(3) + row(0), row(3) - row(0),
+                    row(3) + row(1), row(3) - row(1),
+                    row(2),          row(3) - row(2) };
+    }
+
+    bool Frustum::IntersectsBox(const BoundingBox& box) const {
+        for (const glm::vec4& plane : planes_){
+            // The box corner furthest along the plane normal.
+            const glm::vec4 corner(plane.x >= 0.0F ? box.maxCorner.x : box.minCorner.x,
+                                   plane.y >= 0.0F ? box.maxCorner.y : box.minCorner.y,
+                                   plane.z >= 0.0F ? box.maxCorner.z : box.minCorner.z,
+                                   1.0F);
+            if (glm::dot(plane, corner) < 0.0F) return false;
+        }
+        return true;
+    }
+
+    bool Frustum::ContainsBox(const BoundingBox& box) const {
+        for (const glm::vec4& plane : planes_){
+            // The box corner furthest against the plane normal.
+            const glm::vec4 corner(plane.x >= 0.0F ? box.minCorner.x : box.maxCorner.x,
+                                   plane.y >= 0.0F ? box.minCorner.y : box.maxCorner.y,
+                                   plane.z >= 0.0F ? box.minCorner.z : box.maxCorner.z,
+                                   1.0F);
+            if (glm::dot(plane, corner) < 0.0F) return false;
+        }
+        return true;
+    }
+
+} // namespace pv
@@ -4,20 +4,89 @@
 #include <array>
 #include <cmath>
 #include <algorithm>
+#include <bitset>
 #include "headers/rendering/attributeinterpolation.h"
+#include "headers/rendering/trianglerasterizer.h"
+#include "headers/rendering/triangleclipper.h"
 
 using namespace std;
 
 namespace pv {
 
+// Tiles are shaded in parallel, each one has to own whole clear tiles of the frame buffer.
+static_assert(TileBinner::TILE_SIZE % FrameBuffer::CLEAR_TILE_SIZE == 0,
+              "Render tiles must be made of whole frame buffer clear tiles");
+
+inline uint64_t CountSpanLanes(SpanMask mask) {
+    return bitset<SPAN_WIDTH>(mask).count();
+}
+
+// Once a depth pre-pass has resolved the final depth of every pixel, only the
+// fragment that produced it passes the test, so each pixel is shaded exactly once.
+class ZBufferPixelSink : public ShadedPixelSink {
+public:
+    ZBufferPixelSink(FrameBuffer& frameBuffer, bool depthResolved, RenderStats* profilingStats) :
+        frame_buffer_(frameBuffer),
+        depth_resolved_(depthResolved),
+        profiling_stats_(profilingStats) { }
+
+    SpanMask DepthTestSpan(int x, int y, const double* depth, SpanMask mask) override {
+        ScopedStageTimer depthTestTimer(profiling_stats_, RENDER_STAGE::DEPTH_TEST);
+        const SpanMask passedMask = frame_buffer_.ZBufferTestSpan(x, y, depth, mask, GetDepthTest());
+
+        if (profiling_stats_){
+            profiling_stats_->AddCount(RENDER_COUNTER::DEPTH_TESTS_PASSED, CountSpanLanes(passedMask));
+            profiling_stats_->AddCount(RENDER_COUNTER::DEPTH_TESTS_FAILED, CountSpanLanes(mask & ~passedMask));
+        }
+        return passedMask;
+    }
+
+    bool DepthTestBlock(const ScreenRect& blockRect, double nearestDepth) override {
+        ScopedStageTimer depthTestTimer(profiling_stats_, RENDER_STAGE::DEPTH_TEST);
+        return frame_buffer_.ZBufferTestRect(blockRect, nearestDepth, GetDepthTest());
+    }
+
+    RenderStats* GetProfilingStats() override {
+        return profiling_stats_;
+    }
+
+    void DrawShadedPixel(const ShadedPixel& shadedPixel) override {
+        if (profiling_stats_){
+            profiling_stats_->AddCount(RENDER_COUNTER::PIXELS_SHADED, 1);
+        }
+
+        if (depth_resolved_){
+            frame_buffer_.DrawPixel(shadedPixel.interpolatedPoint.x,
+                                    shadedPixel.interpolatedPoint.y,
+                                    shadedPixel.shadeColor);
+        } else {
+            frame_buffer_.ZBufferDrawPixel(shadedPixel.interpolatedPoint.x,
+                                           shadedPixel.interpolatedPoint.y,
+                                           shadedPixel.interpolatedPoint.z,
+                                           shadedPixel.shadeColor);
+        }
+    }
+
+private:
+    DEPTH_TEST GetDepthTest() const {
+        return depth_resolved_ ? DEPTH_TEST::LESS_EQUAL : DEPTH_TEST::LESS;
+    }
+
+    FrameBuffer& frame_buffer_;
+    bool depth_resolved_;
+    RenderStats* profiling_stats_;
+};
+
 RenderingPipeline::RenderingPipeline(const SceneData& sceneData) :
     scene_data_(sceneData),
+    streamed_mesh_(nullptr),
     fovy_{GetRadianAngle(30.0)},
     near_{2.0},
     far_ {500.0},
     model_scale_factor_{1.0},
     animation_holder_{std::make_unique<NoAnimation>()},
     shading_model_holder_{std::make_unique<NoShading>()},
+    unlit_shading_model_(),
     draw_polygon_mesh_(false),
     argb_pen_color_({255, 255, 255, 0}),
     rasterize_polygons_(false),
@@ -25,7 +94,14 @@ RenderingPipeline::RenderingPipeline(const SceneData& sceneData) :
     draw_world_axes_(false),
     z_buffer_enabled_(false),
     backface_culling_enabled_(false),
-    light_sources_() { }
+    depth_prepass_enabled_(false),
+    depth_format_(DEPTH_FORMAT::FLOAT64),
+    detailed_profiling_enabled_(false),
+    light_sources_(),
+    frame_buffer_(0, 0, COLOR_MODEL::ARGB32)
+{
+    UpdateSceneClusters();
+}
 
 glm::mat4 RenderingPipeline::GetFrustumProjection(float aspectRatio) {
     float fovyAngleInRadians = GetRadianAngle(fovy_);
@@ -81,17 +157,16 @@ void RenderingPipeline::RenderWorldAxes(FrameBuffer& frameBuffer) {
                                                 width,
                                                 height);
 
-        auto& originViewportPoint = viewportPoints[ORIGIN_INDEX];
-
-        if (originViewportPoint){
-            for (size_t i = 0; i < viewportPoints.size() - 1; ++i){
-                auto& axisViewportPoint = viewportPoints[i];
+        if (viewportPoints.IsVisible(ORIGIN_INDEX)){
+            const ViewportPoint originViewportPoint = viewportPoints.GetPoint(ORIGIN_INDEX);
 
-                if (axisViewportPoint) {
-                    frameBuffer.DrawLine(originViewportPoint.value().x,
-                                         originViewportPoint.value().y,
-                                         axisViewportPoint.value().x,
-                                         axisViewportPoint.value().y,
+            for (size_t i = 0; i < viewportPoints.GetSize() - 1; ++i){
+                if (viewportPoints.IsVisible(i)) {
+                    const ViewportPoint axisViewportPoint = viewportPoints.GetPoint(i);
+                    frameBuffer.DrawLine(originViewportPoint.x,
+                                         originViewportPoint.y,
+                                         axisViewportPoint.x,
+                                         axisViewportPoint.y,
                                          axisColors[i]);
                 }
             }
@@ -104,41 +179,38 @@ void RenderingPipeline::RenderWorldAxes(FrameBuffer& frameBuffer) {
 
 void RenderingPipeline::RenderPolygonMesh(
         FrameBuffer &frameBuffer,
-        const std::vector<std::optional<ViewportPoint>>& viewportPoints,
+        const ViewportPoints& viewportPoints,
         const SceneData& sceneData)
 {
-    const std::vector<Polygon> &polygons = sceneData.polygons;
-
-    for (const auto& polygon : polygons){
-        const auto& vertexIndices = polygon.vertex_indices;
-
-        if (backface_culling_enabled_){
-            if (PolygonIsBackFacing(polygon, sceneData.vertices)) {
-                continue;
-            }
-        }
-
-        for (size_t idx = 0; idx < vertexIndices.size() - 1; ++idx){
-            const auto& pointOne = viewportPoints[ vertexIndices[idx] ];
-            const auto& pointTwo = viewportPoints[ vertexIndices[idx + 1] ];
-            if (pointOne && pointTwo){
-                frameBuffer.DrawLine(pointOne.value().x,
-                                     pointOne.value().y,
-                                     pointTwo.value().x,
-                                     pointTwo.value().y,
+    const size_t polygonCount = sceneData.GetPolygonCount();
+
+    for (size_t polygonIndex = 0; polygonIndex < polygonCount; ++polygonIndex){
+        if (PolygonIsCulled(polygonIndex)) continue;
+
+        const int* vertexIndices = sceneData.vertex_indices.data() + sceneData.GetFirstCorner(polygonIndex);
+        const size_t cornerCount = sceneData.GetCornerCount(polygonIndex);
+
+        for (size_t idx = 0; idx < cornerCount - 1; ++idx){
+            const int indexOne = vertexIndices[idx];
+            const int indexTwo = vertexIndices[idx + 1];
+            if (viewportPoints.IsVisible(indexOne) && viewportPoints.IsVisible(indexTwo)){
+                frameBuffer.DrawLine(viewportPoints.x[indexOne],
+                                     viewportPoints.y[indexOne],
+                                     viewportPoints.x[indexTwo],
+                                     viewportPoints.y[indexTwo],
                                      argb_pen_color_
                  );
             }
         }
 
-        size_t lastVertexInPolygonIndex = vertexIndices.size() - 1;
-        const auto& pointOne = viewportPoints[ vertexIndices[0] ];
-        const auto& pointTwo = viewportPoints[ vertexIndices[lastVertexInPolygonIndex] ];
-        if (pointOne && pointTwo){
-            frameBuffer.DrawLine(pointOne.value().x,
-                                 pointOne.value().y,
-                                 pointTwo.value().x,
-                                 pointTwo.value().y,
+        size_t lastVertexInPolygonIndex = cornerCount - 1;
+        const int indexOne = vertexIndices[0];
+        const int indexTwo = vertexIndices[lastVertexInPolygonIndex];
+        if (viewportPoints.IsVisible(indexOne) && viewportPoints.IsVisible(indexTwo)){
+            frameBuffer.DrawLine(viewportPoints.x[indexOne],
+                                 viewportPoints.y[indexOne],
+                                 viewportPoints.x[indexTwo],
+                                 viewportPoints.y[indexTwo],
                                  argb_pen_color_
              );
         }
@@ -147,28 +219,27 @@ void RenderingPipeline::RenderPolygonMesh(
 
 void RenderingPipeline::ZBufferRenderPolygonMesh(
         FrameBuffer &frameBuffer,
-        const std::vector<std::optional<ViewportPoint> > &viewportPoints,
+        const ViewportPoints& viewportPoints,
         const SceneData& sceneData)
 {
-    const std::vector<Polygon> &polygons = sceneData.polygons;
+    const size_t polygonCount = sceneData.GetPolygonCount();
     constexpr double POLYGON_MESH_VISIBILITY_Z_OFFSET = 0.01;
     AttributeInterpolation attrInterpolation;
 
-    for (const auto& polygon : polygons){
-        const auto& vertexIndices = polygon.vertex_indices;
+    for (size_t polygonIndex = 0; polygonIndex < polygonCount; ++polygonIndex){
+        if (PolygonIsCulled(polygonIndex)) continue;
 
-        if (backface_culling_enabled_){
-            if (PolygonIsBackFacing(polygon, sceneData.vertices)) {
-                continue;
-            }
-        }
+        const int* vertexIndices = sceneData.vertex_indices.data() + sceneData.GetFirstCorner(polygonIndex);
+        const size_t cornerCount = sceneData.GetCornerCount(polygonIndex);
 
-        for (size_t idx = 0; idx < vertexIndices.size() - 1; ++idx){
-            const auto& pointOne = viewportPoints[ vertexIndices[idx] ];
-            const auto& pointTwo = viewportPoints[ vertexIndices[idx + 1] ];
-            if (pointOne && pointTwo){
-                auto interpolationPoints = GetLineInterpolationPoints(pointOne.value(), pointTwo.value());
-                attrInterpolation.InterpolateDepthOverLine(interpolationPoints, pointOne.value(), pointTwo.value());
+        for (size_t idx = 0; idx < cornerCount - 1; ++idx){
+            const int indexOne = vertexIndices[idx];
+            const int indexTwo = vertexIndices[idx + 1];
+            if (viewportPoints.IsVisible(indexOne) && viewportPoints.IsVisible(indexTwo)){
+                const ViewportPoint pointOne = viewportPoints.GetPoint(indexOne);
+                const ViewportPoint pointTwo = viewportPoints.GetPoint(indexTwo);
+                auto interpolationPoints = GetLineInterpolationPoints(pointOne, pointTwo);
+                attrInterpolation.InterpolateDepthOverLine(interpolationPoints, pointOne, pointTwo);
                 for (const auto& interpolationPoint : interpolationPoints){
                     frameBuffer.ZBufferDrawPixel(interpolationPoint.x,
                                                  interpolationPoint.y,
@@ -178,12 +249,14 @@ void RenderingPipeline::ZBufferRenderPolygonMesh(
             }
         }
 
-        size_t lastVertexInPolygonIndex = vertexIndices.size() - 1;
-        const auto& pointOne = viewportPoints[ vertexIndices[0] ];
-        const auto& pointTwo = viewportPoints[ vertexIndices[lastVertexInPolygonIndex] ];
-        if (pointOne && pointTwo){
-            auto interpolationPoints = GetLineInterpolationPoints(pointOne.value(), pointTwo.value());
-            attrInterpolation.InterpolateDepthOverLine(interpolationPoints, pointOne.value(), pointTwo.value());
+        size_t lastVertexInPolygonIndex = cornerCount - 1;
+        const int indexOne = vertexIndices[0];
+        const int indexTwo = vertexIndices[lastVertexInPolygonIndex];
+        if (viewportPoints.IsVisible(indexOne) && viewportPoints.IsVisible(indexTwo)){
+            const ViewportPoint pointOne = viewportPoints.GetPoint(indexOne);
+            const ViewportPoint pointTwo = viewportPoints.GetPoint(indexTwo);
+            auto interpolationPoints = GetLineInterpolationPoints(pointOne, pointTwo);
+            attrInterpolation.InterpolateDepthOverLine(interpolationPoints, pointOne, pointTwo);
 
             for (const auto& interpolationPoint : interpolationPoints){
                 frameBuffer.ZBufferDrawPixel(interpolationPoint.x,
@@ -224,235 +297,334 @@ RenderingPipeline::GetLineInterpolationPoints(
     return interpolationPoints;
 }
 
-void RenderingPipeline::RenderVertices(FrameBuffer &frameBuffer, const std::vector<std::optional<ViewportPoint>>& viewportPoints) {
-    for (const auto& viewportPoint : viewportPoints){
-        if (viewportPoint){
-            const auto& viewportPointValue = viewportPoint.value();
-            frameBuffer.DrawPixel(viewportPointValue.x, viewportPointValue.y, argb_pen_color_);
+void RenderingPipeline::RenderVertices(FrameBuffer &frameBuffer, const ViewportPoints& viewportPoints) {
+    for (size_t pointIndex = 0; pointIndex < viewportPoints.GetSize(); ++pointIndex){
+        if (viewportPoints.IsVisible(pointIndex)){
+            frameBuffer.DrawPixel(viewportPoints.x[pointIndex], viewportPoints.y[pointIndex], argb_pen_color_);
         }
     }
 }
 
-void RenderingPipeline::RenderRasterizedPolygons(
+void RenderingPipeline::RenderRasterizedPolygons(FrameBuffer &frameBuffer)
+{
+    ScopedStageTimer rasterizationTimer(&render_stats_, RENDER_STAGE::RASTERIZATION);
+
+    for (const ScreenTriangle& screenTriangle : screen_triangles_){
+        screenTriangle.rasterizer.ForEachCoveredPixel([this, &frameBuffer](int x, int y){
+            frameBuffer.DrawPixel(x, y, argb_brush_color_);
+        });
+    }
+}
+
+void RenderingPipeline::ZBufferRenderRasterizedPolygons(
         FrameBuffer &frameBuffer,
-        const std::vector<std::optional<ViewportPoint> > &viewportPoints,
         const SceneData& sceneData)
 {
-    const std::vector<Polygon> &polygons = sceneData.polygons;
+    {
+        ScopedStageTimer setupTimer(&render_stats_, RENDER_STAGE::TRIANGLE_SETUP);
+        tile_binner_.Reset(frameBuffer.GetWidth(), frameBuffer.GetHeight());
 
-    for (const auto& polygon : polygons){
-        const auto& vertexIndices = polygon.vertex_indices;
+        for (size_t triangleIndex = 0; triangleIndex < screen_triangles_.size(); ++triangleIndex){
+            tile_binner_.BinTriangle(static_cast<uint32_t>(triangleIndex),
+                                     screen_triangles_[triangleIndex].rasterizer.GetBoundingRect());
+        }
+    }
 
-        if (backface_culling_enabled_){
-            if (PolygonIsBackFacing(polygon, sceneData.vertices)) {
-                continue;
-            }
+    const auto rasterizationStart = ScopedStageTimer::Clock::now();
+    const auto materialColor = argb_brush_color_;
+    // Lighting needs vertex normals, a model without them is drawn unlit whatever the selected model.
+    const ShadingModel& shadingModel = sceneData.HasNormals() ? *shading_model_holder_ : unlit_shading_model_;
+
+    tile_stats_.assign(detailed_profiling_enabled_ ? tile_binner_.GetTileCount() : 0, RenderStats{});
+
+    thread_pool_.ParallelFor(tile_binner_.GetTileCount(), [&](size_t tileIndex){
+        const ScreenRect tileRect = tile_binner_.GetTileRect(tileIndex);
+        RenderStats* tileStats = detailed_profiling_enabled_ ? &tile_stats_[tileIndex] : nullptr;
+        ScopedStageTimer tileTimer(tileStats, RENDER_STAGE::RASTERIZATION);
+
+        if (depth_prepass_enabled_){
+            ZBufferRenderTileDepth(frameBuffer, tileIndex);
         }
+        ZBufferPixelSink pixelSink(frameBuffer, depth_prepass_enabled_, tileStats);
 
-        if (AllPolygonVerticesVisible(viewportPoints, vertexIndices)){
-            ViewportPolygonMargins viewportPolygonMargins = GetViewportPolygonMargins(viewportPoints, vertexIndices);
-            float currScanlineY = viewportPolygonMargins.minScanlineY;
-            const float scanlineIncrement = 1.0;
+        for (uint32_t triangleIndex : tile_binner_.GetTileTriangles(tileIndex)){
+            const ScreenTriangle& screenTriangle = screen_triangles_[triangleIndex];
+            const TriangleRasterizer triangleRasterizer(screenTriangle.rasterizer, tileRect);
 
-            auto polygonEdges = GetPolygonEdges(viewportPoints, vertexIndices);
+            if (ScreenTriangleIsOccluded(frameBuffer, screenTriangle, triangleRasterizer.GetBoundingRect(),
+                                         depth_prepass_enabled_ ? DEPTH_TEST::LESS_EQUAL : DEPTH_TEST::LESS)) {
+                continue;
+            }
 
-            while (currScanlineY < viewportPolygonMargins.maxScanlineY){
-                auto intersectionPoints = GetIntersectionPoints(polygonEdges, currScanlineY);
+            shadingModel.ShadeTriangle(screenTriangle.firstPoint,
+                                       screenTriangle.secondPoint,
+                                       screenTriangle.thirdPoint,
+                                       screenTriangle.sourceWeights,
+                                       triangleRasterizer,
+                                       screenTriangle.polygonIndex,
+                                       sceneData,
+                                       materialColor,
+                                       light_sources_,
+                                       transformed_vertices_,
+                                       pixelSink);
+        }
+    });
 
-                sort(intersectionPoints.begin(),
-                     intersectionPoints.end(),
-                     [](const IntersectionPoint& lhs, const IntersectionPoint& rhs) { return lhs.x < rhs.x; });
+    MergeTileStats(chrono::duration<double, milli>(ScopedStageTimer::Clock::now() - rasterizationStart).count());
+}
 
-                if (intersectionPoints.size() % 2 == 0){
-                    size_t pairsCount = intersectionPoints.size() / 2;
-                    size_t pairIdx = 0;
+// Tiles are timed per worker, so their depth test and shading times are in
+// thread time. They are scaled to their share of the wall-clock rasterization
+// stage to keep the stage times of a frame adding up to its frame time.
+void RenderingPipeline::MergeTileStats(double rasterizationMs)
+{
+    RenderStats tileTotals;
+    for (const RenderStats& tileStats : tile_stats_){
+        tileTotals.Merge(tileStats);
+    }
 
-                    while (pairsCount != 0){
-                        const auto& firstPoint = intersectionPoints[pairIdx];
-                        const auto& secondPoint = intersectionPoints[pairIdx + 1];
-                        frameBuffer.DrawLine(firstPoint.x, firstPoint.y,
-                                             secondPoint.x, secondPoint.y,
-                                             argb_brush_color_);
+    const double tileThreadMs = tileTotals.GetStageMs(RENDER_STAGE::RASTERIZATION);
+    const double wallClockScale = tileThreadMs > 0.0 ? rasterizationMs / tileThreadMs : 0.0;
+    const double depthTestMs = tileTotals.GetStageMs(RENDER_STAGE::DEPTH_TEST) * wallClockScale;
+    const double shadingMs = tileTotals.GetStageMs(RENDER_STAGE::SHADING) * wallClockScale;
 
-                        --pairsCount;
-                        pairIdx += 2;
-                    }
-                }
+    render_stats_.AddStageMs(RENDER_STAGE::DEPTH_TEST, depthTestMs);
+    render_stats_.AddStageMs(RENDER_STAGE::SHADING, shadingMs);
+    render_stats_.AddStageMs(RENDER_STAGE::RASTERIZATION, rasterizationMs - depthTestMs - shadingMs);
 
-                currScanlineY += scanlineIncrement;
-                currScanlineY = floor(currScanlineY);
-            }
-        }
+    for (size_t counter = 0; counter < RENDER_COUNTER_COUNT; ++counter){
+        render_stats_.counters[counter] += tileTotals.counters[counter];
     }
 }
 
-void RenderingPipeline::ZBufferRenderRasterizedPolygons(
-        FrameBuffer &frameBuffer,
-        const std::vector<std::optional<ViewportPoint> > &viewportPoints,
-        const SceneData& sceneData)
+void RenderingPipeline::ZBufferRenderTileDepth(FrameBuffer &frameBuffer, size_t tileIndex)
 {
-    const std::vector<Polygon> &polygons = sceneData.polygons;
+    const ScreenRect tileRect = tile_binner_.GetTileRect(tileIndex);
+    AttributeInterpolation attrInterpolation;
 
-    for (const auto& polygon : polygons){
-        const auto& vertexIndices = polygon.vertex_indices;
+    for (uint32_t triangleIndex : tile_binner_.GetTileTriangles(tileIndex)){
+        const ScreenTriangle& screenTriangle = screen_triangles_[triangleIndex];
+        const TriangleRasterizer triangleRasterizer(screenTriangle.rasterizer, tileRect);
 
-        if (backface_culling_enabled_){
-            if (PolygonIsBackFacing(polygon, sceneData.vertices)) {
-                continue;
-            }
+        if (ScreenTriangleIsOccluded(frameBuffer, screenTriangle, triangleRasterizer.GetBoundingRect(), DEPTH_TEST::LESS)) {
+            continue;
         }
 
-        if (AllPolygonVerticesVisible(viewportPoints, vertexIndices)){
-            const ViewportPoint& firstPoint = viewportPoints[vertexIndices[0]].value();
-            const ViewportPoint& secondPoint = viewportPoints[vertexIndices[1]].value();
-            const ViewportPoint& thirdPoint = viewportPoints[vertexIndices[2]].value();
-
-            auto materialColor = argb_brush_color_;
-            auto shadedPixels
-                    = shading_model_holder_->GetShadedPixels(firstPoint,
-                                                             secondPoint,
-                                                             thirdPoint,
-                                                             polygon,
-                                                             sceneData,
-                                                             materialColor,
-                                                             light_sources_,
-                                                             curr_model_matrix_,
-                                                             curr_view_matrix_);
-            for (const auto& shadedPixel : shadedPixels){
-                frameBuffer.ZBufferDrawPixel(shadedPixel.interpolatedPoint.x,
-                                             shadedPixel.interpolatedPoint.y,
-                                             shadedPixel.interpolatedPoint.z,
-                                             shadedPixel.shadeColor);
+        attrInterpolation.SetTriangle(screenTriangle.firstPoint,
+                                      screenTriangle.secondPoint,
+                                      screenTriangle.thirdPoint);
+
+        triangleRasterizer.ForEachCoveredSpan([&](int x, int y, SpanMask coverageMask, const double* u, const double* v){
+            double depth[SPAN_WIDTH];
+            const SpanMask mask = attrInterpolation.InterpolateDepthSpan(u, v, coverageMask, depth);
+
+            for (int lane = 0; lane < SPAN_WIDTH; ++lane){
+                if (mask & (SpanMask{1} << lane)){
+                    frameBuffer.ZBufferWriteDepth(x + lane, y, depth[lane]);
+                }
             }
-        }
+        }, [&](const ScreenRect& blockRect, const double (&cornerU)[4], const double (&cornerV)[4]){
+            return frameBuffer.ZBufferTestRect(blockRect, attrInterpolation.GetNearestDepth(cornerU, cornerV));
+        });
     }
 }
 
-bool RenderingPipeline::AllPolygonVerticesVisible(
-        const std::vector<std::optional<ViewportPoint> > &viewportPoints,
-        const std::vector<int> &vertexIndices)
+// Whole-triangle rejection against the hierarchical depth, before any
+// per-triangle shading setup is paid for.
+bool RenderingPipeline::ScreenTriangleIsOccluded(
+        const FrameBuffer &frameBuffer,
+        const ScreenTriangle &screenTriangle,
+        const ScreenRect &triangleRect,
+        DEPTH_TEST depthTest)
 {
-    for (size_t idx = 0; idx < vertexIndices.size(); ++idx){
-        const auto& point = viewportPoints[ vertexIndices[idx] ];
-        if (!point) return false;
-    }
+    AttributeInterpolation attrInterpolation;
+    attrInterpolation.SetTriangle(screenTriangle.firstPoint, screenTriangle.secondPoint, screenTriangle.thirdPoint);
 
-    return true;
+    return !frameBuffer.ZBufferTestRect(triangleRect, attrInterpolation.GetNearestDepth(), depthTest);
 }
 
-ViewportPolygonMargins
-RenderingPipeline::GetViewportPolygonMargins(
-        const std::vector<std::optional<ViewportPoint> > &viewportPoints,
-        const std::vector<int> &vertexIndices)
+// Culling and triangle setup in one pass over the polygons, spread over the
+// thread pool in chunks of polygons. A back-facing polygon is dropped after
+// one winding test and never gets near the clipper or the rasterizer setup.
+// The triangles each chunk keeps are then packed into screen_triangles_,
+// in polygon order, so the draw order is the same as that of the scene.
+void RenderingPipeline::SetupScreenTriangles(
+        const ViewportPoints& viewportPoints,
+        const SceneData& sceneData,
+        const ClusterHierarchy* culledClusters,
+        size_t width, size_t height,
+        bool trianglesNeeded)
 {
-    float yStartCompValue = viewportPoints[ vertexIndices[0] ]->y;
-    ViewportPolygonMargins viewportPolygonMargins{yStartCompValue, yStartCompValue};
-
-    for (size_t idx = 1; idx < vertexIndices.size(); ++idx){
-        const auto& point = viewportPoints[ vertexIndices[idx] ];
-
-        if (point->y < viewportPolygonMargins.minScanlineY){
-            viewportPolygonMargins.minScanlineY = point->y;
+    const size_t polygonCount = sceneData.GetPolygonCount();
+    const uint32_t* polygonOffsets = sceneData.polygon_offsets.data();
+    const int* vertexIndices = sceneData.vertex_indices.data();
+
+    const auto setupPolygon = [&](size_t polygonIndex, TriangleSetupChunk& setupChunk){
+        const int* corners = vertexIndices + polygonOffsets[polygonIndex];
+        const size_t cornerCount = polygonOffsets[polygonIndex + 1] - polygonOffsets[polygonIndex];
+        const size_t triangleCount = cornerCount >= 3 ? cornerCount - 2 : 0;
+
+        const bool culled = backface_culling_enabled_ && triangleCount > 0 && PolygonIsBackFacing(corners, viewportPoints);
+        polygon_culled_[polygonIndex] = culled;
+        if (!trianglesNeeded) return;
+
+        setupChunk.stats.AddCount(RENDER_COUNTER::TRIANGLES_IN, triangleCount);
+        if (culled){
+            setupChunk.stats.AddCount(RENDER_COUNTER::TRIANGLES_CULLED, triangleCount);
+            return;
         }
 
-        if (point->y > viewportPolygonMargins.maxScanlineY){
-            viewportPolygonMargins.maxScanlineY = point->y;
+        for (size_t idx = 1; idx + 1 < cornerCount; ++idx){
+            AppendScreenTriangles(polygonIndex, corners[0], corners[idx], corners[idx + 1],
+                                  viewportPoints, width, height, setupChunk);
         }
+    };
+
+    // With the clusters out of view culled, only the polygons of the visible
+    // ones are unmarked first, and the others are skipped and stay culled.
+    // Every polygon belongs to one cluster, so the threads write disjoint flags.
+    if (culledClusters){
+        polygon_culled_.assign(polygonCount, 1);
+
+        const std::vector<uint32_t>& clusterPolygons = culledClusters->GetClusterPolygons();
+        thread_pool_.ParallelFor(visible_clusters_.size(), [&](size_t idx){
+            const ClusterHierarchy::Cluster& cluster = culledClusters->GetCluster(visible_clusters_[idx]);
+            for (size_t polygon = cluster.firstPolygon; polygon < cluster.firstPolygon + cluster.polygonCount; ++polygon){
+                polygon_culled_[clusterPolygons[polygon]] = 0;
+            }
+        });
+    } else {
+        polygon_culled_.resize(polygonCount);
     }
 
-    return viewportPolygonMargins;
-}
+    constexpr size_t POLYGON_CHUNK_SIZE = 4096;
+    const size_t chunkCount = (polygonCount + POLYGON_CHUNK_SIZE - 1) / POLYGON_CHUNK_SIZE;
+    triangle_setup_chunks_.resize(chunkCount);
 
-std::vector<PolygonEdge> RenderingPipeline::GetPolygonEdges(
-        const std::vector<std::optional<ViewportPoint> > &viewportPoints,
-        const std::vector<int> &vertexIndices)
-{
-    vector<PolygonEdge> polygonEdges;
-    polygonEdges.reserve(vertexIndices.size());
+    thread_pool_.ParallelFor(chunkCount, [&](size_t chunkIndex){
+        TriangleSetupChunk& setupChunk = triangle_setup_chunks_[chunkIndex];
+        setupChunk.screenTriangles.clear();
+        setupChunk.stats = {};
 
-    for (size_t idx = 0; idx < vertexIndices.size() - 1; ++idx){
-        const auto& pointOne = viewportPoints[ vertexIndices[idx] ];
-        const auto& pointTwo = viewportPoints[ vertexIndices[idx + 1] ];
+        const size_t polygonEnd = min((chunkIndex + 1) * POLYGON_CHUNK_SIZE, polygonCount);
+        for (size_t polygonIndex = chunkIndex * POLYGON_CHUNK_SIZE; polygonIndex < polygonEnd; ++polygonIndex){
+            if (culledClusters && polygon_culled_[polygonIndex]) continue;
+            setupPolygon(polygonIndex, setupChunk);
+        }
+    });
 
-        polygonEdges.push_back(PolygonEdge{pointOne.value().x, pointOne.value().y,
-                                           pointTwo.value().x, pointTwo.value().y});
+    size_t triangleCount = 0;
+    for (TriangleSetupChunk& setupChunk : triangle_setup_chunks_){
+        setupChunk.firstTriangle = triangleCount;
+        triangleCount += setupChunk.screenTriangles.size();
+        render_stats_.Merge(setupChunk.stats);
     }
 
-    size_t lastVertexInPolygonIndex = vertexIndices.size() - 1;
-    const auto& pointOne = viewportPoints[ vertexIndices[0] ];
-    const auto& pointTwo = viewportPoints[ vertexIndices[lastVertexInPolygonIndex] ];
-
-    polygonEdges.push_back(PolygonEdge{pointOne.value().x, pointOne.value().y,
-                                       pointTwo.value().x, pointTwo.value().y});
-
-    return polygonEdges;
+    screen_triangles_.resize(triangleCount);
+    thread_pool_.ParallelFor(chunkCount, [&](size_t chunkIndex){
+        const TriangleSetupChunk& setupChunk = triangle_setup_chunks_[chunkIndex];
+        copy(setupChunk.screenTriangles.begin(), setupChunk.screenTriangles.end(),
+             screen_triangles_.begin() + setupChunk.firstTriangle);
+    });
 }
 
-
-std::vector<IntersectionPoint> RenderingPipeline::GetIntersectionPoints(
-        const std::vector<PolygonEdge>& polygonEdges,
-        float currScanlineY)
+void RenderingPipeline::AppendScreenTriangles(
+        size_t polygonIndex,
+        int firstIndex, int secondIndex, int thirdIndex,
+        const ViewportPoints& viewportPoints,
+        size_t width, size_t height,
+        TriangleSetupChunk& setupChunk)
 {
-    vector<IntersectionPoint> intersectionPoints;
-
-    for (const auto& polygonEdge : polygonEdges){
-        auto intersectionPoint = polygonEdge.GetIntersectionWithScanline(currScanlineY);
-        if (intersectionPoint) {
-            intersectionPoints.push_back(intersectionPoint.value());
-        }
+    const ScreenRect viewportRect { 0, 0, static_cast<int>(width) - 1, static_cast<int>(height) - 1 };
+
+    // Triangles falling between the pixel samples of the viewport are dropped here already.
+    const auto appendTriangle = [&](const ViewportPoint& firstPoint,
+                                    const ViewportPoint& secondPoint,
+                                    const ViewportPoint& thirdPoint,
+                                    const SourceVertexWeights& sourceWeights){
+        const TriangleRasterizer rasterizer(firstPoint, secondPoint, thirdPoint, viewportRect);
+        if (rasterizer.IsEmpty()) return;
+
+        setupChunk.screenTriangles.push_back({ firstPoint, secondPoint, thirdPoint, sourceWeights,
+                                               static_cast<uint32_t>(polygonIndex), rasterizer });
+    };
+
+    if (viewportPoints.IsVisible(firstIndex) && viewportPoints.IsVisible(secondIndex) && viewportPoints.IsVisible(thirdIndex)){
+        appendTriangle(viewportPoints.GetPoint(firstIndex),
+                       viewportPoints.GetPoint(secondIndex),
+                       viewportPoints.GetPoint(thirdIndex),
+                       UNCLIPPED_SOURCE_WEIGHTS);
+        return;
     }
 
-    if (intersectionPoints.size() == 3){
-        TryFixThreePointsIntersectionCase(intersectionPoints);
+    setupChunk.stats.AddCount(RENDER_COUNTER::TRIANGLES_CLIPPED, 1);
+
+    TriangleClipper::ClippedPolygon clippedPolygon;
+    if (!triangle_clipper_.ClipTriangle(transformed_vertices_.clipPositions[firstIndex],
+                                        transformed_vertices_.clipPositions[secondIndex],
+                                        transformed_vertices_.clipPositions[thirdIndex],
+                                        clippedPolygon))
+    {
+        return;
     }
 
-    return intersectionPoints;
-}
+    const glm::mat4 ViewportTransform = GetViewportTransform(width, height);
+    std::array<ViewportPoint, TriangleClipper::MAX_CLIPPED_VERTICES> clippedViewportPoints;
 
+    for (size_t idx = 0; idx < clippedPolygon.vertexCount; ++idx){
+        const glm::vec4& clipSpacePoint = clippedPolygon.vertices[idx].position;
 
-void RenderingPipeline::TryFixThreePointsIntersectionCase(std::vector<IntersectionPoint> &intersectionPoints) {
-    sort(intersectionPoints.begin(),
-         intersectionPoints.end(),
-         [](const IntersectionPoint& lhs,const IntersectionPoint& rhs){return lhs.x < rhs.x;});
+        float inverseW = 1.0 / clipSpacePoint.w;
+        auto viewportPoint = ViewportTransform * (clipSpacePoint * inverseW);
 
-    constexpr float eps = 0.1;
-    if (abs(intersectionPoints[0].x - intersectionPoints[1].x) < eps &&
-        abs(intersectionPoints[0].y - intersectionPoints[1].y) < eps){
-        intersectionPoints.erase(intersectionPoints.begin());
+        clippedViewportPoints[idx] = { viewportPoint.x, viewportPoint.y, viewportPoint.z, inverseW };
     }
-        else
 
-    if (abs(intersectionPoints[1].x - intersectionPoints[2].x) < eps &&
-        abs(intersectionPoints[1].y - intersectionPoints[2].y) < eps){
-        intersectionPoints.erase(intersectionPoints.begin() + 1);
+    for (size_t idx = 1; idx + 1 < clippedPolygon.vertexCount; ++idx){
+        appendTriangle(clippedViewportPoints[0],
+                       clippedViewportPoints[idx],
+                       clippedViewportPoints[idx + 1],
+                       { clippedPolygon.vertices[0].sourceWeights,
+                         clippedPolygon.vertices[idx].sourceWeights,
+                         clippedPolygon.vertices[idx + 1].sourceWeights });
     }
 }
 
+bool RenderingPipeline::PolygonIsCulled(size_t polygonIndex) const {
+    return polygon_culled_[polygonIndex];
+}
+
+// Facing is the winding of the first three corners on screen. Where one of
+// them did not make it into the viewport its screen position is not known,
+// and the winding comes from the determinant of the x, y and w of the clip
+// space positions instead. That is the screen space area scaled by the three
+// w, so it has the same sign for corners in front of the eye and stays right
+// for those behind it, where the projection flips the triangle over.
 bool RenderingPipeline::PolygonIsBackFacing(
-        const Polygon &polygon,
-        const std::vector<glm::vec3> &vertices)
+        const int* vertexIndices,
+        const ViewportPoints& viewportPoints) const
 {
-
-    glm::vec4 point0(vertices[polygon.vertex_indices[0]], 1);
-    glm::vec4 point1(vertices[polygon.vertex_indices[1]], 1);
-    glm::vec4 point2(vertices[polygon.vertex_indices[2]], 1);
-
-    glm::vec4 point0World = curr_model_matrix_ * point0;
-    glm::vec4 point1World = curr_model_matrix_ * point1;
-    glm::vec4 point2World = curr_model_matrix_ * point2;
-
-    glm::vec4 vecAWorld = point0World - point1World;
-    glm::vec4 vecBWorld = point2World - point1World;
-
-    glm::vec3 polygonNormalWorld = glm::cross(glm::vec3{vecAWorld.x, vecAWorld.y, vecAWorld.z},
-                                              glm::vec3{vecBWorld.x, vecBWorld.y, vecBWorld.z});
-
-    constexpr double DOT_PRODUCT_EPS = 0.000001;
-    if (glm::dot(polygonNormalWorld, camera_.GetWorldViewDirection()) < DOT_PRODUCT_EPS){
-        return true;
+    const int first = vertexIndices[0];
+    const int second = vertexIndices[1];
+    const int third = vertexIndices[2];
+
+    float doubleSignedArea;
+    if (viewportPoints.IsVisible(first) && viewportPoints.IsVisible(second) && viewportPoints.IsVisible(third)){
+        const float* x = viewportPoints.x.data();
+        const float* y = viewportPoints.y.data();
+        doubleSignedArea = (x[second] - x[first]) * (y[third] - y[first]) - (y[second] - y[first]) * (x[third] - x[first]);
+    } else {
+        const glm::vec4& a = transformed_vertices_.clipPositions[first];
+        const glm::vec4& b = transformed_vertices_.clipPositions[second];
+        const glm::vec4& c = transformed_vertices_.clipPositions[third];
+        doubleSignedArea = a.x * (b.y * c.w - c.y * b.w) - a.y * (b.x * c.w - c.x * b.w) + a.w * (b.x * c.y - c.x * b.y);
     }
 
-    return false;
+    return !(doubleSignedArea < 0.0F);
+}
+
+void RenderingPipeline::AdvanceAnimation(float elapsedSeconds) {
+    animation_holder_->Advance(elapsedSeconds);
 }
 
 void RenderingPipeline::SetAnimationHolder(AnimationHolder animationHolder) {
@@ -492,7 +664,27 @@ void RenderingPipeline::SetLightSources(vector<shared_ptr<LightSource>> lightSou
 }
 
 
-std::vector<std::optional<ViewportPoint>>
+void RenderingPipeline::UpdateModelViewMatrices() {
+    glm::mat4 Model = animation_holder_->GetModelMatrix();
+    ApplyScaleFactor(Model);
+    curr_model_matrix_ = Model;
+    glm::mat4 Camera = camera_.GetCameraMatrix();
+    glm::mat4 View = glm::inverse(Camera);
+    curr_view_matrix_ = View;
+}
+
+VertexTransformSetup RenderingPipeline::GetVertexTransformSetup(float aspectRatio, size_t width, size_t height) {
+    const glm::mat4 ViewportTransform = GetViewportTransform(width, height);
+    const glm::mat4 Projection = GetFrustumProjection(aspectRatio);
+    const glm::mat4 MVP = Projection * curr_view_matrix_ * curr_model_matrix_;
+    const glm::mat4 MV = curr_view_matrix_ * curr_model_matrix_;
+
+    return { MVP, MV,
+             ViewportTransform[0][0], ViewportTransform[1][1],
+             static_cast<float>(width), static_cast<float>(height) };
+}
+
+ViewportPoints
 RenderingPipeline::GetViewPortPoints
 (
         const std::vector<glm::vec3>& points,
@@ -500,92 +692,245 @@ RenderingPipeline::GetViewPortPoints
         size_t width,
         size_t height
 ) {
-    std::vector<std::optional<ViewportPoint>> viewportPoints;
-    viewportPoints.reserve(points.size());
-    {
-        glm::mat4 Model = animation_holder_->GetModelMatrix();
-        ApplyScaleFactor(Model);
-        curr_model_matrix_ = Model;
-        glm::mat4 Camera = camera_.GetCameraMatrix();
-        glm::mat4 View = glm::inverse(Camera);
-        curr_view_matrix_ = View;
-
-        glm::mat4 ViewportTransform = GetViewportTransform(width, height);
-        glm::mat4 Projection = GetFrustumProjection(aspectRatio);
-
-        auto MVP = Projection * View * Model;
-
-        for (const auto& objectPoint : points){
-            glm::vec4 homoPoint (objectPoint, 1);
-            auto clipSpacePoint = MVP * homoPoint;
-
-            if (WCoordinateIsNonZero(clipSpacePoint.w)){
-                float inverseW = 1.0 / clipSpacePoint.w;
-                auto deviceSpacePoint = clipSpacePoint * inverseW;
-
-                if (PointIsWithinCanonicalViewVolume(deviceSpacePoint)){
-                    auto viewportPoint = ViewportTransform * deviceSpacePoint;
-
-                    if (PointIsWithinViewportBoundaries(width, height, viewportPoint)) {
-                        viewportPoints.push_back(std::optional<ViewportPoint>{
-                                                    {viewportPoint.x,
-                                                     viewportPoint.y,
-                                                     viewportPoint.z,
-                                                     inverseW}
-                                                 });
-                        continue;
-                    }
-                }
-            }
-            viewportPoints.push_back(std::nullopt);
-        }
-    }
+    UpdateModelViewMatrices();
+
+    std::vector<glm::vec4> clipSpacePoints(points.size());
+    std::vector<glm::vec3> cameraSpacePoints(points.size());
+    ViewportPoints viewportPoints;
+    viewportPoints.Resize(points.size());
+
+    GetVertexKernels().TransformVertices(GetVertexTransformSetup(aspectRatio, width, height), points.data(), points.size(),
+                                         { clipSpacePoints.data(), cameraSpacePoints.data(),
+                                           viewportPoints.x.data(), viewportPoints.y.data(),
+                                           viewportPoints.z.data(), viewportPoints.inverseW.data(),
+                                           viewportPoints.visibleMasks.data() });
     return viewportPoints;
 }
 
-void RenderingPipeline::DoRender(size_t width, size_t height, uchar *renderedImage) {
-    FrameBuffer frameBuffer(width, height, COLOR_MODEL::ARGB32);
-    frameBuffer.Clear(0x00);
-    if (z_buffer_enabled_) { frameBuffer.EnableZBuffer(); frameBuffer.ClearZBuffer(); }
+// Finds the clusters in view into visible_clusters_. Returns false when that
+// is all of them, and there is nothing to gain from going cluster by cluster.
+bool RenderingPipeline::CullSceneClusters(const ClusterHierarchy& sceneClusters, float aspectRatio) {
+    const glm::mat4 modelView = curr_view_matrix_ * curr_model_matrix_;
+    const Frustum frustum(GetFrustumProjection(aspectRatio) * modelView);
+    sceneClusters.GetVisibleClusters(frustum, visible_clusters_);
 
-    if (!scene_data_.vertices.empty()){
-        auto viewportPoints = GetViewPortPoints(
-                                    scene_data_.vertices,
-                                    static_cast<float>(width) / height,
-                                    width, height);
+    return visible_clusters_.size() != sceneClusters.GetClusterCount();
+}
 
-        if (!draw_polygon_mesh_ && !rasterize_polygons_){
-            RenderVertices(frameBuffer, viewportPoints);
+// Vertex stage of the scene: each vertex is transformed at most once per frame, in
+// chunks spread over the thread pool and batched through the vertex kernels,
+// into transformed_vertices_ and viewport_points_. Everything downstream
+// indexes these instead of transforming vertices per triangle.
+void RenderingPipeline::TransformSceneVertices(
+        const SceneData& sceneData,
+        const ClusterHierarchy* culledClusters,
+        float aspectRatio,
+        size_t width, size_t height)
+{
+    const VertexTransformSetup setup = GetVertexTransformSetup(aspectRatio, width, height);
+
+    TransformedVertices& transformed = transformed_vertices_;
+    transformed.view = curr_view_matrix_;
+    transformed.modelView = setup.cameraTransform;
+    transformed.modelViewNormal = glm::transpose(glm::inverse(glm::mat3(setup.cameraTransform)));
+
+    const std::vector<glm::vec3>& vertices = sceneData.vertices;
+    const std::vector<glm::vec3>& normals = sceneData.vertex_normals;
+    const size_t vertexCount = vertices.size();
+
+    transformed.clipPositions.resize(vertexCount);
+    transformed.cameraPositions.resize(vertexCount);
+    transformed.cameraNormals.resize(normals.size());
+    viewport_points_.Resize(vertexCount);
+
+    // Chunks start on whole visibility mask words, which are written by one thread each.
+    constexpr size_t VERTEX_CHUNK_SIZE = 4096;
+    static_assert(VERTEX_CHUNK_SIZE % ViewportPoints::MASK_BITS == 0,
+                  "Vertex chunks must cover whole visibility mask words");
+    const size_t attributeCount = max(vertexCount, normals.size());
+
+    vertex_chunks_.clear();
+    if (!culledClusters){
+        for (size_t chunkBegin = 0; chunkBegin < attributeCount; chunkBegin += VERTEX_CHUNK_SIZE){
+            vertex_chunks_.emplace_back(chunkBegin, min(chunkBegin + VERTEX_CHUNK_SIZE, attributeCount));
+        }
+    } else {
+        // Only the vertex blocks used by visible clusters are transformed, in
+        // runs of consecutive blocks. The visibility mask words of the others
+        // are cleared, so none of their stale points is drawn.
+        constexpr size_t BLOCK_SIZE = ClusterHierarchy::VERTEX_BLOCK_SIZE;
+        static_assert(VERTEX_CHUNK_SIZE % BLOCK_SIZE == 0, "Vertex chunks must cover whole vertex blocks");
+
+        const size_t blockCount = (attributeCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        const std::vector<uint32_t>& clusterBlocks = culledClusters->GetClusterVertexBlocks();
+        vertex_block_needed_.assign(blockCount, 0);
+
+        for (uint32_t clusterIndex : visible_clusters_){
+            const ClusterHierarchy::Cluster& cluster = culledClusters->GetCluster(clusterIndex);
+            for (size_t idx = cluster.firstVertexBlock; idx < cluster.firstVertexBlock + cluster.vertexBlockCount; ++idx){
+                vertex_block_needed_[clusterBlocks[idx]] = 1;
+            }
         }
-            else
-
-        if (z_buffer_enabled_){
 
-            if (draw_polygon_mesh_) {
-                ZBufferRenderPolygonMesh(frameBuffer, viewportPoints, scene_data_);
+        for (size_t block = 0; block < blockCount; ){
+            if (!vertex_block_needed_[block]){
+                if (block < viewport_points_.visibleMasks.size()) viewport_points_.visibleMasks[block] = 0;
+                ++block;
+                continue;
             }
 
-            if (rasterize_polygons_){
-                ZBufferRenderRasterizedPolygons(frameBuffer, viewportPoints, scene_data_);
+            size_t runEnd = block + 1;
+            while (runEnd < blockCount && vertex_block_needed_[runEnd] && (runEnd - block) * BLOCK_SIZE < VERTEX_CHUNK_SIZE){
+                ++runEnd;
             }
+            vertex_chunks_.emplace_back(block * BLOCK_SIZE, min(runEnd * BLOCK_SIZE, attributeCount));
+            block = runEnd;
+        }
+    }
 
-        } else {
+    const VertexKernels& vertexKernels = GetVertexKernels();
+
+    thread_pool_.ParallelFor(vertex_chunks_.size(), [&](size_t chunkIndex){
+        const auto [chunkBegin, chunkEnd] = vertex_chunks_[chunkIndex];
+        const size_t vertexEnd = min(chunkEnd, vertexCount);
+        const size_t normalEnd = min(chunkEnd, normals.size());
+
+        if (chunkBegin < vertexEnd){
+            vertexKernels.TransformVertices(setup, vertices.data() + chunkBegin, vertexEnd - chunkBegin,
+                                            { transformed.clipPositions.data() + chunkBegin,
+                                              transformed.cameraPositions.data() + chunkBegin,
+                                              viewport_points_.x.data() + chunkBegin,
+                                              viewport_points_.y.data() + chunkBegin,
+                                              viewport_points_.z.data() + chunkBegin,
+                                              viewport_points_.inverseW.data() + chunkBegin,
+                                              viewport_points_.visibleMasks.data() + chunkBegin / ViewportPoints::MASK_BITS });
+        }
 
-            if (rasterize_polygons_){
-                RenderRasterizedPolygons(frameBuffer, viewportPoints, scene_data_);
-            }
+        for (size_t normalIndex = chunkBegin; normalIndex < normalEnd; ++normalIndex){
+            transformed.cameraNormals[normalIndex] = transformed.modelViewNormal * normals[normalIndex];
+        }
+    });
+}
 
-            if (draw_polygon_mesh_) {
-                RenderPolygonMesh(frameBuffer, viewportPoints, scene_data_);
-            }
+void RenderingPipeline::DoRender(size_t width, size_t height, uchar *renderedImage, bool imagePreserved) {
+    const auto frameStart = ScopedStageTimer::Clock::now();
+    render_stats_ = {};
+    render_stats_.detailed = detailed_profiling_enabled_;
+
+    FrameBuffer& frameBuffer = frame_buffer_;
+    {
+        ScopedStageTimer clearTimer(&render_stats_, RENDER_STAGE::CLEAR);
+        frameBuffer.AttachColorBuffer(renderedImage, width, height, imagePreserved);
+        frameBuffer.Clear(0x00);
+        if (z_buffer_enabled_) {
+            frameBuffer.SetDepthFormat(depth_format_);
+            frameBuffer.SetDepthRange(near_, far_);
+            if (!frameBuffer.IsZBufferEnabled()) frameBuffer.EnableZBuffer();
+            frameBuffer.ClearZBuffer();
         }
     }
 
+    UpdateModelViewMatrices();
+
+    if (streamed_mesh_){
+        {
+            ScopedStageTimer cullingTimer(&render_stats_, RENDER_STAGE::CULLING);
+            const glm::mat4 modelView = curr_view_matrix_ * curr_model_matrix_;
+            const Frustum frustum(GetFrustumProjection(static_cast<float>(width) / height) * modelView);
+            const glm::vec3 viewPoint(glm::inverse(modelView) * glm::vec4(0, 0, 0, 1));
+            streamed_mesh_->UpdateResidency(frustum, viewPoint);
+        }
+
+        for (const SceneData* chunkSceneData : streamed_mesh_->GetVisibleChunks()){
+            RenderSceneData(frameBuffer, *chunkSceneData, nullptr, width, height);
+        }
+    } else if (!scene_data_.vertices.empty()){
+        RenderSceneData(frameBuffer, scene_data_, &scene_clusters_, width, height);
+    }
+
     if (draw_world_axes_) {
+        ScopedStageTimer rasterizationTimer(&render_stats_, RENDER_STAGE::RASTERIZATION);
         RenderWorldAxes(frameBuffer);
     }
 
-    frameBuffer.CopyToUcharArray(renderedImage);
+    {
+        ScopedStageTimer resolveTimer(&render_stats_, RENDER_STAGE::RESOLVE);
+        frameBuffer.ResolveClears();
+    }
+
+    render_stats_.frameMs = chrono::duration<double, milli>(ScopedStageTimer::Clock::now() - frameStart).count();
+}
+
+// Every pass shares the frame buffer, so a mesh drawn as several scenes, as
+// the chunks of a streamed mesh are, ends up depth tested against itself.
+// With sceneClusters, only the clusters of polygons in view are drawn.
+void RenderingPipeline::RenderSceneData(
+        FrameBuffer& frameBuffer,
+        const SceneData& sceneData,
+        const ClusterHierarchy* sceneClusters,
+        size_t width, size_t height)
+{
+    const float aspectRatio = static_cast<float>(width) / height;
+    const bool polygonsDrawn = draw_polygon_mesh_ || rasterize_polygons_;
+
+    // Vertices drawn on their own need not belong to any polygon, and are all transformed.
+    const ClusterHierarchy* culledClusters = nullptr;
+    if (sceneClusters && polygonsDrawn){
+        ScopedStageTimer cullingTimer(&render_stats_, RENDER_STAGE::CULLING);
+        if (CullSceneClusters(*sceneClusters, aspectRatio)) culledClusters = sceneClusters;
+    }
+
+    {
+        ScopedStageTimer vertexTransformTimer(&render_stats_, RENDER_STAGE::VERTEX_TRANSFORM);
+        TransformSceneVertices(sceneData, culledClusters, aspectRatio, width, height);
+    }
+    const ViewportPoints& viewportPoints = viewport_points_;
+
+    if (polygonsDrawn){
+        ScopedStageTimer setupTimer(&render_stats_, RENDER_STAGE::TRIANGLE_SETUP);
+        SetupScreenTriangles(viewportPoints, sceneData, culledClusters, width, height, rasterize_polygons_);
+    }
+
+    if (!draw_polygon_mesh_ && !rasterize_polygons_){
+        ScopedStageTimer rasterizationTimer(&render_stats_, RENDER_STAGE::RASTERIZATION);
+        RenderVertices(frameBuffer, viewportPoints);
+    }
+        else
+
+    if (z_buffer_enabled_){
+
+        if (draw_polygon_mesh_) {
+            ScopedStageTimer rasterizationTimer(&render_stats_, RENDER_STAGE::RASTERIZATION);
+            ZBufferRenderPolygonMesh(frameBuffer, viewportPoints, sceneData);
+        }
+
+        if (rasterize_polygons_){
+            ZBufferRenderRasterizedPolygons(frameBuffer, sceneData);
+        }
+
+    } else {
+
+        if (rasterize_polygons_){
+            RenderRasterizedPolygons(frameBuffer);
+        }
+
+        if (draw_polygon_mesh_) {
+            ScopedStageTimer rasterizationTimer(&render_stats_, RENDER_STAGE::RASTERIZATION);
+            RenderPolygonMesh(frameBuffer, viewportPoints, sceneData);
+        }
+    }
+}
+
+void RenderingPipeline::SetStreamedMesh(StreamedMesh* streamedMesh) {
+    streamed_mesh_ = streamedMesh;
+}
+
+void RenderingPipeline::UpdateSceneClusters() {
+    scene_clusters_.Build(scene_data_);
+}
+
+const RenderStats& RenderingPipeline::GetLastFrameStats() const {
+    return render_stats_;
 }
 
 void RenderingPipeline::SetNearPlaneDistance(float near) {
@@ -675,6 +1020,10 @@ void RenderingPipeline::UpdateCameraPosition(int deltaX, int deltaY) {
                                  -deltaY * inclinationDegrees);
 }
 
+void RenderingPipeline::RotateCamera(float azimuthDegrees, float inclinationDegrees) {
+    camera_.UpdateCameraPosition(azimuthDegrees, inclinationDegrees);
+}
+
 void RenderingPipeline::SetOrbitCameraDistance(float distance) {
     camera_.SetWorldOriginDistanceR(distance);
 }
@@ -695,27 +1044,24 @@ void RenderingPipeline::SetEnableBackfaceCulling(bool enableBackfaceCulling) {
     backface_culling_enabled_ = enableBackfaceCulling;
 }
 
-void RenderingPipeline::ApplyScaleFactor(glm::mat4 &modelMatrix) {
-    for (int row = 0; row < 3; ++row){
-        for (int column = 0; column < 3; ++column){
-            modelMatrix[row][column] *= model_scale_factor_;
-        }
-    }
+void RenderingPipeline::SetEnableDepthPrepass(bool enableDepthPrepass) {
+    depth_prepass_enabled_ = enableDepthPrepass;
 }
 
-bool RenderingPipeline::WCoordinateIsNonZero(float w) {
-    constexpr float EPSILON = 0.0001;
-    return abs(w) > EPSILON;
+void RenderingPipeline::SetDepthFormat(DEPTH_FORMAT depthFormat) {
+    depth_format_ = depthFormat;
 }
 
-bool RenderingPipeline::PointIsWithinCanonicalViewVolume(const glm::vec4 &point) {
-    return (-1 <= point.x) && (point.x <= 1) &&
-           (-1 <= point.y) && (point.y <= 1) &&
-           ( 0 <= point.z) && (point.z <= 1);
+void RenderingPipeline::SetEnableDetailedProfiling(bool enableDetailedProfiling) {
+    detailed_profiling_enabled_ = enableDetailedProfiling;
 }
 
-bool RenderingPipeline::PointIsWithinViewportBoundaries(size_t width, size_t height, const glm::vec3 &point) {
-    return point.x < width && point.y < height;
+void RenderingPipeline::ApplyScaleFactor(glm::mat4 &modelMatrix) {
+    for (int row = 0; row < 3; ++row){
+        for (int column = 0; column < 3; ++column){
+            modelMatrix[row][column] *= model_scale_factor_;
+        }
+    }
 }
 
 } // namespace pv
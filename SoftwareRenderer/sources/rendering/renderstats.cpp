@@ -0,0 +1,44 @@
+#include "headers/rendering/renderstats.h"
+
+using namespace std;
+
+namespace pv {
+
+    void RenderStats::Merge(const RenderStats &other) {
+        frameMs += other.frameMs;
+        for (size_t stage = 0; stage < RENDER_STAGE_COUNT; ++stage){
+            stageMs[stage] += other.stageMs[stage];
+        }
+        for (size_t counter = 0; counter < RENDER_COUNTER_COUNT; ++counter){
+            counters[counter] += other.counters[counter];
+        }
+        detailed = detailed || other.detailed;
+    }
+
+    const char* RenderStats::GetStageName(RENDER_STAGE stage) {
+        switch (stage){
+            case RENDER_STAGE::CLEAR:            return "clear";
+            case RENDER_STAGE::VERTEX_TRANSFORM: return "vertex transform";
+            case RENDER_STAGE::CULLING:          return "culling";
+            case RENDER_STAGE::TRIANGLE_SETUP:   return "triangle setup";
+            case RENDER_STAGE::RASTERIZATION:    return "rasterization";
+            case RENDER_STAGE::DEPTH_TEST:       return "depth test";
+            case RENDER_STAGE::SHADING:          return "shading";
+            case RENDER_STAGE::RESOLVE:          return "resolve";
+        }
+        return "unknown";
+    }
+
+    const char* RenderStats::GetCounterName(RENDER_COUNTER counter) {
+        switch (counter){
+            case RENDER_COUNTER::TRIANGLES_IN:       return "triangles in";
+            case RENDER_COUNTER::TRIANGLES_CULLED:   return "triangles culled";
+            case RENDER_COUNTER::TRIANGLES_CLIPPED:  return "triangles clipped";
+            case RENDER_COUNTER::PIXELS_SHADED:      return "pixels shaded";
+            case RENDER_COUNTER::DEPTH_TESTS_PASSED: return "depth tests passed";
+            case RENDER_COUNTER::DEPTH_TESTS_FAILED: return "depth tests failed";
+        }
+        return "unknown";
+    }
+
+} // namespace pv
@@ -1,10 +1,56 @@
 #include "headers/rendering/scenedata.h"
+#include <stdexcept>
+
+using namespace std;
 
 namespace pv {
 
-    SceneData::SceneData()
+    SceneData::SceneData() :
+        polygon_offsets{0}
     {
 
     }
 
+    void SceneData::EndPolygon() {
+        if (vertex_indices.size() > UINT32_MAX) throw runtime_error("Too many polygon corners");
+
+        polygon_offsets.push_back(static_cast<uint32_t>(vertex_indices.size()));
+    }
+
+    void SceneData::SplitQuadsIntoTriangles() {
+        const size_t polygonCount = GetPolygonCount();
+
+        vector<uint32_t> newOffsets;
+        vector<int> newVertexIndices;
+        newOffsets.reserve(polygon_offsets.size());
+        newVertexIndices.reserve(vertex_indices.size());
+        newOffsets.push_back(0);
+
+        const auto appendTriangle = [&](const int* corners, size_t first, size_t second, size_t third){
+            newVertexIndices.insert(newVertexIndices.end(), { corners[first], corners[second], corners[third] });
+            newOffsets.push_back(static_cast<uint32_t>(newVertexIndices.size()));
+        };
+
+        for (size_t polygonIndex = 0; polygonIndex < polygonCount; ++polygonIndex){
+            const int* corners = vertex_indices.data() + GetFirstCorner(polygonIndex);
+            const size_t cornerCount = GetCornerCount(polygonIndex);
+
+            if (cornerCount == 4){
+                appendTriangle(corners, 0, 1, 2);
+            } else {
+                newVertexIndices.insert(newVertexIndices.end(), corners, corners + cornerCount);
+                newOffsets.push_back(static_cast<uint32_t>(newVertexIndices.size()));
+            }
+        }
+
+        for (size_t polygonIndex = 0; polygonIndex < polygonCount; ++polygonIndex){
+            if (GetCornerCount(polygonIndex) == 4){
+                appendTriangle(vertex_indices.data() + GetFirstCorner(polygonIndex), 2, 3, 0);
+            }
+        }
+
+        polygon_offsets = std::move(newOffsets);
+        vertex_indices = std::move(newVertexIndices);
+    }
+
 } // namespace pv
@@ -0,0 +1,508 @@
+#include "headers/rendering/spankernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define PV_SPAN_KERNELS_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define PV_TARGET_AVX2
+    #else
+        #define PV_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+using namespace std;
+
+namespace pv {
+
+    //------ scalar
+
+    SpanMask ScalarEvaluateEdges(const EdgeSpanSetup& setup, const int64_t (&edgeValues)[3], int count,
+                                 double* u, double* v)
+    {
+        SpanMask mask = 0;
+
+        for (int lane = 0; lane < count; ++lane){
+            const double e0 = static_cast<double>(edgeValues[0]) + lane * setup.xStep[0];
+            const double e1 = static_cast<double>(edgeValues[1]) + lane * setup.xStep[1];
+            const double e2 = static_cast<double>(edgeValues[2]) + lane * setup.xStep[2];
+            const double edges[3] = { e0, e1, e2 };
+
+            u[lane] = (edges[setup.uEdge] - setup.uBias) * setup.inverseDoubleArea;
+            v[lane] = (edges[setup.vEdge] - setup.vBias) * setup.inverseDoubleArea;
+
+            if (e0 >= 0.0 && e1 >= 0.0 && e2 >= 0.0){
+                mask |= SpanMask{1} << lane;
+            }
+        }
+
+        return mask;
+    }
+
+    SpanMask ScalarInterpolateDepth(const DepthSpanSetup& setup, const double* u, const double* v,
+                                    SpanMask mask, double* depth)
+    {
+        for (int lane = 0; lane < SPAN_WIDTH; ++lane){
+            if (!(mask & (SpanMask{1} << lane))) continue;
+
+            const double inverseDepthValue = setup.inverseWOrigin + setup.inverseWUDelta * u[lane] + setup.inverseWVDelta * v[lane];
+            if (inverseDepthValue >= 0.0){
+                depth[lane] = 1.0 / inverseDepthValue;
+            } else {
+                mask &= ~(SpanMask{1} << lane);
+            }
+        }
+
+        return mask;
+    }
+
+    SpanMask ScalarDepthTest(const double* storedDepth, const double* depth, SpanMask mask, bool acceptEqual)
+    {
+        for (int lane = 0; lane < SPAN_WIDTH; ++lane){
+            if (!(mask & (SpanMask{1} << lane))) continue;
+
+            const bool passed = acceptEqual ? depth[lane] <= storedDepth[lane] : depth[lane] < storedDepth[lane];
+            if (!passed){
+                mask &= ~(SpanMask{1} << lane);
+            }
+        }
+
+        return mask;
+    }
+
+    template<typename DepthType, bool GREATER_IS_CLOSER>
+    SpanMask ScalarDepthTestFormat(const DepthType* storedDepth, const DepthType* depth, SpanMask mask, bool acceptEqual)
+    {
+        for (int lane = 0; lane < SPAN_WIDTH; ++lane){
+            if (!(mask & (SpanMask{1} << lane))) continue;
+
+            const DepthType closer = GREATER_IS_CLOSER ? depth[lane] : storedDepth[lane];
+            const DepthType farther = GREATER_IS_CLOSER ? storedDepth[lane] : depth[lane];
+
+            const bool passed = acceptEqual ? farther <= closer : farther < closer;
+            if (!passed){
+                mask &= ~(SpanMask{1} << lane);
+            }
+        }
+
+        return mask;
+    }
+
+    SpanMask ScalarDepthTestReversedFloat(const float* storedDepth, const float* depth, SpanMask mask, bool acceptEqual)
+    {
+        return ScalarDepthTestFormat<float, true>(storedDepth, depth, mask, acceptEqual);
+    }
+
+    SpanMask ScalarDepthTestUnorm(const uint32_t* storedDepth, const uint32_t* depth, SpanMask mask, bool acceptEqual)
+    {
+        return ScalarDepthTestFormat<uint32_t, false>(storedDepth, depth, mask, acceptEqual);
+    }
+
+    inline float Clamp01(float value) {
+        return min(max(value, 0.0F), 1.0F);
+    }
+
+    void ScalarEvaluateLighting(const LightingSpan& span, const float (&lightPosition)[3], int count,
+                                float* lambertTerm, float* reflectionTerm)
+    {
+        for (int lane = 0; lane < count; ++lane){
+            const float px = span.positionX[lane], py = span.positionY[lane], pz = span.positionZ[lane];
+
+            float lx = lightPosition[0] - px, ly = lightPosition[1] - py, lz = lightPosition[2] - pz;
+            float nx = span.normalX[lane], ny = span.normalY[lane], nz = span.normalZ[lane];
+
+            const float inverseLightLength = 1.0F / sqrt(lx * lx + ly * ly + lz * lz);
+            lx *= inverseLightLength; ly *= inverseLightLength; lz *= inverseLightLength;
+
+            const float inverseNormalLength = 1.0F / sqrt(nx * nx + ny * ny + nz * nz);
+            nx *= inverseNormalLength; ny *= inverseNormalLength; nz *= inverseNormalLength;
+
+            const float inversePositionLength = 1.0F / sqrt(px * px + py * py + pz * pz);
+            const float vx = -(px * inversePositionLength), vy = -(py * inversePositionLength), vz = -(pz * inversePositionLength);
+
+            const float dotLN = lx * nx + ly * ny + lz * nz;
+            lambertTerm[lane] = Clamp01(dotLN);
+
+            const float twoDotLN = 2.0F * dotLN;
+            float rx = twoDotLN * nx - lx, ry = twoDotLN * ny - ly, rz = twoDotLN * nz - lz;
+
+            const float inverseReflectionLength = 1.0F / sqrt(rx * rx + ry * ry + rz * rz);
+            rx *= inverseReflectionLength; ry *= inverseReflectionLength; rz *= inverseReflectionLength;
+
+            reflectionTerm[lane] = Clamp01(rx * vx + ry * vy + rz * vz);
+        }
+    }
+
+#ifdef PV_SPAN_KERNELS_X86
+
+    //------ SSE2
+
+    inline SpanMask GetLaneCountMask(int count) {
+        return count >= SPAN_WIDTH ? (SpanMask{1} << SPAN_WIDTH) - 1 : (SpanMask{1} << count) - 1;
+    }
+
+    SpanMask Sse2EvaluateEdges(const EdgeSpanSetup& setup, const int64_t (&edgeValues)[3], int count,
+                               double* u, double* v)
+    {
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d inverseDoubleArea = _mm_set1_pd(setup.inverseDoubleArea);
+        const __m128d uBias = _mm_set1_pd(setup.uBias);
+        const __m128d vBias = _mm_set1_pd(setup.vBias);
+
+        __m128d edges[3];
+        __m128d edgeSteps[3];
+        for (int edge = 0; edge < 3; ++edge){
+            const double origin = static_cast<double>(edgeValues[edge]);
+            edges[edge] = _mm_set_pd(origin + setup.xStep[edge], origin);
+            edgeSteps[edge] = _mm_set1_pd(2.0 * setup.xStep[edge]);
+        }
+
+        SpanMask mask = 0;
+        for (int lane = 0; lane < SPAN_WIDTH; lane += 2){
+            const __m128d covered = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(edges[0], zero),
+                                                          _mm_cmpge_pd(edges[1], zero)),
+                                               _mm_cmpge_pd(edges[2], zero));
+            mask |= static_cast<SpanMask>(_mm_movemask_pd(covered)) << lane;
+
+            _mm_storeu_pd(u + lane, _mm_mul_pd(_mm_sub_pd(edges[setup.uEdge], uBias), inverseDoubleArea));
+            _mm_storeu_pd(v + lane, _mm_mul_pd(_mm_sub_pd(edges[setup.vEdge], vBias), inverseDoubleArea));
+
+            edges[0] = _mm_add_pd(edges[0], edgeSteps[0]);
+            edges[1] = _mm_add_pd(edges[1], edgeSteps[1]);
+            edges[2] = _mm_add_pd(edges[2], edgeSteps[2]);
+        }
+
+        return mask & GetLaneCountMask(count);
+    }
+
+    SpanMask Sse2InterpolateDepth(const DepthSpanSetup& setup, const double* u, const double* v,
+                                  SpanMask mask, double* depth)
+    {
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1.0);
+        const __m128d origin = _mm_set1_pd(setup.inverseWOrigin);
+        const __m128d uDelta = _mm_set1_pd(setup.inverseWUDelta);
+        const __m128d vDelta = _mm_set1_pd(setup.inverseWVDelta);
+
+        SpanMask inFrontMask = 0;
+        for (int lane = 0; lane < SPAN_WIDTH; lane += 2){
+            const __m128d inverseDepth = _mm_add_pd(_mm_add_pd(origin, _mm_mul_pd(uDelta, _mm_loadu_pd(u + lane))),
+                                                    _mm_mul_pd(vDelta, _mm_loadu_pd(v + lane)));
+
+            inFrontMask |= static_cast<SpanMask>(_mm_movemask_pd(_mm_cmpge_pd(inverseDepth, zero))) << lane;
+            _mm_storeu_pd(depth + lane, _mm_div_pd(one, inverseDepth));
+        }
+
+        return mask & inFrontMask;
+    }
+
+    SpanMask Sse2DepthTest(const double* storedDepth, const double* depth, SpanMask mask, bool acceptEqual)
+    {
+        SpanMask passedMask = 0;
+        for (int lane = 0; lane < SPAN_WIDTH; lane += 2){
+            const __m128d stored = _mm_loadu_pd(storedDepth + lane);
+            const __m128d incoming = _mm_loadu_pd(depth + lane);
+
+            const __m128d passed = acceptEqual ? _mm_cmple_pd(incoming, stored) : _mm_cmplt_pd(incoming, stored);
+            passedMask |= static_cast<SpanMask>(_mm_movemask_pd(passed)) << lane;
+        }
+
+        return mask & passedMask;
+    }
+
+    SpanMask Sse2DepthTestReversedFloat(const float* storedDepth, const float* depth, SpanMask mask, bool acceptEqual)
+    {
+        SpanMask passedMask = 0;
+        for (int lane = 0; lane < SPAN_WIDTH; lane += 4){
+            const __m128 stored = _mm_loadu_ps(storedDepth + lane);
+            const __m128 incoming = _mm_loadu_ps(depth + lane);
+
+            const __m128 passed = acceptEqual ? _mm_cmpge_ps(incoming, stored) : _mm_cmpgt_ps(incoming, stored);
+            passedMask |= static_cast<SpanMask>(_mm_movemask_ps(passed)) << lane;
+        }
+
+        return mask & passedMask;
+    }
+
+    // Unorm depth only uses the low 24 bits, so signed 32-bit compares are exact.
+    SpanMask Sse2DepthTestUnorm(const uint32_t* storedDepth, const uint32_t* depth, SpanMask mask, bool acceptEqual)
+    {
+        SpanMask failedMask = 0;
+        for (int lane = 0; lane < SPAN_WIDTH; lane += 4){
+            const __m128i stored = _mm_loadu_si128(reinterpret_cast<const __m128i*>(storedDepth + lane));
+            const __m128i incoming = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + lane));
+
+            const __m128i failed = acceptEqual ? _mm_cmpgt_epi32(incoming, stored)
+                                               : _mm_or_si128(_mm_cmpgt_epi32(incoming, stored), _mm_cmpeq_epi32(incoming, stored));
+            failedMask |= static_cast<SpanMask>(_mm_movemask_ps(_mm_castsi128_ps(failed))) << lane;
+        }
+
+        return mask & ~failedMask;
+    }
+
+    inline __m128 Sse2Clamp01(__m128 value) {
+        return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0F));
+    }
+
+    inline __m128 Sse2InverseLength(__m128 x, __m128 y, __m128 z) {
+        const __m128 squaredLength = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        return _mm_div_ps(_mm_set1_ps(1.0F), _mm_sqrt_ps(squaredLength));
+    }
+
+    void Sse2EvaluateLighting(const LightingSpan& span, const float (&lightPosition)[3], int,
+                              float* lambertTerm, float* reflectionTerm)
+    {
+        const __m128 negativeZero = _mm_set1_ps(-0.0F);
+        const __m128 two = _mm_set1_ps(2.0F);
+
+        for (int lane = 0; lane < SPAN_WIDTH; lane += 4){
+            const __m128 px = _mm_loadu_ps(span.positionX + lane);
+            const __m128 py = _mm_loadu_ps(span.positionY + lane);
+            const __m128 pz = _mm_loadu_ps(span.positionZ + lane);
+
+            __m128 lx = _mm_sub_ps(_mm_set1_ps(lightPosition[0]), px);
+            __m128 ly = _mm_sub_ps(_mm_set1_ps(lightPosition[1]), py);
+            __m128 lz = _mm_sub_ps(_mm_set1_ps(lightPosition[2]), pz);
+            const __m128 inverseLightLength = Sse2InverseLength(lx, ly, lz);
+            lx = _mm_mul_ps(lx, inverseLightLength); ly = _mm_mul_ps(ly, inverseLightLength); lz = _mm_mul_ps(lz, inverseLightLength);
+
+            __m128 nx = _mm_loadu_ps(span.normalX + lane);
+            __m128 ny = _mm_loadu_ps(span.normalY + lane);
+            __m128 nz = _mm_loadu_ps(span.normalZ + lane);
+            const __m128 inverseNormalLength = Sse2InverseLength(nx, ny, nz);
+            nx = _mm_mul_ps(nx, inverseNormalLength); ny = _mm_mul_ps(ny, inverseNormalLength); nz = _mm_mul_ps(nz, inverseNormalLength);
+
+            const __m128 inversePositionLength = Sse2InverseLength(px, py, pz);
+            const __m128 vx = _mm_xor_ps(_mm_mul_ps(px, inversePositionLength), negativeZero);
+            const __m128 vy = _mm_xor_ps(_mm_mul_ps(py, inversePositionLength), negativeZero);
+            const __m128 vz = _mm_xor_ps(_mm_mul_ps(pz, inversePositionLength), negativeZero);
+
+            const __m128 dotLN = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, nx), _mm_mul_ps(ly, ny)), _mm_mul_ps(lz, nz));
+            _mm_storeu_ps(lambertTerm + lane, Sse2Clamp01(dotLN));
+
+            const __m128 twoDotLN = _mm_mul_ps(two, dotLN);
+            __m128 rx = _mm_sub_ps(_mm_mul_ps(twoDotLN, nx), lx);
+            __m128 ry = _mm_sub_ps(_mm_mul_ps(twoDotLN, ny), ly);
+            __m128 rz = _mm_sub_ps(_mm_mul_ps(twoDotLN, nz), lz);
+            const __m128 inverseReflectionLength = Sse2InverseLength(rx, ry, rz);
+            rx = _mm_mul_ps(rx, inverseReflectionLength); ry = _mm_mul_ps(ry, inverseReflectionLength); rz = _mm_mul_ps(rz, inverseReflectionLength);
+
+            const __m128 dotRV = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, vx), _mm_mul_ps(ry, vy)), _mm_mul_ps(rz, vz));
+            _mm_storeu_ps(reflectionTerm + lane, Sse2Clamp01(dotRV));
+        }
+    }
+
+    //------ AVX2
+
+    PV_TARGET_AVX2
+    SpanMask Avx2EvaluateEdges(const EdgeSpanSetup& setup, const int64_t (&edgeValues)[3], int count,
+                               double* u, double* v)
+    {
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d inverseDoubleArea = _mm256_set1_pd(setup.inverseDoubleArea);
+        const __m256d uBias = _mm256_set1_pd(setup.uBias);
+        const __m256d vBias = _mm256_set1_pd(setup.vBias);
+        const __m256d laneOffsets = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+
+        __m256d edges[3];
+        __m256d edgeSteps[3];
+        for (int edge = 0; edge < 3; ++edge){
+            const __m256d xStep = _mm256_set1_pd(setup.xStep[edge]);
+            edges[edge] = _mm256_add_pd(_mm256_set1_pd(static_cast<double>(edgeValues[edge])), _mm256_mul_pd(laneOffsets, xStep));
+            edgeSteps[edge] = _mm256_set1_pd(4.0 * setup.xStep[edge]);
+        }
+
+        SpanMask mask = 0;
+        for (int lane = 0; lane < SPAN_WIDTH; lane += 4){
+            const __m256d covered = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(edges[0], zero, _CMP_GE_OQ),
+                                                                _mm256_cmp_pd(edges[1], zero, _CMP_GE_OQ)),
+                                                  _mm256_cmp_pd(edges[2], zero, _CMP_GE_OQ));
+            mask |= static_cast<SpanMask>(_mm256_movemask_pd(covered)) << lane;
+
+            _mm256_storeu_pd(u + lane, _mm256_mul_pd(_mm256_sub_pd(edges[setup.uEdge], uBias), inverseDoubleArea));
+            _mm256_storeu_pd(v + lane, _mm256_mul_pd(_mm256_sub_pd(edges[setup.vEdge], vBias), inverseDoubleArea));
+
+            edges[0] = _mm256_add_pd(edges[0], edgeSteps[0]);
+            edges[1] = _mm256_add_pd(edges[1], edgeSteps[1]);
+            edges[2] = _mm256_add_pd(edges[2], edgeSteps[2]);
+        }
+
+        return mask & GetLaneCountMask(count);
+    }
+
+    PV_TARGET_AVX2
+    SpanMask Avx2InterpolateDepth(const DepthSpanSetup& setup, const double* u, const double* v,
+                                  SpanMask mask, double* depth)
+    {
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d origin = _mm256_set1_pd(setup.inverseWOrigin);
+        const __m256d uDelta = _mm256_set1_pd(setup.inverseWUDelta);
+        const __m256d vDelta = _mm256_set1_pd(setup.inverseWVDelta);
+
+        SpanMask inFrontMask = 0;
+        for (int lane = 0; lane < SPAN_WIDTH; lane += 4){
+            const __m256d inverseDepth = _mm256_add_pd(_mm256_add_pd(origin, _mm256_mul_pd(uDelta, _mm256_loadu_pd(u + lane))),
+                                                       _mm256_mul_pd(vDelta, _mm256_loadu_pd(v + lane)));
+
+            inFrontMask |= static_cast<SpanMask>(_mm256_movemask_pd(_mm256_cmp_pd(inverseDepth, zero, _CMP_GE_OQ))) << lane;
+            _mm256_storeu_pd(depth + lane, _mm256_div_pd(one, inverseDepth));
+        }
+
+        return mask & inFrontMask;
+    }
+
+    PV_TARGET_AVX2
+    SpanMask Avx2DepthTest(const double* storedDepth, const double* depth, SpanMask mask, bool acceptEqual)
+    {
+        SpanMask passedMask = 0;
+        for (int lane = 0; lane < SPAN_WIDTH; lane += 4){
+            const __m256d stored = _mm256_loadu_pd(storedDepth + lane);
+            const __m256d incoming = _mm256_loadu_pd(depth + lane);
+
+            const __m256d passed = acceptEqual ? _mm256_cmp_pd(incoming, stored, _CMP_LE_OQ)
+                                               : _mm256_cmp_pd(incoming, stored, _CMP_LT_OQ);
+            passedMask |= static_cast<SpanMask>(_mm256_movemask_pd(passed)) << lane;
+        }
+
+        return mask & passedMask;
+    }
+
+    PV_TARGET_AVX2
+    SpanMask Avx2DepthTestReversedFloat(const float* storedDepth, const float* depth, SpanMask mask, bool acceptEqual)
+    {
+        const __m256 stored = _mm256_loadu_ps(storedDepth);
+        const __m256 incoming = _mm256_loadu_ps(depth);
+
+        const __m256 passed = acceptEqual ? _mm256_cmp_ps(incoming, stored, _CMP_GE_OQ)
+                                          : _mm256_cmp_ps(incoming, stored, _CMP_GT_OQ);
+
+        return mask & static_cast<SpanMask>(_mm256_movemask_ps(passed));
+    }
+
+    PV_TARGET_AVX2
+    SpanMask Avx2DepthTestUnorm(const uint32_t* storedDepth, const uint32_t* depth, SpanMask mask, bool acceptEqual)
+    {
+        const __m256i stored = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(storedDepth));
+        const __m256i incoming = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(depth));
+
+        const __m256i failed = acceptEqual ? _mm256_cmpgt_epi32(incoming, stored)
+                                           : _mm256_or_si256(_mm256_cmpgt_epi32(incoming, stored), _mm256_cmpeq_epi32(incoming, stored));
+
+        return mask & ~static_cast<SpanMask>(_mm256_movemask_ps(_mm256_castsi256_ps(failed)));
+    }
+
+    PV_TARGET_AVX2
+    inline __m256 Avx2InverseLength(__m256 x, __m256 y, __m256 z) {
+        const __m256 squaredLength = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+        return _mm256_div_ps(_mm256_set1_ps(1.0F), _mm256_sqrt_ps(squaredLength));
+    }
+
+    PV_TARGET_AVX2
+    inline __m256 Avx2Clamp01(__m256 value) {
+        return _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0F));
+    }
+
+    PV_TARGET_AVX2
+    void Avx2EvaluateLighting(const LightingSpan& span, const float (&lightPosition)[3], int,
+                              float* lambertTerm, float* reflectionTerm)
+    {
+        static_assert(SPAN_WIDTH == 8, "AVX2 lighting kernel processes one span per register");
+
+        const __m256 px = _mm256_loadu_ps(span.positionX);
+        const __m256 py = _mm256_loadu_ps(span.positionY);
+        const __m256 pz = _mm256_loadu_ps(span.positionZ);
+
+        __m256 lx = _mm256_sub_ps(_mm256_set1_ps(lightPosition[0]), px);
+        __m256 ly = _mm256_sub_ps(_mm256_set1_ps(lightPosition[1]), py);
+        __m256 lz = _mm256_sub_ps(_mm256_set1_ps(lightPosition[2]), pz);
+        const __m256 inverseLightLength = Avx2InverseLength(lx, ly, lz);
+        lx = _mm256_mul_ps(lx, inverseLightLength); ly = _mm256_mul_ps(ly, inverseLightLength); lz = _mm256_mul_ps(lz, inverseLightLength);
+
+        __m256 nx = _mm256_loadu_ps(span.normalX);
+        __m256 ny = _mm256_loadu_ps(span.normalY);
+        __m256 nz = _mm256_loadu_ps(span.normalZ);
+        const __m256 inverseNormalLength = Avx2InverseLength(nx, ny, nz);
+        nx = _mm256_mul_ps(nx, inverseNormalLength); ny = _mm256_mul_ps(ny, inverseNormalLength); nz = _mm256_mul_ps(nz, inverseNormalLength);
+
+        const __m256 negativeZero = _mm256_set1_ps(-0.0F);
+        const __m256 inversePositionLength = Avx2InverseLength(px, py, pz);
+        const __m256 vx = _mm256_xor_ps(_mm256_mul_ps(px, inversePositionLength), negativeZero);
+        const __m256 vy = _mm256_xor_ps(_mm256_mul_ps(py, inversePositionLength), negativeZero);
+        const __m256 vz = _mm256_xor_ps(_mm256_mul_ps(pz, inversePositionLength), negativeZero);
+
+        const __m256 dotLN = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, nx), _mm256_mul_ps(ly, ny)), _mm256_mul_ps(lz, nz));
+        _mm256_storeu_ps(lambertTerm, Avx2Clamp01(dotLN));
+
+        const __m256 twoDotLN = _mm256_mul_ps(_mm256_set1_ps(2.0F), dotLN);
+        __m256 rx = _mm256_sub_ps(_mm256_mul_ps(twoDotLN, nx), lx);
+        __m256 ry = _mm256_sub_ps(_mm256_mul_ps(twoDotLN, ny), ly);
+        __m256 rz = _mm256_sub_ps(_mm256_mul_ps(twoDotLN, nz), lz);
+        const __m256 inverseReflectionLength = Avx2InverseLength(rx, ry, rz);
+        rx = _mm256_mul_ps(rx, inverseReflectionLength); ry = _mm256_mul_ps(ry, inverseReflectionLength); rz = _mm256_mul_ps(rz, inverseReflectionLength);
+
+        const __m256 dotRV = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rx, vx), _mm256_mul_ps(ry, vy)), _mm256_mul_ps(rz, vz));
+        _mm256_storeu_ps(reflectionTerm, Avx2Clamp01(dotRV));
+    }
+
+#endif // PV_SPAN_KERNELS_X86
+
+    SIMD_LEVEL GetSupportedSimdLevel() {
+#ifdef PV_SPAN_KERNELS_X86
+    #if defined(_MSC_VER)
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 1);
+        const bool osSavesAvxState = (cpuInfo[2] & (1 << 27)) && (cpuInfo[2] & (1 << 28)) &&
+                                     ((_xgetbv(0) & 0x6) == 0x6);
+
+        __cpuidex(cpuInfo, 7, 0);
+        const bool avx2Supported = osSavesAvxState && (cpuInfo[1] & (1 << 5));
+    #else
+        __builtin_cpu_init();
+        const bool avx2Supported = __builtin_cpu_supports("avx2");
+    #endif
+        return avx2Supported ? SIMD_LEVEL::AVX2 : SIMD_LEVEL::SSE2;
+#else
+        return SIMD_LEVEL::SCALAR;
+#endif
+    }
+
+    const SpanKernels& GetSpanKernels(SIMD_LEVEL simdLevel) {
+        static const SpanKernels scalarKernels {
+            ScalarEvaluateEdges, ScalarInterpolateDepth,
+            ScalarDepthTest, ScalarDepthTestReversedFloat, ScalarDepthTestUnorm,
+            ScalarEvaluateLighting
+        };
+
+#ifdef PV_SPAN_KERNELS_X86
+        static const SpanKernels sse2Kernels {
+            Sse2EvaluateEdges, Sse2InterpolateDepth,
+            Sse2DepthTest, Sse2DepthTestReversedFloat, Sse2DepthTestUnorm,
+            Sse2EvaluateLighting
+        };
+
+        static const SpanKernels avx2Kernels {
+            Avx2EvaluateEdges, Avx2InterpolateDepth,
+            Avx2DepthTest, Avx2DepthTestReversedFloat, Avx2DepthTestUnorm,
+            Avx2EvaluateLighting
+        };
+
+        switch (simdLevel) {
+            case SIMD_LEVEL::AVX2: return avx2Kernels;
+            case SIMD_LEVEL::SSE2: return sse2Kernels;
+            case SIMD_LEVEL::SCALAR: break;
+        }
+#else
+        (void)simdLevel;
+#endif
+        return scalarKernels;
+    }
+
+    const SpanKernels& GetSpanKernels() {
+        static const SpanKernels& supportedKernels = GetSpanKernels(GetSupportedSimdLevel());
+        return supportedKernels;
+    }
+
+} // namespace pv
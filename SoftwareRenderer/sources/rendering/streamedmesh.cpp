@@ -0,0 +1,788 @@
+#include "headers/rendering/streamedmesh.h"
+#include "headers/object_file_parser/meshcache.h"
+#include "headers/object_file_parser/objectfileparser.h"
+#include "headers/rendering/vertexwelder.h"
+#include "headers/threading/threadpool.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+using namespace std;
+
+namespace pv {
+
+    constexpr char CHUNK_FILE_MAGIC[8] = { 'P', 'V', 'C', 'H', 'U', 'N', 'K', 'S' };
+    constexpr uint32_t CHUNK_FILE_VERSION = 2;
+    constexpr uint32_t CHUNK_FILE_BYTE_ORDER_MARK = 0x01020304;
+    constexpr uint64_t CHUNK_FILE_ALIGNMENT = 64;
+
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float) && is_trivially_copyable_v<glm::vec3>,
+                  "Chunk vertices are stored as the in-memory glm::vec3 layout");
+
+    // What a chunk file was made from: the size and content hash of the OBJ
+    // file and the settings it was chunked with. A chunk file is only reused
+    // when all of them still match.
+    struct ChunkFileSource {
+        uint64_t objectFileSize;
+        uint64_t objectFileHash;
+        uint64_t trianglesPerChunk;
+        bool yzAxesFixed;
+    };
+
+    struct ChunkFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+
+        uint64_t sourceSize;
+        uint64_t sourceHash;
+        uint64_t trianglesPerChunk;
+        uint32_t yzAxesFixed;
+
+        uint32_t hasTextureCoords;
+        uint32_t hasNormals;
+        uint64_t chunkCount;
+        BoundingBox bounds;
+    };
+
+    inline bool IsChunkFileHeader(const ChunkFileHeader& header) {
+        return memcmp(header.magic, CHUNK_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+               header.version == CHUNK_FILE_VERSION &&
+               header.byteOrderMark == CHUNK_FILE_BYTE_ORDER_MARK;
+    }
+
+    inline ChunkFileSource GetChunkFileSource(
+            const ObjectFileParser& objectFileParser,
+            const std::string& objectFilePath,
+            size_t trianglesPerChunk)
+    {
+        const MappedFile objectFile(objectFilePath);
+        ThreadPool threadPool;
+        return { objectFile.GetSize(), GetContentHash(objectFile.GetView(), threadPool),
+                 trianglesPerChunk, objectFileParser.GetDoApplyYZAxesFix() };
+    }
+
+    // Chunk data is its vertices, then texture coordinates and normals when
+    // the mesh has them, one per vertex, then three uint32_t indices per triangle.
+    struct ChunkTableEntry {
+        BoundingBox bounds;
+        uint32_t vertexCount;
+        uint32_t triangleCount;
+        uint64_t offset;
+    };
+
+    inline uint64_t AlignChunkOffset(uint64_t offset) {
+        return (offset + CHUNK_FILE_ALIGNMENT - 1) / CHUNK_FILE_ALIGNMENT * CHUNK_FILE_ALIGNMENT;
+    }
+
+    inline uint64_t GetChunkDataSize(const ChunkFileHeader& header, const ChunkTableEntry& entry) {
+        const uint64_t vertexArrayCount = 1 + header.hasTextureCoords + header.hasNormals;
+        return vertexArrayCount * entry.vertexCount * sizeof(glm::vec3) +
+               uint64_t{3} * entry.triangleCount * sizeof(uint32_t);
+    }
+
+    template<typename Element>
+    const char* ReadChunkArray(const char* data, size_t count, std::vector<Element>& elements) {
+        elements.resize(count);
+        memcpy(elements.data(), data, count * sizeof(Element));
+        return data + count * sizeof(Element);
+    }
+
+    // Ranges of triangle order, each of at most trianglesPerChunk triangles,
+    // made by splitting at the median centroid along the longest axis of the
+    // centroid bounds until the ranges are small enough.
+    inline std::vector<std::pair<size_t, size_t>> PartitionTriangles(
+            std::vector<uint32_t>& triangleOrder,
+            const std::vector<glm::vec3>& centroids,
+            size_t trianglesPerChunk)
+    {
+        vector<pair<size_t, size_t>> chunkRanges;
+        vector<pair<size_t, size_t>> pendingRanges;
+        if (!triangleOrder.empty()) pendingRanges.emplace_back(0, triangleOrder.size());
+
+        while (!pendingRanges.empty()){
+            const auto [rangeBegin, rangeEnd] = pendingRanges.back();
+            pendingRanges.pop_back();
+
+            if (rangeEnd - rangeBegin <= trianglesPerChunk){
+                chunkRanges.emplace_back(rangeBegin, rangeEnd);
+                continue;
+            }
+
+            BoundingBox centroidBounds;
+            for (size_t idx = rangeBegin; idx < rangeEnd; ++idx){
+                centroidBounds.Extend(centroids[triangleOrder[idx]]);
+            }
+            const glm::vec3 extent = centroidBounds.GetExtent();
+            const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+            const size_t rangeMiddle = rangeBegin + (rangeEnd - rangeBegin) / 2;
+            nth_element(triangleOrder.begin() + rangeBegin,
+                        triangleOrder.begin() + rangeMiddle,
+                        triangleOrder.begin() + rangeEnd,
+                        [&centroids, axis](uint32_t first, uint32_t second){
+                            return centroids[first][axis] < centroids[second][axis];
+                        });
+
+            pendingRanges.emplace_back(rangeMiddle, rangeEnd);
+            pendingRanges.emplace_back(rangeBegin, rangeMiddle);
+        }
+        return chunkRanges;
+    }
+
+    // Number of ranges PartitionTriangles cuts triangleCount triangles into.
+    inline uint64_t GetPartitionCount(uint64_t triangleCount, uint64_t trianglesPerChunk) {
+        if (triangleCount == 0) return 0;
+        if (triangleCount <= trianglesPerChunk) return 1;
+        return GetPartitionCount(triangleCount / 2, trianglesPerChunk) +
+               GetPartitionCount(triangleCount - triangleCount / 2, trianglesPerChunk);
+    }
+
+    // Triangle of an OBJ file before welding: the position, texture coordinate
+    // and normal index of each corner.
+    using ObjectFileTriangle = std::array<std::array<int, 3>, 3>;
+
+    // Triangles are binned into cells of at most BIN_TRIANGLE_LIMIT triangles
+    // before they are split into chunks in memory, which bounds the memory a
+    // chunk file takes to build by the size of a cell. Bins live in a scratch
+    // file, in blocks of BIN_BLOCK_TRIANGLES, and one bin is split into at most
+    // MAX_BIN_SPLIT_CELLS, each buffering one block while the bin is read.
+    constexpr size_t BIN_TRIANGLE_LIMIT = 1 << 21;
+    constexpr size_t BIN_BLOCK_TRIANGLES = 1024;
+    constexpr size_t MAX_BIN_SPLIT_CELLS = 512;
+
+    // bounds holds the centroids of the triangles, except for the bin of all
+    // triangles, which holds every position of the file.
+    struct TriangleBin {
+        BoundingBox bounds;
+        uint64_t triangleCount = 0;
+        // File offset and triangle count of each block.
+        std::vector<std::pair<uint64_t, uint32_t>> blocks;
+    };
+
+    // File next to the chunk file that only lives while the chunk file is built.
+    class ScratchFile {
+    public:
+        explicit ScratchFile(const std::string& filePath) :
+            file_path_(filePath),
+            file_(filePath, ios::binary | ios::in | ios::out | ios::trunc),
+            size_(0)
+        {
+            if (!file_) throw runtime_error("Can't create " + file_path_);
+        }
+
+        ~ScratchFile() {
+            file_.close();
+            error_code removeError;
+            filesystem::remove(file_path_, removeError);
+        }
+
+        // Offset the data was written at.
+        uint64_t Append(const void* data, size_t size) {
+            const uint64_t offset = size_;
+            file_.seekp(static_cast<streamoff>(offset));
+            file_.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+            if (!file_) throw runtime_error("Can't write " + file_path_);
+
+            size_ += size;
+            return offset;
+        }
+
+        void Read(uint64_t offset, void* data, size_t size) {
+            file_.seekg(static_cast<streamoff>(offset));
+            file_.read(static_cast<char*>(data), static_cast<streamsize>(size));
+            if (!file_) throw runtime_error("Can't read " + file_path_);
+        }
+
+        // Flushes what was written so far, to map the file.
+        const std::string& Flush() {
+            file_.flush();
+            if (!file_) throw runtime_error("Can't write " + file_path_);
+            return file_path_;
+        }
+
+        ScratchFile(const ScratchFile&) = delete;
+        ScratchFile& operator=(const ScratchFile&) = delete;
+
+    private:
+        std::string file_path_;
+        fstream file_;
+        uint64_t size_;
+    };
+
+    inline void AppendBinBlock(ScratchFile& binFile, std::vector<ObjectFileTriangle>& triangles, TriangleBin& bin) {
+        if (triangles.empty()) return;
+
+        const uint64_t blockOffset = binFile.Append(triangles.data(), triangles.size() * sizeof(ObjectFileTriangle));
+        bin.blocks.emplace_back(blockOffset, static_cast<uint32_t>(triangles.size()));
+        bin.triangleCount += triangles.size();
+        triangles.clear();
+    }
+
+    template<typename BlockHandler>
+    void ForEachBinBlock(ScratchFile& binFile, const TriangleBin& bin, BlockHandler&& blockHandler) {
+        std::vector<ObjectFileTriangle> triangles(BIN_BLOCK_TRIANGLES);
+        for (const auto& [blockOffset, triangleCount] : bin.blocks){
+            binFile.Read(blockOffset, triangles.data(), triangleCount * sizeof(ObjectFileTriangle));
+            blockHandler(triangles.data(), size_t{triangleCount});
+        }
+    }
+
+    // Attributes of the OBJ file, mapped from the scratch files they went to
+    // while reading it. Texture coordinates and normals are only kept when
+    // every corner has one, as when welding the whole file.
+    struct ObjectFileAttributes {
+        std::string_view positions;
+        std::string_view vertexTextures;
+        std::string_view vertexNormals;
+        bool hasTextureCoords;
+        bool hasNormals;
+
+        static const glm::vec3& GetAttribute(std::string_view attributes, int index) {
+            return reinterpret_cast<const glm::vec3*>(attributes.data())[index];
+        }
+
+        static bool IndexIsValid(std::string_view attributes, int index) {
+            return index >= 0 && static_cast<size_t>(index) < attributes.size() / sizeof(glm::vec3);
+        }
+
+        void CheckTriangle(const ObjectFileTriangle& triangle) const {
+            for (const std::array<int, 3>& corner : triangle){
+                if (!IndexIsValid(positions, corner[0])){
+                    throw runtime_error("Polygon refers to a missing vertex position");
+                }
+                if (corner[1] != VertexWelder::NO_INDEX && !IndexIsValid(vertexTextures, corner[1])){
+                    throw runtime_error("Polygon refers to a missing texture coordinate");
+                }
+                if (corner[2] != VertexWelder::NO_INDEX && !IndexIsValid(vertexNormals, corner[2])){
+                    throw runtime_error("Polygon refers to a missing normal");
+                }
+            }
+        }
+
+        glm::vec3 GetCentroid(const ObjectFileTriangle& triangle) const {
+            return (GetAttribute(positions, triangle[0][0]) +
+                    GetAttribute(positions, triangle[1][0]) +
+                    GetAttribute(positions, triangle[2][0])) / 3.0F;
+        }
+    };
+
+    // Bins the triangles of bin by their centroids into the cells of a grid
+    // over its bounds, and returns the cells that got any. The grid is refined
+    // along the axis of the longest cells until it has enough cells for each
+    // to hold about half of binTriangleLimit triangles.
+    inline std::vector<TriangleBin> SplitTriangleBin(
+            ScratchFile& binFile,
+            const TriangleBin& bin,
+            const ObjectFileAttributes& attributes,
+            size_t binTriangleLimit)
+    {
+        const uint64_t cellTarget = clamp<uint64_t>((2 * bin.triangleCount + binTriangleLimit - 1) / binTriangleLimit,
+                                                    2, MAX_BIN_SPLIT_CELLS / 2);
+        const glm::vec3 extent = bin.bounds.GetExtent();
+
+        array<size_t, 3> gridSize = { 1, 1, 1 };
+        while (gridSize[0] * gridSize[1] * gridSize[2] < cellTarget){
+            int axis = 0;
+            for (int otherAxis = 1; otherAxis < 3; ++otherAxis){
+                if (extent[otherAxis] / gridSize[otherAxis] > extent[axis] / gridSize[axis]) axis = otherAxis;
+            }
+            gridSize[axis] *= 2;
+        }
+
+        const size_t cellCount = gridSize[0] * gridSize[1] * gridSize[2];
+        vector<TriangleBin> cellBins(cellCount);
+        vector<vector<ObjectFileTriangle>> cellBlocks(cellCount);
+
+        ForEachBinBlock(binFile, bin, [&](const ObjectFileTriangle* triangles, size_t triangleCount){
+            for (size_t triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex){
+                const ObjectFileTriangle& triangle = triangles[triangleIndex];
+                attributes.CheckTriangle(triangle);
+                const glm::vec3 centroid = attributes.GetCentroid(triangle);
+
+                size_t cellIndex = 0;
+                for (int axis = 2; axis >= 0; --axis){
+                    const float gridPosition = extent[axis] > 0.0F ?
+                        (centroid[axis] - bin.bounds.minCorner[axis]) / extent[axis] * gridSize[axis] : 0.0F;
+                    const size_t cell = gridPosition > 0.0F ?
+                        (gridPosition < gridSize[axis] ? static_cast<size_t>(gridPosition) : gridSize[axis] - 1) : 0;
+                    cellIndex = cellIndex * gridSize[axis] + cell;
+                }
+
+                cellBins[cellIndex].bounds.Extend(centroid);
+                cellBlocks[cellIndex].push_back(triangle);
+                if (cellBlocks[cellIndex].size() == BIN_BLOCK_TRIANGLES){
+                    AppendBinBlock(binFile, cellBlocks[cellIndex], cellBins[cellIndex]);
+                }
+            }
+        });
+
+        for (size_t cellIndex = 0; cellIndex < cellCount; ++cellIndex){
+            AppendBinBlock(binFile, cellBlocks[cellIndex], cellBins[cellIndex]);
+        }
+
+        cellBins.erase(remove_if(cellBins.begin(), cellBins.end(), [](const TriangleBin& cellBin){
+                           return cellBin.triangleCount == 0;
+                       }),
+                       cellBins.end());
+        return cellBins;
+    }
+
+    // Writes the chunk file through a temporary file, renamed into place by
+    // Finish; the temporary file is removed again when that doesn't happen.
+    class ChunkFileWriter {
+    public:
+        ChunkFileWriter(const std::string& chunkFilePath, const ChunkFileSource& source,
+                        uint64_t chunkCount, bool hasTextureCoords, bool hasNormals) :
+            chunk_file_path_(chunkFilePath),
+            temporary_file_path_(chunkFilePath + ".tmp"),
+            chunk_file_(temporary_file_path_, ios::binary | ios::trunc),
+            header_{},
+            chunk_table_(chunkCount),
+            written_chunk_count_(0),
+            written_size_(0)
+        {
+            if (!chunk_file_) throw runtime_error("Can't create " + temporary_file_path_);
+
+            memcpy(header_.magic, CHUNK_FILE_MAGIC, sizeof(header_.magic));
+            header_.version = CHUNK_FILE_VERSION;
+            header_.byteOrderMark = CHUNK_FILE_BYTE_ORDER_MARK;
+            header_.sourceSize = source.objectFileSize;
+            header_.sourceHash = source.objectFileHash;
+            header_.trianglesPerChunk = source.trianglesPerChunk;
+            header_.yzAxesFixed = source.yzAxesFixed;
+            header_.chunkCount = chunkCount;
+            header_.hasTextureCoords = hasTextureCoords;
+            header_.hasNormals = hasNormals;
+
+            // The header and table are written again once the chunk bounds are known.
+            WriteAt(0, &header_, sizeof(header_));
+            WriteAt(sizeof(header_), chunk_table_.data(), chunk_table_.size() * sizeof(ChunkTableEntry));
+        }
+
+        ~ChunkFileWriter() {
+            if (!chunk_file_.is_open()) return;
+
+            chunk_file_.close();
+            error_code removeError;
+            filesystem::remove(temporary_file_path_, removeError);
+        }
+
+        // Texture coordinates and normals are left out unless the header says
+        // the mesh has them.
+        void WriteChunk(const std::vector<glm::vec3>& vertices,
+                        const std::vector<glm::vec3>& vertexTextures,
+                        const std::vector<glm::vec3>& vertexNormals,
+                        const std::vector<uint32_t>& triangleIndices)
+        {
+            ChunkTableEntry& entry = chunk_table_[written_chunk_count_++];
+            for (const glm::vec3& vertex : vertices){
+                entry.bounds.Extend(vertex);
+            }
+            entry.vertexCount = static_cast<uint32_t>(vertices.size());
+            entry.triangleCount = static_cast<uint32_t>(triangleIndices.size() / 3);
+            entry.offset = AlignChunkOffset(written_size_);
+            header_.bounds.Extend(entry.bounds);
+
+            WriteAt(entry.offset, vertices.data(), vertices.size() * sizeof(glm::vec3));
+            if (header_.hasTextureCoords) WriteAt(written_size_, vertexTextures.data(), vertexTextures.size() * sizeof(glm::vec3));
+            if (header_.hasNormals) WriteAt(written_size_, vertexNormals.data(), vertexNormals.size() * sizeof(glm::vec3));
+            WriteAt(written_size_, triangleIndices.data(), triangleIndices.size() * sizeof(uint32_t));
+        }
+
+        void Finish() {
+            chunk_file_.seekp(0);
+            chunk_file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+            chunk_file_.write(reinterpret_cast<const char*>(chunk_table_.data()),
+                              static_cast<streamsize>(chunk_table_.size() * sizeof(ChunkTableEntry)));
+
+            chunk_file_.close();
+            if (!chunk_file_){
+                error_code removeError;
+                filesystem::remove(temporary_file_path_, removeError);
+                throw runtime_error("Can't write " + temporary_file_path_);
+            }
+
+            error_code renameError;
+            filesystem::rename(temporary_file_path_, chunk_file_path_, renameError);
+            if (renameError){
+                filesystem::remove(temporary_file_path_, renameError);
+                throw runtime_error("Can't write " + chunk_file_path_);
+            }
+        }
+
+        ChunkFileWriter(const ChunkFileWriter&) = delete;
+        ChunkFileWriter& operator=(const ChunkFileWriter&) = delete;
+
+    private:
+        void WriteAt(uint64_t offset, const void* data, size_t size) {
+            static const char padding[CHUNK_FILE_ALIGNMENT] = {};
+            chunk_file_.write(padding, static_cast<streamsize>(offset - written_size_));
+            chunk_file_.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+            written_size_ = offset + size;
+        }
+
+        std::string chunk_file_path_;
+        std::string temporary_file_path_;
+        ofstream chunk_file_;
+
+        ChunkFileHeader header_;
+        std::vector<ChunkTableEntry> chunk_table_;
+        size_t written_chunk_count_;
+        uint64_t written_size_;
+    };
+
+    // Reads the triangles of bin into memory, splits them by PartitionTriangles
+    // and welds the vertices of each chunk on their own.
+    inline void WriteBinChunks(
+            ScratchFile& binFile,
+            const TriangleBin& bin,
+            const ObjectFileAttributes& attributes,
+            size_t trianglesPerChunk,
+            ChunkFileWriter& chunkFileWriter)
+    {
+        if (bin.triangleCount > UINT32_MAX) throw runtime_error("Too many coincident triangles for a chunk file");
+
+        vector<ObjectFileTriangle> triangles;
+        triangles.reserve(bin.triangleCount);
+        ForEachBinBlock(binFile, bin, [&](const ObjectFileTriangle* blockTriangles, size_t triangleCount){
+            triangles.insert(triangles.end(), blockTriangles, blockTriangles + triangleCount);
+        });
+
+        vector<glm::vec3> centroids(triangles.size());
+        vector<uint32_t> triangleOrder(triangles.size());
+        for (size_t triangleIndex = 0; triangleIndex < triangles.size(); ++triangleIndex){
+            attributes.CheckTriangle(triangles[triangleIndex]);
+            centroids[triangleIndex] = attributes.GetCentroid(triangles[triangleIndex]);
+            triangleOrder[triangleIndex] = static_cast<uint32_t>(triangleIndex);
+        }
+
+        const vector<pair<size_t, size_t>> chunkRanges = PartitionTriangles(triangleOrder, centroids, trianglesPerChunk);
+
+        vector<glm::vec3> chunkVertices, chunkTextures, chunkNormals;
+        vector<uint32_t> chunkTriangles;
+
+        for (const auto& [rangeBegin, rangeEnd] : chunkRanges){
+            VertexWelder vertexWelder;
+            chunkTriangles.clear();
+
+            for (size_t idx = rangeBegin; idx < rangeEnd; ++idx){
+                for (const std::array<int, 3>& corner : triangles[triangleOrder[idx]]){
+                    chunkTriangles.push_back(static_cast<uint32_t>(vertexWelder.GetVertexIndex(
+                        corner[0],
+                        attributes.hasTextureCoords ? corner[1] : VertexWelder::NO_INDEX,
+                        attributes.hasNormals ? corner[2] : VertexWelder::NO_INDEX)));
+                }
+            }
+
+            chunkVertices.clear();
+            chunkTextures.clear();
+            chunkNormals.clear();
+            for (size_t vertexIndex = 0; vertexIndex < vertexWelder.GetVertexCount(); ++vertexIndex){
+                const std::array<int, 3> attributeIndices = vertexWelder.GetAttributeIndices(vertexIndex);
+
+                chunkVertices.push_back(ObjectFileAttributes::GetAttribute(attributes.positions, attributeIndices[0]));
+                if (attributes.hasTextureCoords){
+                    chunkTextures.push_back(ObjectFileAttributes::GetAttribute(attributes.vertexTextures, attributeIndices[1]));
+                }
+                if (attributes.hasNormals){
+                    chunkNormals.push_back(ObjectFileAttributes::GetAttribute(attributes.vertexNormals, attributeIndices[2]));
+                }
+            }
+
+            chunkFileWriter.WriteChunk(chunkVertices, chunkTextures, chunkNormals, chunkTriangles);
+        }
+    }
+
+    // Three passes over the data, none of which holds more than a window of
+    // the OBJ text, a bin block per cell or one bin in memory:
+    // - the OBJ file is read, its attributes written to scratch files and its
+    //   polygons, split into triangles, into one bin;
+    // - bins over the triangle limit are split into cells until none is;
+    // - the chunks of each bin are written, which fixes the chunk count in
+    //   advance, so the chunk table can stay in front of the chunks.
+    void StreamedMesh::WriteChunkFile(
+            ObjectFileParser& objectFileParser,
+            const std::string& objectFilePath,
+            const std::string& chunkFilePath,
+            size_t trianglesPerChunk)
+    {
+        if (trianglesPerChunk == 0) throw runtime_error("A chunk must hold at least one triangle");
+
+        // Hashed up front, so a file changed while it is read is chunked again next time.
+        const ChunkFileSource source = GetChunkFileSource(objectFileParser, objectFilePath, trianglesPerChunk);
+
+        ScratchFile positionFile(chunkFilePath + ".positions.tmp");
+        ScratchFile textureFile(chunkFilePath + ".textures.tmp");
+        ScratchFile normalFile(chunkFilePath + ".normals.tmp");
+        ScratchFile binFile(chunkFilePath + ".bins.tmp");
+
+        TriangleBin rootBin;
+        vector<ObjectFileTriangle> rootBlock;
+        rootBlock.reserve(BIN_BLOCK_TRIANGLES);
+        bool allTextured = true;
+        bool allNormals = true;
+
+        objectFileParser.ReadObjectFileChunks(objectFilePath, [&](const ObjectFileParser::ObjectFileChunk& chunk){
+            positionFile.Append(chunk.vertices.data(), chunk.vertices.size() * sizeof(glm::vec3));
+            textureFile.Append(chunk.vertexTextures.data(), chunk.vertexTextures.size() * sizeof(glm::vec3));
+            normalFile.Append(chunk.vertexNormals.data(), chunk.vertexNormals.size() * sizeof(glm::vec3));
+
+            for (const glm::vec3& vertex : chunk.vertices){
+                rootBin.bounds.Extend(vertex);
+            }
+
+            const ObjectFileParser::ObjectFileChunk::Corner* corners = chunk.corners.data();
+            for (uint32_t polygonCornerCount : chunk.polygonCornerCounts){
+                for (uint32_t idx = 0; idx < polygonCornerCount; ++idx){
+                    allTextured = allTextured && corners[idx].indices[1] != VertexWelder::NO_INDEX;
+                    allNormals = allNormals && corners[idx].indices[2] != VertexWelder::NO_INDEX;
+                }
+
+                for (uint32_t idx = 1; idx + 1 < polygonCornerCount; ++idx){
+                    rootBlock.push_back({ corners[0].indices, corners[idx].indices, corners[idx + 1].indices });
+                    if (rootBlock.size() == BIN_BLOCK_TRIANGLES) AppendBinBlock(binFile, rootBlock, rootBin);
+                }
+                corners += polygonCornerCount;
+            }
+        });
+        AppendBinBlock(binFile, rootBlock, rootBin);
+
+        if (rootBin.triangleCount == 0) throw runtime_error("No geometry found in " + objectFilePath);
+
+        const MappedFile positionData(positionFile.Flush());
+        const MappedFile textureData(textureFile.Flush());
+        const MappedFile normalData(normalFile.Flush());
+
+        const ObjectFileAttributes attributes {
+            positionData.GetView(), textureData.GetView(), normalData.GetView(),
+            textureData.GetSize() != 0 && allTextured,
+            normalData.GetSize() != 0 && allNormals
+        };
+
+        // Cells that can't be split, because all their triangles fall into one,
+        // are chunked as they are.
+        const size_t binTriangleLimit = max(BIN_TRIANGLE_LIMIT, trianglesPerChunk);
+        vector<TriangleBin> chunkedBins;
+        vector<TriangleBin> pendingBins;
+        pendingBins.push_back(std::move(rootBin));
+
+        while (!pendingBins.empty()){
+            TriangleBin bin = std::move(pendingBins.back());
+            pendingBins.pop_back();
+
+            if (bin.triangleCount > binTriangleLimit){
+                vector<TriangleBin> cellBins = SplitTriangleBin(binFile, bin, attributes, binTriangleLimit);
+                if (cellBins.size() > 1){
+                    move(cellBins.rbegin(), cellBins.rend(), back_inserter(pendingBins));
+                    continue;
+                }
+            }
+            chunkedBins.push_back(std::move(bin));
+        }
+
+        uint64_t chunkCount = 0;
+        for (const TriangleBin& bin : chunkedBins){
+            chunkCount += GetPartitionCount(bin.triangleCount, trianglesPerChunk);
+        }
+
+        ChunkFileWriter chunkFileWriter(chunkFilePath, source, chunkCount, attributes.hasTextureCoords, attributes.hasNormals);
+        for (const TriangleBin& bin : chunkedBins){
+            WriteBinChunks(binFile, bin, attributes, trianglesPerChunk, chunkFileWriter);
+        }
+        chunkFileWriter.Finish();
+    }
+
+    bool StreamedMesh::ChunkFileIsUpToDate(
+            const ObjectFileParser& objectFileParser,
+            const std::string& objectFilePath,
+            const std::string& chunkFilePath,
+            size_t trianglesPerChunk)
+    {
+        ChunkFileHeader header;
+        {
+            ifstream chunkFile(chunkFilePath, ios::binary);
+            if (!chunkFile.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        }
+
+        if (!IsChunkFileHeader(header) ||
+            header.trianglesPerChunk != trianglesPerChunk ||
+            header.yzAxesFixed != static_cast<uint32_t>(objectFileParser.GetDoApplyYZAxesFix())){
+            return false;
+        }
+
+        // The size rules most changes out before the whole file is hashed.
+        error_code fileError;
+        const uintmax_t objectFileSize = filesystem::file_size(objectFilePath, fileError);
+        if (fileError || header.sourceSize != objectFileSize) return false;
+
+        return header.sourceHash == GetChunkFileSource(objectFileParser, objectFilePath, trianglesPerChunk).objectFileHash;
+    }
+
+    StreamedMesh::StreamedMesh(const std::string& chunkFilePath, size_t memoryBudgetBytes) :
+        chunk_file_path_(chunkFilePath),
+        chunk_file_(chunkFilePath),
+        has_texture_coords_(false),
+        has_normals_(false),
+        resident_bytes_(0),
+        memory_budget_bytes_(memoryBudgetBytes),
+        frame_index_(0)
+    {
+        const std::string_view fileData = chunk_file_.GetView();
+
+        ChunkFileHeader header;
+        if (fileData.size() < sizeof(header)) throw runtime_error(chunkFilePath + " is not a chunk file");
+        memcpy(&header, fileData.data(), sizeof(header));
+
+        if (!IsChunkFileHeader(header)){
+            throw runtime_error(chunkFilePath + " is not a chunk file of this version");
+        }
+        if (header.chunkCount > (fileData.size() - sizeof(header)) / sizeof(ChunkTableEntry)){
+            throw runtime_error(chunkFilePath + " is truncated");
+        }
+
+        has_texture_coords_ = header.hasTextureCoords != 0;
+        has_normals_ = header.hasNormals != 0;
+        bounds_ = header.bounds;
+
+        chunks_.resize(header.chunkCount);
+        for (size_t chunkIndex = 0; chunkIndex < chunks_.size(); ++chunkIndex){
+            ChunkTableEntry entry;
+            memcpy(&entry, fileData.data() + sizeof(header) + chunkIndex * sizeof(entry), sizeof(entry));
+
+            const uint64_t dataSize = GetChunkDataSize(header, entry);
+            if (entry.offset > fileData.size() || dataSize > fileData.size() - entry.offset){
+                throw runtime_error(chunkFilePath + " is truncated");
+            }
+
+            MeshChunk& chunk = chunks_[chunkIndex];
+            chunk.bounds = entry.bounds;
+            chunk.vertexCount = entry.vertexCount;
+            chunk.triangleCount = entry.triangleCount;
+            chunk.fileOffset = entry.offset;
+            // What the chunk takes as a SceneData, polygon offsets included.
+            chunk.byteSize = sizeof(SceneData) + dataSize + (uint64_t{entry.triangleCount} + 1) * sizeof(uint32_t);
+            chunk.lastVisibleFrame = 0;
+        }
+    }
+
+    void StreamedMesh::SetMemoryBudget(size_t memoryBudgetBytes) {
+        memory_budget_bytes_ = memoryBudgetBytes;
+    }
+
+    size_t StreamedMesh::GetMemoryBudget() const {
+        return memory_budget_bytes_;
+    }
+
+    // A lowered budget is caught up with here, but only by evicting chunks that
+    // went out of view; visible ones stay until they do.
+    void StreamedMesh::UpdateResidency(const Frustum& frustum, const glm::vec3& viewPoint) {
+        ++frame_index_;
+        visible_chunks_.clear();
+
+        vector<pair<float, size_t>> visibleChunks;
+        for (size_t chunkIndex = 0; chunkIndex < chunks_.size(); ++chunkIndex){
+            MeshChunk& chunk = chunks_[chunkIndex];
+            if (!frustum.IntersectsBox(chunk.bounds)) continue;
+
+            chunk.lastVisibleFrame = frame_index_;
+            visibleChunks.emplace_back(chunk.bounds.GetDistance(viewPoint), chunkIndex);
+
+            if (chunk.sceneData){
+                resident_chunks_.splice(resident_chunks_.begin(), resident_chunks_, chunk.residentPosition);
+            }
+        }
+        // Nearest first, so the chunks closest to the viewer get the budget and
+        // are drawn before what they hide.
+        sort(visibleChunks.begin(), visibleChunks.end());
+
+        while (resident_bytes_ > memory_budget_bytes_ && EvictLeastRecentlyVisibleChunk()) { }
+
+        for (const auto& [distance, chunkIndex] : visibleChunks){
+            MeshChunk& chunk = chunks_[chunkIndex];
+
+            if (!chunk.sceneData){
+                while (resident_bytes_ + chunk.byteSize > memory_budget_bytes_ && EvictLeastRecentlyVisibleChunk()) { }
+                if (resident_bytes_ + chunk.byteSize > memory_budget_bytes_) continue;
+
+                LoadChunk(chunkIndex);
+            }
+            visible_chunks_.push_back(chunk.sceneData.get());
+        }
+    }
+
+    void StreamedMesh::LoadChunk(size_t chunkIndex) {
+        MeshChunk& chunk = chunks_[chunkIndex];
+        auto sceneData = make_unique<SceneData>();
+
+        const char* data = chunk_file_.GetData() + chunk.fileOffset;
+        data = ReadChunkArray(data, chunk.vertexCount, sceneData->vertices);
+        if (has_texture_coords_) data = ReadChunkArray(data, chunk.vertexCount, sceneData->vertex_textures);
+        if (has_normals_) data = ReadChunkArray(data, chunk.vertexCount, sceneData->vertex_normals);
+        ReadChunkArray(data, size_t{3} * chunk.triangleCount, sceneData->vertex_indices);
+
+        sceneData->polygon_offsets.resize(size_t{chunk.triangleCount} + 1);
+        for (size_t polygonIndex = 0; polygonIndex < sceneData->polygon_offsets.size(); ++polygonIndex){
+            sceneData->polygon_offsets[polygonIndex] = static_cast<uint32_t>(3 * polygonIndex);
+        }
+
+        // Indices past the chunk's own vertices would only come from a damaged file.
+        for (int vertexIndex : sceneData->vertex_indices){
+            if (static_cast<uint32_t>(vertexIndex) >= chunk.vertexCount){
+                throw runtime_error(chunk_file_path_ + " is damaged, a triangle refers to a missing vertex");
+            }
+        }
+
+        chunk.sceneData = std::move(sceneData);
+        resident_chunks_.push_front(chunkIndex);
+        chunk.residentPosition = resident_chunks_.begin();
+        resident_bytes_ += chunk.byteSize;
+    }
+
+    bool StreamedMesh::EvictLeastRecentlyVisibleChunk() {
+        if (resident_chunks_.empty()) return false;
+
+        MeshChunk& chunk = chunks_[resident_chunks_.back()];
+        if (chunk.lastVisibleFrame == frame_index_) return false;
+
+        chunk.sceneData.reset();
+        resident_chunks_.pop_back();
+        resident_bytes_ -= chunk.byteSize;
+        return true;
+    }
+
+    const std::vector<const SceneData*>& StreamedMesh::GetVisibleChunks() const {
+        return visible_chunks_;
+    }
+
+    bool StreamedMesh::HasTextureCoords() const {
+        return has_texture_coords_;
+    }
+
+    bool StreamedMesh::HasNormals() const {
+        return has_normals_;
+    }
+
+    size_t StreamedMesh::GetChunkCount() const {
+        return chunks_.size();
+    }
+
+    size_t StreamedMesh::GetResidentChunkCount() const {
+        return resident_chunks_.size();
+    }
+
+    size_t StreamedMesh::GetResidentBytes() const {
+        return resident_bytes_;
+    }
+
+    const BoundingBox& StreamedMesh::GetBounds() const {
+        return bounds_;
+    }
+
+} // namespace pv
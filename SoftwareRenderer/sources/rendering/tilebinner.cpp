@@ -0,0 +1,63 @@
+#include "headers/rendering/tilebinner.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace pv {
+
+    TileBinner::TileBinner() :
+        width_(0),
+        height_(0),
+        tiles_x_(0),
+        tiles_y_(0) { }
+
+    void TileBinner::Reset(size_t width, size_t height) {
+        width_ = width;
+        height_ = height;
+        tiles_x_ = (width + TILE_SIZE - 1) / TILE_SIZE;
+        tiles_y_ = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+        tile_bins_.resize(tiles_x_ * tiles_y_);
+        for (auto& tileBin : tile_bins_){
+            tileBin.clear();
+        }
+    }
+
+    void TileBinner::BinTriangle(uint32_t triangleIndex, const ScreenRect &boundingRect)
+    {
+        if (width_ == 0 || height_ == 0) return;
+
+        if (boundingRect.maxX < 0 || boundingRect.maxY < 0 ||
+            boundingRect.minX >= static_cast<int>(width_) || boundingRect.minY >= static_cast<int>(height_)) return;
+
+        const size_t firstTileX = static_cast<size_t>(max(boundingRect.minX, 0)) / TILE_SIZE;
+        const size_t firstTileY = static_cast<size_t>(max(boundingRect.minY, 0)) / TILE_SIZE;
+        const size_t lastTileX = min(static_cast<size_t>(boundingRect.maxX) / TILE_SIZE, tiles_x_ - 1);
+        const size_t lastTileY = min(static_cast<size_t>(boundingRect.maxY) / TILE_SIZE, tiles_y_ - 1);
+
+        for (size_t tileY = firstTileY; tileY <= lastTileY; ++tileY){
+            for (size_t tileX = firstTileX; tileX <= lastTileX; ++tileX){
+                tile_bins_[tileX + tileY * tiles_x_].push_back(triangleIndex);
+            }
+        }
+    }
+
+    size_t TileBinner::GetTileCount() const {
+        return tile_bins_.size();
+    }
+
+    ScreenRect TileBinner::GetTileRect(size_t tileIndex) const {
+        const int tileX = static_cast<int>(tileIndex % tiles_x_);
+        const int tileY = static_cast<int>(tileIndex / tiles_x_);
+
+        return { tileX * TILE_SIZE,
+                 tileY * TILE_SIZE,
+                 min((tileX + 1) * TILE_SIZE, static_cast<int>(width_)) - 1,
+                 min((tileY + 1) * TILE_SIZE, static_cast<int>(height_)) - 1 };
+    }
+
+    const std::vector<uint32_t>& TileBinner::GetTileTriangles(size_t tileIndex) const {
+        return tile_bins_[tileIndex];
+    }
+
+} // namespace pv
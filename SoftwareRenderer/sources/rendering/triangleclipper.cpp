@@ -0,0 +1,100 @@
+#include "headers/rendering/triangleclipper.h"
+
+using namespace std;
+
+namespace pv {
+
+    TriangleClipper::TriangleClipper(float guardBandScale) :
+        guard_band_scale_(guardBandScale) { }
+
+    bool TriangleClipper::ClipTriangle(
+            const ClipSpacePoint &firstPoint,
+            const ClipSpacePoint &secondPoint,
+            const ClipSpacePoint &thirdPoint,
+            ClippedPolygon &clippedPolygon) const
+    {
+        // Rejection uses the real frustum, clipping only the guard band.
+        const unsigned firstOutcode = GetOutcode(firstPoint, 1.0F);
+        const unsigned secondOutcode = GetOutcode(secondPoint, 1.0F);
+        const unsigned thirdOutcode = GetOutcode(thirdPoint, 1.0F);
+
+        if (firstOutcode & secondOutcode & thirdOutcode){
+            clippedPolygon.vertexCount = 0;
+            return false;
+        }
+
+        clippedPolygon.vertices[0] = { firstPoint,  {1.0F, 0.0F, 0.0F} };
+        clippedPolygon.vertices[1] = { secondPoint, {0.0F, 1.0F, 0.0F} };
+        clippedPolygon.vertices[2] = { thirdPoint,  {0.0F, 0.0F, 1.0F} };
+        clippedPolygon.vertexCount = 3;
+
+        const unsigned crossedPlanes = GetOutcode(firstPoint, guard_band_scale_) |
+                                       GetOutcode(secondPoint, guard_band_scale_) |
+                                       GetOutcode(thirdPoint, guard_band_scale_);
+
+        for (int clipPlane = 0; clipPlane < CLIP_PLANE_COUNT; ++clipPlane){
+            if (crossedPlanes & (1U << clipPlane)){
+                ClipAgainstPlane(clipPlane, clippedPolygon);
+
+                if (clippedPolygon.vertexCount < 3){
+                    clippedPolygon.vertexCount = 0;
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    float TriangleClipper::GetPlaneDistance(int clipPlane, const ClipSpacePoint &point, float planeScale) const {
+        switch (clipPlane){
+            case NEAR_PLANE:   return point.z;
+            case FAR_PLANE:    return point.w - point.z;
+            case LEFT_PLANE:   return planeScale * point.w + point.x;
+            case RIGHT_PLANE:  return planeScale * point.w - point.x;
+            case BOTTOM_PLANE: return planeScale * point.w + point.y;
+            case TOP_PLANE:    return planeScale * point.w - point.y;
+        }
+        return 0.0F;
+    }
+
+    unsigned TriangleClipper::GetOutcode(const ClipSpacePoint &point, float planeScale) const {
+        unsigned outcode = 0;
+        for (int clipPlane = 0; clipPlane < CLIP_PLANE_COUNT; ++clipPlane){
+            if (GetPlaneDistance(clipPlane, point, planeScale) < 0.0F){
+                outcode |= 1U << clipPlane;
+            }
+        }
+        return outcode;
+    }
+
+    void TriangleClipper::ClipAgainstPlane(int clipPlane, ClippedPolygon &clippedPolygon) const {
+        const float planeScale = (clipPlane == NEAR_PLANE || clipPlane == FAR_PLANE) ? 1.0F : guard_band_scale_;
+        const ClippedPolygon inputPolygon = clippedPolygon;
+
+        size_t outputCount = 0;
+        for (size_t idx = 0; idx < inputPolygon.vertexCount; ++idx){
+            const ClipVertex& current = inputPolygon.vertices[idx];
+            const ClipVertex& next = inputPolygon.vertices[(idx + 1) % inputPolygon.vertexCount];
+
+            const float currentDistance = GetPlaneDistance(clipPlane, current.position, planeScale);
+            const float nextDistance = GetPlaneDistance(clipPlane, next.position, planeScale);
+
+            if (currentDistance >= 0.0F){
+                clippedPolygon.vertices[outputCount++] = current;
+            }
+
+            if ((currentDistance >= 0.0F) != (nextDistance >= 0.0F)){
+                const float t = currentDistance / (currentDistance - nextDistance);
+
+                clippedPolygon.vertices[outputCount++] = {
+                    current.position + (next.position - current.position) * t,
+                    current.sourceWeights + (next.sourceWeights - current.sourceWeights) * t
+                };
+            }
+        }
+
+        clippedPolygon.vertexCount = outputCount;
+    }
+
+} // namespace pv
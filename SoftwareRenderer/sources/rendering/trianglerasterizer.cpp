@@ -0,0 +1,109 @@
+#include "headers/rendering/trianglerasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace std;
+
+namespace pv {
+
+    inline int64_t FloorDivide(int64_t value, int64_t divisor) {
+        int64_t quotient = value / divisor;
+        return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+    }
+
+    inline int64_t CeilDivide(int64_t value, int64_t divisor) {
+        return -FloorDivide(-value, divisor);
+    }
+
+    TriangleRasterizer::TriangleRasterizer() :
+        edges_{},
+        span_setup_{},
+        bounding_rect_{0, 0, -1, -1},
+        is_empty_(true) { }
+
+    TriangleRasterizer::TriangleRasterizer(
+            const ViewportPoint &firstPoint,
+            const ViewportPoint &secondPoint,
+            const ViewportPoint &thirdPoint,
+            const ScreenRect &scissorRect) :
+        edges_{},
+        span_setup_{},
+        bounding_rect_{0, 0, -1, -1},
+        is_empty_(true)
+    {
+        int64_t x0 = llround(firstPoint.x * SUBPIXEL_STEPS),  y0 = llround(firstPoint.y * SUBPIXEL_STEPS);
+        int64_t x1 = llround(secondPoint.x * SUBPIXEL_STEPS), y1 = llround(secondPoint.y * SUBPIXEL_STEPS);
+        int64_t x2 = llround(thirdPoint.x * SUBPIXEL_STEPS),  y2 = llround(thirdPoint.y * SUBPIXEL_STEPS);
+
+        const int64_t doubleSignedArea = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+        if (doubleSignedArea == 0) return;
+
+        const bool verticesSwapped = doubleSignedArea < 0;
+        if (verticesSwapped){
+            swap(x1, x2);
+            swap(y1, y2);
+        }
+
+        bounding_rect_.minX = max<int64_t>(scissorRect.minX, CeilDivide(min({x0, x1, x2}), SUBPIXEL_STEPS));
+        bounding_rect_.minY = max<int64_t>(scissorRect.minY, CeilDivide(min({y0, y1, y2}), SUBPIXEL_STEPS));
+        bounding_rect_.maxX = min<int64_t>(scissorRect.maxX, FloorDivide(max({x0, x1, x2}), SUBPIXEL_STEPS));
+        bounding_rect_.maxY = min<int64_t>(scissorRect.maxY, FloorDivide(max({y0, y1, y2}), SUBPIXEL_STEPS));
+
+        if (bounding_rect_.minX > bounding_rect_.maxX ||
+            bounding_rect_.minY > bounding_rect_.maxY) return;
+
+        int64_t fillRuleBias[3];
+        edges_[0] = GetEdgeFunction(x1, y1, x2, y2, fillRuleBias[0]);
+        edges_[1] = GetEdgeFunction(x2, y2, x0, y0, fillRuleBias[1]);
+        edges_[2] = GetEdgeFunction(x0, y0, x1, y1, fillRuleBias[2]);
+
+        // The edge opposite a vertex carries its barycentric weight; after the swap
+        // the second and third vertex trade edges.
+        span_setup_.uEdge = verticesSwapped ? 2 : 1;
+        span_setup_.vEdge = verticesSwapped ? 1 : 2;
+        span_setup_.uBias = static_cast<double>(fillRuleBias[span_setup_.uEdge]);
+        span_setup_.vBias = static_cast<double>(fillRuleBias[span_setup_.vEdge]);
+        span_setup_.inverseDoubleArea = 1.0 / static_cast<double>(verticesSwapped ? -doubleSignedArea : doubleSignedArea);
+        for (int edge = 0; edge < 3; ++edge){
+            span_setup_.xStep[edge] = static_cast<double>(edges_[edge].xStep);
+        }
+
+        is_empty_ = false;
+    }
+
+    TriangleRasterizer::TriangleRasterizer(const TriangleRasterizer &triangleSetup, const ScreenRect &scissorRect) :
+        TriangleRasterizer(triangleSetup)
+    {
+        bounding_rect_.minX = max(bounding_rect_.minX, scissorRect.minX);
+        bounding_rect_.minY = max(bounding_rect_.minY, scissorRect.minY);
+        bounding_rect_.maxX = min(bounding_rect_.maxX, scissorRect.maxX);
+        bounding_rect_.maxY = min(bounding_rect_.maxY, scissorRect.maxY);
+
+        if (bounding_rect_.minX > bounding_rect_.maxX ||
+            bounding_rect_.minY > bounding_rect_.maxY) is_empty_ = true;
+    }
+
+    bool TriangleRasterizer::IsEmpty() const {
+        return is_empty_;
+    }
+
+    const ScreenRect& TriangleRasterizer::GetBoundingRect() const {
+        return bounding_rect_;
+    }
+
+    TriangleRasterizer::EdgeFunction
+    TriangleRasterizer::GetEdgeFunction(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t& fillRuleBias) const {
+        const int64_t deltaX = bx - ax;
+        const int64_t deltaY = by - ay;
+
+        const bool isTopEdge = (deltaY == 0 && deltaX > 0);
+        const bool isLeftEdge = (deltaY < 0);
+        fillRuleBias = (isTopEdge || isLeftEdge) ? 0 : -1;
+
+        return { -deltaY * SUBPIXEL_STEPS,
+                  deltaX * SUBPIXEL_STEPS,
+                  deltaY * ax - deltaX * ay + fillRuleBias };
+    }
+
+} // namespace pv
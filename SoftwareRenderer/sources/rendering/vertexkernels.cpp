@@ -0,0 +1,362 @@
+#include "headers/rendering/vertexkernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define PV_VERTEX_KERNELS_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #define PV_TARGET_AVX2
+    #else
+        #define PV_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+using namespace std;
+
+namespace pv {
+
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float) && sizeof(glm::vec4) == 4 * sizeof(float),
+                  "Vertex kernels access glm vectors as packed floats");
+
+    constexpr size_t VISIBLE_MASK_BITS = 64;
+    constexpr float W_EPSILON = 0.0001F;
+
+    //------ scalar
+
+    // glm's mat4 * vec4 sums the column products pairwise; with w = 1 the
+    // last product is the translation itself.
+    inline float ScalarTransformRow(const glm::mat4& matrix, int row, float x, float y, float z) {
+        return (matrix[0][row] * x + matrix[1][row] * y) + (matrix[2][row] * z + matrix[3][row]);
+    }
+
+    inline bool ScalarTransformVertex(const VertexTransformSetup& setup, const glm::vec3& position,
+                                      size_t vertexIndex, const VertexTransformOutput& output)
+    {
+        const float cx = ScalarTransformRow(setup.clipTransform, 0, position.x, position.y, position.z);
+        const float cy = ScalarTransformRow(setup.clipTransform, 1, position.x, position.y, position.z);
+        const float cz = ScalarTransformRow(setup.clipTransform, 2, position.x, position.y, position.z);
+        const float cw = ScalarTransformRow(setup.clipTransform, 3, position.x, position.y, position.z);
+
+        output.clipPositions[vertexIndex] = { cx, cy, cz, cw };
+        output.cameraPositions[vertexIndex] = { ScalarTransformRow(setup.cameraTransform, 0, position.x, position.y, position.z),
+                                                ScalarTransformRow(setup.cameraTransform, 1, position.x, position.y, position.z),
+                                                ScalarTransformRow(setup.cameraTransform, 2, position.x, position.y, position.z) };
+
+        const float inverseW = 1.0F / cw;
+        const float dx = cx * inverseW, dy = cy * inverseW, dz = cz * inverseW, dw = cw * inverseW;
+
+        // As the viewport matrix does, with its zero terms left out; adding
+        // zero to the depth keeps turning -0 into +0.
+        const float vx = setup.viewportHalfWidth * dx + setup.viewportHalfWidth * dw;
+        const float vy = setup.viewportHalfHeight * dy + setup.viewportHalfHeight * dw;
+
+        output.viewportX[vertexIndex] = vx;
+        output.viewportY[vertexIndex] = vy;
+        output.viewportZ[vertexIndex] = dz + 0.0F;
+        output.inverseW[vertexIndex] = inverseW;
+
+        return abs(cw) > W_EPSILON &&
+               -1.0F <= dx && dx <= 1.0F &&
+               -1.0F <= dy && dy <= 1.0F &&
+                0.0F <= dz && dz <= 1.0F &&
+               vx < setup.viewportWidth && vy < setup.viewportHeight;
+    }
+
+    void ScalarTransformVertices(const VertexTransformSetup& setup, const glm::vec3* positions, size_t count,
+                                 const VertexTransformOutput& output)
+    {
+        for (size_t blockBegin = 0; blockBegin < count; blockBegin += VISIBLE_MASK_BITS){
+            const size_t blockEnd = min(blockBegin + VISIBLE_MASK_BITS, count);
+            uint64_t visibleMask = 0;
+
+            for (size_t vertexIndex = blockBegin; vertexIndex < blockEnd; ++vertexIndex){
+                if (ScalarTransformVertex(setup, positions[vertexIndex], vertexIndex, output)){
+                    visibleMask |= uint64_t{1} << (vertexIndex - blockBegin);
+                }
+            }
+
+            output.visibleMasks[blockBegin / VISIBLE_MASK_BITS] = visibleMask;
+        }
+    }
+
+#ifdef PV_VERTEX_KERNELS_X86
+
+    //------ SSE2
+
+    using Sse2Matrix = __m128[4][4];
+
+    inline void Sse2BroadcastMatrix(const glm::mat4& matrix, Sse2Matrix& broadcast) {
+        for (int column = 0; column < 4; ++column){
+            for (int row = 0; row < 4; ++row){
+                broadcast[column][row] = _mm_set1_ps(matrix[column][row]);
+            }
+        }
+    }
+
+    // Four packed vec3 as x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 into one register per component.
+    inline void Sse2LoadVec3s(const glm::vec3* source, __m128& x, __m128& y, __m128& z) {
+        const float* floats = reinterpret_cast<const float*>(source);
+        const __m128 first = _mm_loadu_ps(floats);
+        const __m128 second = _mm_loadu_ps(floats + 4);
+        const __m128 third = _mm_loadu_ps(floats + 8);
+
+        x = _mm_shuffle_ps(first, _mm_shuffle_ps(second, third, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        y = _mm_shuffle_ps(_mm_shuffle_ps(first, second, _MM_SHUFFLE(0, 0, 1, 1)),
+                           _mm_shuffle_ps(second, third, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        z = _mm_shuffle_ps(_mm_shuffle_ps(first, second, _MM_SHUFFLE(1, 1, 2, 2)), third, _MM_SHUFFLE(3, 0, 2, 0));
+    }
+
+    inline void Sse2StoreVec4s(glm::vec4* destination, __m128 x, __m128 y, __m128 z, __m128 w) {
+        float* floats = reinterpret_cast<float*>(destination);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(floats, x);
+        _mm_storeu_ps(floats + 4, y);
+        _mm_storeu_ps(floats + 8, z);
+        _mm_storeu_ps(floats + 12, w);
+    }
+
+    // Every full store spills a zero into the next vec3, which the next store
+    // overwrites; the last one is stored in two parts not to run past the end.
+    inline void Sse2StoreVec3s(glm::vec3* destination, __m128 x, __m128 y, __m128 z) {
+        float* floats = reinterpret_cast<float*>(destination);
+        __m128 w = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(floats, x);
+        _mm_storeu_ps(floats + 3, y);
+        _mm_storeu_ps(floats + 6, z);
+        _mm_storel_pi(reinterpret_cast<__m64*>(floats + 9), w);
+        _mm_store_ss(floats + 11, _mm_movehl_ps(w, w));
+    }
+
+    inline __m128 Sse2TransformRow(const Sse2Matrix& matrix, int row, __m128 x, __m128 y, __m128 z) {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[0][row], x), _mm_mul_ps(matrix[1][row], y)),
+                          _mm_add_ps(_mm_mul_ps(matrix[2][row], z), matrix[3][row]));
+    }
+
+    inline uint64_t Sse2TransformVertexBatch(const VertexTransformSetup& setup,
+                                             const Sse2Matrix& clipTransform, const Sse2Matrix& cameraTransform,
+                                             const glm::vec3* positions, size_t vertexIndex,
+                                             const VertexTransformOutput& output)
+    {
+        __m128 px, py, pz;
+        Sse2LoadVec3s(positions + vertexIndex, px, py, pz);
+
+        const __m128 cx = Sse2TransformRow(clipTransform, 0, px, py, pz);
+        const __m128 cy = Sse2TransformRow(clipTransform, 1, px, py, pz);
+        const __m128 cz = Sse2TransformRow(clipTransform, 2, px, py, pz);
+        const __m128 cw = Sse2TransformRow(clipTransform, 3, px, py, pz);
+
+        Sse2StoreVec4s(output.clipPositions + vertexIndex, cx, cy, cz, cw);
+        Sse2StoreVec3s(output.cameraPositions + vertexIndex,
+                       Sse2TransformRow(cameraTransform, 0, px, py, pz),
+                       Sse2TransformRow(cameraTransform, 1, px, py, pz),
+                       Sse2TransformRow(cameraTransform, 2, px, py, pz));
+
+        const __m128 one = _mm_set1_ps(1.0F);
+        const __m128 inverseW = _mm_div_ps(one, cw);
+        const __m128 dx = _mm_mul_ps(cx, inverseW);
+        const __m128 dy = _mm_mul_ps(cy, inverseW);
+        const __m128 dz = _mm_mul_ps(cz, inverseW);
+        const __m128 dw = _mm_mul_ps(cw, inverseW);
+
+        const __m128 halfWidth = _mm_set1_ps(setup.viewportHalfWidth);
+        const __m128 halfHeight = _mm_set1_ps(setup.viewportHalfHeight);
+        const __m128 vx = _mm_add_ps(_mm_mul_ps(halfWidth, dx), _mm_mul_ps(halfWidth, dw));
+        const __m128 vy = _mm_add_ps(_mm_mul_ps(halfHeight, dy), _mm_mul_ps(halfHeight, dw));
+
+        _mm_storeu_ps(output.viewportX + vertexIndex, vx);
+        _mm_storeu_ps(output.viewportY + vertexIndex, vy);
+        _mm_storeu_ps(output.viewportZ + vertexIndex, _mm_add_ps(dz, _mm_setzero_ps()));
+        _mm_storeu_ps(output.inverseW + vertexIndex, inverseW);
+
+        const __m128 minusOne = _mm_set1_ps(-1.0F);
+        const __m128 absoluteW = _mm_andnot_ps(_mm_set1_ps(-0.0F), cw);
+
+        __m128 visible = _mm_cmpgt_ps(absoluteW, _mm_set1_ps(W_EPSILON));
+        visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmple_ps(minusOne, dx), _mm_cmple_ps(dx, one)));
+        visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmple_ps(minusOne, dy), _mm_cmple_ps(dy, one)));
+        visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmple_ps(_mm_setzero_ps(), dz), _mm_cmple_ps(dz, one)));
+        visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmplt_ps(vx, _mm_set1_ps(setup.viewportWidth)),
+                                                 _mm_cmplt_ps(vy, _mm_set1_ps(setup.viewportHeight))));
+
+        return static_cast<uint64_t>(_mm_movemask_ps(visible));
+    }
+
+    void Sse2TransformVertices(const VertexTransformSetup& setup, const glm::vec3* positions, size_t count,
+                               const VertexTransformOutput& output)
+    {
+        Sse2Matrix clipTransform, cameraTransform;
+        Sse2BroadcastMatrix(setup.clipTransform, clipTransform);
+        Sse2BroadcastMatrix(setup.cameraTransform, cameraTransform);
+
+        for (size_t blockBegin = 0; blockBegin < count; blockBegin += VISIBLE_MASK_BITS){
+            const size_t blockEnd = min(blockBegin + VISIBLE_MASK_BITS, count);
+            uint64_t visibleMask = 0;
+
+            size_t vertexIndex = blockBegin;
+            for (; vertexIndex + 4 <= blockEnd; vertexIndex += 4){
+                visibleMask |= Sse2TransformVertexBatch(setup, clipTransform, cameraTransform, positions, vertexIndex, output)
+                               << (vertexIndex - blockBegin);
+            }
+            for (; vertexIndex < blockEnd; ++vertexIndex){
+                if (ScalarTransformVertex(setup, positions[vertexIndex], vertexIndex, output)){
+                    visibleMask |= uint64_t{1} << (vertexIndex - blockBegin);
+                }
+            }
+
+            output.visibleMasks[blockBegin / VISIBLE_MASK_BITS] = visibleMask;
+        }
+    }
+
+    //------ AVX2
+
+    using Avx2Matrix = __m256[4][4];
+
+    PV_TARGET_AVX2
+    inline void Avx2BroadcastMatrix(const glm::mat4& matrix, Avx2Matrix& broadcast) {
+        for (int column = 0; column < 4; ++column){
+            for (int row = 0; row < 4; ++row){
+                broadcast[column][row] = _mm256_set1_ps(matrix[column][row]);
+            }
+        }
+    }
+
+    // Vertices 0-3 go to the low 128-bit lane and 4-7 to the high one, so the
+    // SSE2 shuffles, which AVX applies per lane, sort out both halves at once.
+    PV_TARGET_AVX2
+    inline void Avx2LoadVec3s(const glm::vec3* source, __m256& x, __m256& y, __m256& z) {
+        const float* floats = reinterpret_cast<const float*>(source);
+        const __m256 first = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(floats)), _mm_loadu_ps(floats + 12), 1);
+        const __m256 second = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(floats + 4)), _mm_loadu_ps(floats + 16), 1);
+        const __m256 third = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(floats + 8)), _mm_loadu_ps(floats + 20), 1);
+
+        x = _mm256_shuffle_ps(first, _mm256_shuffle_ps(second, third, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        y = _mm256_shuffle_ps(_mm256_shuffle_ps(first, second, _MM_SHUFFLE(0, 0, 1, 1)),
+                              _mm256_shuffle_ps(second, third, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        z = _mm256_shuffle_ps(_mm256_shuffle_ps(first, second, _MM_SHUFFLE(1, 1, 2, 2)), third, _MM_SHUFFLE(3, 0, 2, 0));
+    }
+
+    PV_TARGET_AVX2
+    inline void Avx2StoreVec4s(glm::vec4* destination, __m256 x, __m256 y, __m256 z, __m256 w) {
+        Sse2StoreVec4s(destination, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y),
+                       _mm256_castps256_ps128(z), _mm256_castps256_ps128(w));
+        Sse2StoreVec4s(destination + 4, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1),
+                       _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1));
+    }
+
+    PV_TARGET_AVX2
+    inline void Avx2StoreVec3s(glm::vec3* destination, __m256 x, __m256 y, __m256 z) {
+        Sse2StoreVec3s(destination, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+        Sse2StoreVec3s(destination + 4, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+    }
+
+    PV_TARGET_AVX2
+    inline __m256 Avx2TransformRow(const Avx2Matrix& matrix, int row, __m256 x, __m256 y, __m256 z) {
+        return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(matrix[0][row], x), _mm256_mul_ps(matrix[1][row], y)),
+                             _mm256_add_ps(_mm256_mul_ps(matrix[2][row], z), matrix[3][row]));
+    }
+
+    PV_TARGET_AVX2
+    inline uint64_t Avx2TransformVertexBatch(const VertexTransformSetup& setup,
+                                             const Avx2Matrix& clipTransform, const Avx2Matrix& cameraTransform,
+                                             const glm::vec3* positions, size_t vertexIndex,
+                                             const VertexTransformOutput& output)
+    {
+        __m256 px, py, pz;
+        Avx2LoadVec3s(positions + vertexIndex, px, py, pz);
+
+        const __m256 cx = Avx2TransformRow(clipTransform, 0, px, py, pz);
+        const __m256 cy = Avx2TransformRow(clipTransform, 1, px, py, pz);
+        const __m256 cz = Avx2TransformRow(clipTransform, 2, px, py, pz);
+        const __m256 cw = Avx2TransformRow(clipTransform, 3, px, py, pz);
+
+        Avx2StoreVec4s(output.clipPositions + vertexIndex, cx, cy, cz, cw);
+        Avx2StoreVec3s(output.cameraPositions + vertexIndex,
+                       Avx2TransformRow(cameraTransform, 0, px, py, pz),
+                       Avx2TransformRow(cameraTransform, 1, px, py, pz),
+                       Avx2TransformRow(cameraTransform, 2, px, py, pz));
+
+        const __m256 one = _mm256_set1_ps(1.0F);
+        const __m256 inverseW = _mm256_div_ps(one, cw);
+        const __m256 dx = _mm256_mul_ps(cx, inverseW);
+        const __m256 dy = _mm256_mul_ps(cy, inverseW);
+        const __m256 dz = _mm256_mul_ps(cz, inverseW);
+        const __m256 dw = _mm256_mul_ps(cw, inverseW);
+
+        const __m256 halfWidth = _mm256_set1_ps(setup.viewportHalfWidth);
+        const __m256 halfHeight = _mm256_set1_ps(setup.viewportHalfHeight);
+        const __m256 vx = _mm256_add_ps(_mm256_mul_ps(halfWidth, dx), _mm256_mul_ps(halfWidth, dw));
+        const __m256 vy = _mm256_add_ps(_mm256_mul_ps(halfHeight, dy), _mm256_mul_ps(halfHeight, dw));
+
+        _mm256_storeu_ps(output.viewportX + vertexIndex, vx);
+        _mm256_storeu_ps(output.viewportY + vertexIndex, vy);
+        _mm256_storeu_ps(output.viewportZ + vertexIndex, _mm256_add_ps(dz, _mm256_setzero_ps()));
+        _mm256_storeu_ps(output.inverseW + vertexIndex, inverseW);
+
+        const __m256 minusOne = _mm256_set1_ps(-1.0F);
+        const __m256 absoluteW = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), cw);
+
+        __m256 visible = _mm256_cmp_ps(absoluteW, _mm256_set1_ps(W_EPSILON), _CMP_GT_OQ);
+        visible = _mm256_and_ps(visible, _mm256_and_ps(_mm256_cmp_ps(minusOne, dx, _CMP_LE_OQ), _mm256_cmp_ps(dx, one, _CMP_LE_OQ)));
+        visible = _mm256_and_ps(visible, _mm256_and_ps(_mm256_cmp_ps(minusOne, dy, _CMP_LE_OQ), _mm256_cmp_ps(dy, one, _CMP_LE_OQ)));
+        visible = _mm256_and_ps(visible, _mm256_and_ps(_mm256_cmp_ps(_mm256_setzero_ps(), dz, _CMP_LE_OQ), _mm256_cmp_ps(dz, one, _CMP_LE_OQ)));
+        visible = _mm256_and_ps(visible, _mm256_and_ps(_mm256_cmp_ps(vx, _mm256_set1_ps(setup.viewportWidth), _CMP_LT_OQ),
+                                                       _mm256_cmp_ps(vy, _mm256_set1_ps(setup.viewportHeight), _CMP_LT_OQ)));
+
+        return static_cast<uint64_t>(_mm256_movemask_ps(visible));
+    }
+
+    PV_TARGET_AVX2
+    void Avx2TransformVertices(const VertexTransformSetup& setup, const glm::vec3* positions, size_t count,
+                               const VertexTransformOutput& output)
+    {
+        Avx2Matrix clipTransform, cameraTransform;
+        Avx2BroadcastMatrix(setup.clipTransform, clipTransform);
+        Avx2BroadcastMatrix(setup.cameraTransform, cameraTransform);
+
+        for (size_t blockBegin = 0; blockBegin < count; blockBegin += VISIBLE_MASK_BITS){
+            const size_t blockEnd = min(blockBegin + VISIBLE_MASK_BITS, count);
+            uint64_t visibleMask = 0;
+
+            size_t vertexIndex = blockBegin;
+            for (; vertexIndex + 8 <= blockEnd; vertexIndex += 8){
+                visibleMask |= Avx2TransformVertexBatch(setup, clipTransform, cameraTransform, positions, vertexIndex, output)
+                               << (vertexIndex - blockBegin);
+            }
+            for (; vertexIndex < blockEnd; ++vertexIndex){
+                if (ScalarTransformVertex(setup, positions[vertexIndex], vertexIndex, output)){
+                    visibleMask |= uint64_t{1} << (vertexIndex - blockBegin);
+                }
+            }
+
+            output.visibleMasks[blockBegin / VISIBLE_MASK_BITS] = visibleMask;
+        }
+    }
+
+#endif // PV_VERTEX_KERNELS_X86
+
+    const VertexKernels& GetVertexKernels(SIMD_LEVEL simdLevel) {
+        static const VertexKernels scalarKernels { ScalarTransformVertices };
+
+#ifdef PV_VERTEX_KERNELS_X86
+        static const VertexKernels sse2Kernels { Sse2TransformVertices };
+        static const VertexKernels avx2Kernels { Avx2TransformVertices };
+
+        switch (simdLevel) {
+            case SIMD_LEVEL::AVX2: return avx2Kernels;
+            case SIMD_LEVEL::SSE2: return sse2Kernels;
+            case SIMD_LEVEL::SCALAR: break;
+        }
+#else
+        (void)simdLevel;
+#endif
+        return scalarKernels;
+    }
+
+    const VertexKernels& GetVertexKernels() {
+        static const VertexKernels& supportedKernels = GetVertexKernels(GetSupportedSimdLevel());
+        return supportedKernels;
+    }
+
+} // namespace pv
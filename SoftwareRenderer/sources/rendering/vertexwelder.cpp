@@ -0,0 +1,118 @@
+#include "headers/rendering/vertexwelder.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace pv {
+
+    void VertexWelder::Reserve(size_t vertexCount) {
+        // Smooth meshes weld to about one vertex per position, so the position
+        // count of a file is a good estimate without reserving per corner.
+        welded_keys_.reserve(vertexCount);
+        vertex_index_by_position_.resize(max(vertex_index_by_position_.size(), vertexCount), NO_INDEX);
+
+        size_t slotCount = MIN_SLOT_COUNT;
+        while (slotCount < vertexCount * 2) slotCount *= 2;
+        if (slotCount > vertex_index_slots_.size()) Rehash(slotCount);
+    }
+
+    int VertexWelder::GetVertexIndex(int positionIndex, int textureIndex, int normalIndex) {
+        const WeldKey key { positionIndex, textureIndex, normalIndex };
+
+        if (positionIndex < 0 || static_cast<size_t>(positionIndex) >= vertex_index_by_position_.size()){
+            return FindOrAddVertex(key);
+        }
+
+        int& positionVertexIndex = vertex_index_by_position_[positionIndex];
+        if (positionVertexIndex != NO_INDEX && welded_keys_[positionVertexIndex] == key){
+            return positionVertexIndex;
+        }
+
+        const int vertexIndex = FindOrAddVertex(key);
+        if (positionVertexIndex == NO_INDEX) positionVertexIndex = vertexIndex;
+        return vertexIndex;
+    }
+
+    int VertexWelder::FindOrAddVertex(const WeldKey& key) {
+        if ((welded_keys_.size() + 1) * 2 > vertex_index_slots_.size()){
+            Rehash(max(MIN_SLOT_COUNT, vertex_index_slots_.size() * 2));
+        }
+
+        const size_t slotMask = vertex_index_slots_.size() - 1;
+        for (size_t slot = WeldKeyHash{}(key) & slotMask; ; slot = (slot + 1) & slotMask){
+            int& vertexIndex = vertex_index_slots_[slot];
+
+            if (vertexIndex == NO_INDEX){
+                if (welded_keys_.size() == static_cast<size_t>(numeric_limits<int>::max())){
+                    throw runtime_error("Too many vertices to weld");
+                }
+                vertexIndex = static_cast<int>(welded_keys_.size());
+                welded_keys_.push_back(key);
+                return vertexIndex;
+            }
+            if (welded_keys_[vertexIndex] == key) return vertexIndex;
+        }
+    }
+
+    void VertexWelder::Rehash(size_t slotCount) {
+        vertex_index_slots_.assign(slotCount, NO_INDEX);
+
+        const size_t slotMask = slotCount - 1;
+        for (size_t vertexIndex = 0; vertexIndex < welded_keys_.size(); ++vertexIndex){
+            size_t slot = WeldKeyHash{}(welded_keys_[vertexIndex]) & slotMask;
+            while (vertex_index_slots_[slot] != NO_INDEX) slot = (slot + 1) & slotMask;
+            vertex_index_slots_[slot] = static_cast<int>(vertexIndex);
+        }
+    }
+
+    size_t VertexWelder::GetVertexCount() const {
+        return welded_keys_.size();
+    }
+
+    std::array<int, 3> VertexWelder::GetAttributeIndices(size_t vertexIndex) const {
+        const WeldKey& key = welded_keys_[vertexIndex];
+        return { key.positionIndex, key.textureIndex, key.normalIndex };
+    }
+
+    inline bool IndexIsValid(int index, size_t size) {
+        return index >= 0 && static_cast<size_t>(index) < size;
+    }
+
+    void VertexWelder::WeldAttributes(SceneData &sceneData) const {
+        bool allTextured = !sceneData.vertex_textures.empty();
+        bool allNormals = !sceneData.vertex_normals.empty();
+
+        for (const WeldKey& key : welded_keys_){
+            if (!IndexIsValid(key.positionIndex, sceneData.vertices.size())){
+                throw runtime_error("Polygon refers to a missing vertex position");
+            }
+            if (key.textureIndex != NO_INDEX && !IndexIsValid(key.textureIndex, sceneData.vertex_textures.size())){
+                throw runtime_error("Polygon refers to a missing texture coordinate");
+            }
+            if (key.normalIndex != NO_INDEX && !IndexIsValid(key.normalIndex, sceneData.vertex_normals.size())){
+                throw runtime_error("Polygon refers to a missing normal");
+            }
+
+            allTextured = allTextured && key.textureIndex != NO_INDEX;
+            allNormals = allNormals && key.normalIndex != NO_INDEX;
+        }
+
+        vector<glm::vec3> vertices, vertexTextures, vertexNormals;
+        vertices.reserve(welded_keys_.size());
+        if (allTextured) vertexTextures.reserve(welded_keys_.size());
+        if (allNormals) vertexNormals.reserve(welded_keys_.size());
+
+        for (const WeldKey& key : welded_keys_){
+            vertices.push_back(sceneData.vertices[key.positionIndex]);
+            if (allTextured) vertexTextures.push_back(sceneData.vertex_textures[key.textureIndex]);
+            if (allNormals) vertexNormals.push_back(sceneData.vertex_normals[key.normalIndex]);
+        }
+
+        sceneData.vertices = std::move(vertices);
+        sceneData.vertex_textures = std::move(vertexTextures);
+        sceneData.vertex_normals = std::move(vertexNormals);
+    }
+
+} // namespace pv
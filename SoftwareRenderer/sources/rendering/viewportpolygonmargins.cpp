@@ -1,4 +0,0 @@
-#include "headers/rendering/viewportpolygonmargins.h"
-
-pv::ViewportPolygonMargins::ViewportPolygonMargins(float minY, float maxY)
-    :minScanlineY(minY), maxScanlineY(maxY) {}
@@ -25,24 +25,20 @@ namespace pv {
                    static_cast<uchar>(componentValue * 255));
     }
 
-    std::vector<ShadedPixel>
-    LambertianShading::GetShadedPixels
+    void
+    LambertianShading::ShadeTriangle
     (
             const ViewportPoint& firstPoint, const ViewportPoint& secondPoint, const ViewportPoint& thirdPoint,
-            const Polygon& polygon,
+            const SourceVertexWeights&,
+            const TriangleRasterizer& triangleRasterizer,
+            size_t polygonIndex,
             const SceneData& sceneData,
             std::array<uchar, 4> materialColor,
             const std::vector<std::shared_ptr<LightSource>>& lightSources,
-            const glm::mat4 &model, const glm::mat4 &view
+            const TransformedVertices& transformedVertices,
+            ShadedPixelSink& pixelSink
     ) const {
 
-        auto shadedPoints =
-                ShadingModel::GetShadedPixels
-                (
-                    firstPoint, secondPoint, thirdPoint,
-                    polygon, sceneData, materialColor, lightSources, model, view
-                );
-
         std::array<uchar, 4> finalShade{255, 0, 0, 0};
         constexpr double MAX_BYTE_VALUE_COLOR = 255.0;
 
@@ -50,7 +46,7 @@ namespace pv {
             float r = 0, g = 0, b = 0;
 
             for (const auto& lightSource : lightSources){
-                auto iShade = GetShadeColor(polygon, sceneData, materialColor, *lightSource, model, view);
+                auto iShade = GetShadeColor(polygonIndex, sceneData, materialColor, *lightSource, transformedVertices);
 
                 r += iShade[1] / MAX_BYTE_VALUE_COLOR;
                 g += iShade[2] / MAX_BYTE_VALUE_COLOR;
@@ -62,101 +58,44 @@ namespace pv {
             finalShade[3] = GetByteColorComponentValue(b);
         }
 
-        for_each(begin(shadedPoints), end(shadedPoints), [&finalShade](ShadedPixel& pixel) { pixel.shadeColor = finalShade; });
-        return shadedPoints;
+        AttributeInterpolation attrInterpolation;
+        attrInterpolation.SetTriangle(firstPoint, secondPoint, thirdPoint);
+
+        ShadeInterpolatedFragments(triangleRasterizer, attrInterpolation, pixelSink,
+                                   [&](const InterpolatedFragment&){
+            return finalShade;
+        });
     }
 
     std::array<uchar, 4>
     LambertianShading::GetShadeColor(
-            const Polygon &polygon,
+            size_t polygonIndex,
             const SceneData &sceneData,
             std::array<uchar, 4> materialColor,
             const LightSource &lightSource,
-            const glm::mat4 &model,
-            const glm::mat4 &view) const
+            const TransformedVertices& transformedVertices) const
     {
-        vector<glm::vec3> vertices = GetPolygonVertices(polygon.vertex_indices, sceneData.vertices);
-        vector<glm::vec3> vertexNormals = GetPolygonVertexNormals(polygon.normal_indices, sceneData.vertex_normals);
+        const int* vertexIndices = sceneData.vertex_indices.data() + sceneData.GetFirstCorner(polygonIndex);
+        const glm::vec3 lightSourcePositionView = transformedVertices.view * glm::vec4(lightSource.GetLightSourcePositionWorld(), 1.0);
 
-        vector<glm::vec4> vertices4; vertices4.reserve(3);
-        for (auto vertex : vertices){
-            vertices4.push_back(glm::vec4{vertex, 1.0});
-        }
+        std::array<std::array<uchar, 4>, 3> shades;
+        for (size_t vertexIdx = 0; vertexIdx < 3; ++vertexIdx){
+            const int vertexIndex = vertexIndices[vertexIdx];
 
-        auto ModelView = view * model;
-        for_each(vertices4.begin(),
-                 vertices4.end(),
-                 [&ModelView](glm::vec4& vertex){
-                        vertex = ModelView * vertex;
-        });
-
-        auto ModelViewNormals = glm::transpose(glm::inverse(GetMatrix3x3(ModelView)));
-        for_each(vertexNormals.begin(),
-                 vertexNormals.end(),
-                 [&ModelViewNormals](glm::vec3& normal){
-                        normal = ModelViewNormals * normal;
-        });
-
-        auto lightSourcePositionView = view * glm::vec4(lightSource.GetLightSourcePositionWorld(), 1.0);
-
-        vector<std::array<uchar, 4>> shades; shades.reserve(3);
-        size_t normalIndex = 0;
-        for (const auto& triangleVertex : vertices4){
-            glm::vec3 lightDirection = lightSourcePositionView - triangleVertex;
+            glm::vec3 lightDirection = lightSourcePositionView - transformedVertices.cameraPositions[vertexIndex];
 
             lightDirection = glm::normalize(lightDirection);
-            glm::vec3 normalVector = glm::normalize(vertexNormals[normalIndex]);
+            glm::vec3 normalVector = glm::normalize(transformedVertices.cameraNormals[vertexIndex]);
 
-            auto shadeAtVertex = GetAverageMaterialLightColor(materialColor, lightSource.GetLightColor()) *
+            shades[vertexIdx] = GetAverageMaterialLightColor(materialColor, lightSource.GetLightColor()) *
                     glm::clamp(glm::dot(lightDirection, normalVector),
                        static_cast<float>(0.0),
                        static_cast<float>(1.0));
-            shades.push_back(shadeAtVertex);
-
-            ++normalIndex;
         }
 
         return GetFinalAverageShade(shades);
     }
 
-    std::vector<glm::vec3>
-    LambertianShading::GetPolygonVertices(
-            const std::vector<int> &vertexIndices,
-            const std::vector<glm::vec3> &vertices) const
-    {
-        vector<glm::vec3> toReturnVertices;
-        toReturnVertices.reserve(3);
-
-        for (int vertexIndex : vertexIndices){
-            toReturnVertices.push_back(vertices[vertexIndex]);
-        }
-
-        return toReturnVertices;
-    }
-
-    std::vector<glm::vec3>
-    LambertianShading::GetPolygonVertexNormals(
-            const std::vector<int> &normalIndices,
-            const std::vector<glm::vec3> &normals) const
-    {
-        vector<glm::vec3> vertexNormals;
-        vertexNormals.reserve(3);
-
-        for (int normalIndex : normalIndices){
-            vertexNormals.push_back(normals[normalIndex]);
-        }
-
-        return vertexNormals;
-    }
-
-    glm::mat3
-    LambertianShading::GetMatrix3x3(const glm::mat4 &modelView) const
-    {
-        return { {modelView[0][0], modelView[0][1], modelView[0][2]},
-                 {modelView[1][0], modelView[1][1], modelView[1][2]},
-            {modelView[2][0], modelView[2][1], modelView[2][2]} };
-    }
-
     std::array<uchar, 4>
     LambertianShading::GetAverageMaterialLightColor(std::array<uchar, 4> materialColor, std::array<uchar, 4> lightColor)
     const
@@ -168,7 +107,7 @@ namespace pv {
     }
 
     std::array<uchar, 4>
-    LambertianShading::GetFinalAverageShade(const std::vector<std::array<uchar, 4> > &shades) const
+    LambertianShading::GetFinalAverageShade(const std::array<std::array<uchar, 4>, 3> &shades) const
     {
         unsigned long long r = 0, g = 0, b = 0;
         for (size_t shadeIdx = 0; shadeIdx < 3; ++shadeIdx){
@@ -1,31 +1,30 @@
 #include "headers/shading/shadingmodel.h"
-#include <algorithm>
 
 using namespace std;
 
 namespace pv {
 
-    std::vector<ShadedPixel>
-    NoShading::GetShadedPixels
+    void
+    NoShading::ShadeTriangle
     (
             const ViewportPoint& firstPoint, const ViewportPoint& secondPoint, const ViewportPoint& thirdPoint,
-            const Polygon& polygon,
-            const SceneData& sceneData,
+            const SourceVertexWeights&,
+            const TriangleRasterizer& triangleRasterizer,
+            size_t,
+            const SceneData&,
             std::array<uchar, 4> materialColor,
-            const std::vector<std::shared_ptr<LightSource>>& lightSources,
-            const glm::mat4 &model, const glm::mat4 &view
+            const std::vector<std::shared_ptr<LightSource>>&,
+            const TransformedVertices&,
+            ShadedPixelSink& pixelSink
     ) const {
 
-        auto shadedPoints =
-                ShadingModel::GetShadedPixels
-                (
-                    firstPoint, secondPoint, thirdPoint,
-                    polygon, sceneData, materialColor, lightSources, model, view
-                );
+        AttributeInterpolation attrInterpolation;
+        attrInterpolation.SetTriangle(firstPoint, secondPoint, thirdPoint);
 
-        for_each(begin(shadedPoints), end(shadedPoints), [&materialColor](ShadedPixel& pixel) { pixel.shadeColor = materialColor; });
-
-        return shadedPoints;
+        ShadeInterpolatedFragments(triangleRasterizer, attrInterpolation, pixelSink,
+                                   [&](const InterpolatedFragment&){
+            return materialColor;
+        });
     }
 
 }
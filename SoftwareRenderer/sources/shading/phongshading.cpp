@@ -22,14 +22,6 @@ namespace pv {
                 static_cast<uchar>((materialColor[3] + lightColor[3]) / 2)};
     }
 
-    inline glm::mat3
-    GetMatrix3x3(const glm::mat4 &modelView)
-    {
-        return { {modelView[0][0], modelView[0][1], modelView[0][2]},
-                 {modelView[1][0], modelView[1][1], modelView[1][2]},
-                 {modelView[2][0], modelView[2][1], modelView[2][2]} };
-    }
-
     inline uchar GetByteColorComponentValue(float componentValue) {
         if (componentValue > 1.0) {
             componentValue = 1.0;
@@ -43,194 +35,167 @@ namespace pv {
                    static_cast<uchar>(componentValue * 255));
     }
 
-    std::vector<ShadedPixel>
-    PhongShading::GetShadedPixels
+    void
+    PhongShading::ShadeTriangle
     (
             const ViewportPoint& firstPoint, const ViewportPoint& secondPoint, const ViewportPoint& thirdPoint,
-            const Polygon& polygon,
+            const SourceVertexWeights& sourceWeights,
+            const TriangleRasterizer& triangleRasterizer,
+            size_t polygonIndex,
             const SceneData& sceneData,
             std::array<uchar, 4> materialColor,
             const std::vector<std::shared_ptr<LightSource>>& lightSources,
-            const glm::mat4 &model, const glm::mat4 &view
+            const TransformedVertices& transformedVertices,
+            ShadedPixelSink& pixelSink
     ) const {
 
-        //=====================================================
-        normal_interpolation_needed_ = true;
-        vector<glm::vec3> vertexNormals = GetPolygonVertexNormals(polygon.normal_indices, sceneData.vertex_normals);
-        normal_vectors_ptr_ = &vertexNormals;
-
-        vector<glm::vec3> interpolatedVertexNormals;
-        interpolated_normal_vectors_ptr_ = &interpolatedVertexNormals;
-        //=====================================================
-
-        //=====================================================
-        camera_space_interpolation_needed_ = true;
-        vector<glm::vec3> cameraSpacePositions = GetPolygonVerticesInCameraSpace(polygon.vertex_indices, sceneData.vertices, model, view);
-        camera_space_pos_ptr_ = &cameraSpacePositions;
-
-        vector<glm::vec3> interpolatedCameraSpacePos;
-        interpolated_camera_space_pos_ptr_ = &interpolatedCameraSpacePos;
-        //=====================================================
-
-        //=====================================================
-        if (diffuse_texturing_enabled_ ||
-            normal_texturing_enabled_  ||
-            specular_texturing_enabled_) { texture_coord_interpolation_needed_ = true; }
-
-        vector<glm::vec3> vertexTexturesCoords = GetPolygonVertexTextureCoords(polygon.texture_indices, sceneData.vertex_textures);
-        texture_coords_ptr_ = &vertexTexturesCoords;
-
-        vector<glm::vec3> interpolatedTextureCoords;
-        interpolated_texture_coords_ptr_ = &interpolatedTextureCoords;
-        //=====================================================
-
-        auto shadedPoints =
-                ShadingModel::GetShadedPixels
-                (
-                    firstPoint, secondPoint, thirdPoint,
-                    polygon, sceneData, materialColor, lightSources, model, view
-                );
-
-        if (lightSources.size() > 0) {
-            size_t shadedPointIdx = 0;
-
-            auto ModelView = view * model;
-            auto ModelViewNormal = glm::transpose(glm::inverse(GetMatrix3x3(ModelView)));
-
-            constexpr double MAX_BYTE_VALUE_COLOR = 255.0;
-
-            for (auto& shadedPoint : shadedPoints) {
-                float r = 0, g = 0, b = 0;
-
-                for (const auto& lightSource : lightSources) {
-                    auto &interpPointView = interpolatedCameraSpacePos[shadedPointIdx];
-                    glm::vec3 normal;
-                    if (normal_texture_ && normal_texturing_enabled_) {
-                        auto &interpTextCoord = interpolatedTextureCoords[shadedPointIdx];
-                        normal = GetTextureNormal(interpTextCoord);
-                    }
-                    else { normal = interpolatedVertexNormals[shadedPointIdx]; }
-
-                    auto lightSourcePositionView = view * glm::vec4(lightSource->GetLightSourcePositionWorld(), 1.0);
-
-                    glm::vec3 lightDirectionView = lightSourcePositionView - glm::vec4(interpPointView, 1.0);
-                    glm::vec3 surfaceNormalView = ModelViewNormal * normal;
-
-                    lightDirectionView = glm::normalize(lightDirectionView);
-                    surfaceNormalView = glm::normalize(surfaceNormalView);
-
-                    glm::vec3 viewDirection = -glm::normalize(interpPointView);
-
-                    auto diffuseShade = GetDiffuseShade(lightSource, lightDirectionView, surfaceNormalView);
-                    {
-                        r += diffuseShade[1] / MAX_BYTE_VALUE_COLOR;
-                        g += diffuseShade[2] / MAX_BYTE_VALUE_COLOR;
-                        b += diffuseShade[3] / MAX_BYTE_VALUE_COLOR;
-                    }
-
-                    float specularShadeCoefficient = 1.0;
-                    if (specular_texture_ && specular_texturing_enabled_) {
-                        auto &interpTextCoord = interpolatedTextureCoords[shadedPointIdx];
-                        specularShadeCoefficient = GetTextureSpecular(interpTextCoord);
-                    }
-                    auto specularShade =
-                            GetSpecularShade(lightSource, lightDirectionView, surfaceNormalView, viewDirection) * specularShadeCoefficient;
-                    {
-                        r += specularShade[1] / MAX_BYTE_VALUE_COLOR;
-                        g += specularShade[2] / MAX_BYTE_VALUE_COLOR;
-                        b += specularShade[3] / MAX_BYTE_VALUE_COLOR;
-                    }
-                }
+        AttributeInterpolation attrInterpolation;
 
-                array<uchar, 4> finalShade;
-                array<uchar, 4> ambientShade;
-                if (diffuse_texture_ && diffuse_texturing_enabled_){
-                    auto &interpTextCoord = interpolatedTextureCoords[shadedPointIdx];
-                    ambientShade = GetTextureAmbientShade(interpTextCoord);
-                } else {
-                    ambientShade = GetAmbientShade(materialColor);
-                }
+        if (lightSources.empty()) {
+            attrInterpolation.SetTriangle(firstPoint, secondPoint, thirdPoint);
 
-                {
-                    r += ambientShade[1] / MAX_BYTE_VALUE_COLOR;
-                    g += ambientShade[2] / MAX_BYTE_VALUE_COLOR;
-                    b += ambientShade[3] / MAX_BYTE_VALUE_COLOR;
-                }
+            const std::array<uchar, 4> blackShade{255, 0, 0, 0};
+            ShadeInterpolatedFragments(triangleRasterizer, attrInterpolation, pixelSink,
+                                       [&](const InterpolatedFragment&){
+                return blackShade;
+            });
+            return;
+        }
 
-                finalShade = {255, GetByteColorComponentValue(r), GetByteColorComponentValue(g), GetByteColorComponentValue(b) };
-                shadedPoint.shadeColor = finalShade;
+        const bool textureCoordInterpolationNeeded = (diffuse_texturing_enabled_ ||
+                                                      normal_texturing_enabled_  ||
+                                                      specular_texturing_enabled_) &&
+                                                     sceneData.HasTextureCoords();
 
-                shadedPointIdx++;
-            }
-
-        } else {
-            std::array<uchar, 4> blackShade{255, 0, 0, 0};
-            for_each(begin(shadedPoints), end(shadedPoints), [&blackShade](ShadedPixel& pixel) { pixel.shadeColor = blackShade; });
+        auto vertexAttributes = GetPolygonVertexAttributes(polygonIndex, sceneData, transformedVertices);
+        if (sourceWeights != UNCLIPPED_SOURCE_WEIGHTS){
+            vertexAttributes = AttributeInterpolation::GetClippedVertexAttributes(vertexAttributes, sourceWeights);
         }
-        return shadedPoints;
-
+        attrInterpolation.SetTriangle(firstPoint, secondPoint, thirdPoint, &vertexAttributes,
+                                      true, true, textureCoordInterpolationNeeded);
+
+        ShadeInterpolatedFragments(triangleRasterizer, attrInterpolation, pixelSink,
+                                   [&](const InterpolatedFragmentSpan& fragmentSpan, ShadeColor* shadeColors){
+            GetFragmentSpanShade(fragmentSpan, materialColor, lightSources,
+                                 transformedVertices.view, transformedVertices.modelViewNormal, shadeColors);
+        });
     }
 
-    std::vector<glm::vec3>
-    PhongShading::GetPolygonVertexNormals
+    void
+    PhongShading::GetFragmentSpanShade
     (
-            const std::vector<int> &normalIndices,
-            const std::vector<glm::vec3> &normals
+            const InterpolatedFragmentSpan& fragmentSpan,
+            std::array<uchar, 4> materialColor,
+            const std::vector<std::shared_ptr<LightSource>>& lightSources,
+            const glm::mat4& view,
+            const glm::mat3& modelViewNormal,
+            ShadeColor* shadeColors
     ) const {
 
-        vector<glm::vec3> vertexNormals;
-        vertexNormals.reserve(3);
+        constexpr double MAX_BYTE_VALUE_COLOR = 255.0;
+        const int fragmentCount = fragmentSpan.count;
+
+        LightingSpan lightingSpan;
+        float specularShadeCoefficients[SPAN_WIDTH];
+        float r[SPAN_WIDTH] = {}, g[SPAN_WIDTH] = {}, b[SPAN_WIDTH] = {};
+
+        // Lanes past fragmentCount repeat the first fragment, so the kernels never see a zero-length vector.
+        for (int lane = 0; lane < SPAN_WIDTH; ++lane){
+            const InterpolatedFragment& fragment = fragmentSpan.fragments[lane < fragmentCount ? lane : 0];
+
+            // Interpolated normals are already in camera space, texture normals are not.
+            glm::vec3 surfaceNormalView;
+            if (normal_texture_ && normal_texturing_enabled_) {
+                surfaceNormalView = modelViewNormal * GetTextureNormal(fragment.textureCoord);
+            }
+            else { surfaceNormalView = fragment.normal; }
+
+            lightingSpan.positionX[lane] = fragment.cameraSpacePosition.x;
+            lightingSpan.positionY[lane] = fragment.cameraSpacePosition.y;
+            lightingSpan.positionZ[lane] = fragment.cameraSpacePosition.z;
+
+            lightingSpan.normalX[lane] = surfaceNormalView.x;
+            lightingSpan.normalY[lane] = surfaceNormalView.y;
+            lightingSpan.normalZ[lane] = surfaceNormalView.z;
 
-        for (int normalIndex : normalIndices){
-            vertexNormals.push_back(normals[normalIndex]);
+            specularShadeCoefficients[lane] = 1.0;
+            if (specular_texture_ && specular_texturing_enabled_ && lane < fragmentCount) {
+                specularShadeCoefficients[lane] = GetTextureSpecular(fragment.textureCoord);
+            }
         }
 
-        return vertexNormals;
+        const SpanKernels& spanKernels = GetSpanKernels();
+        float lambertTerms[SPAN_WIDTH];
+        float reflectionTerms[SPAN_WIDTH];
 
-    }
+        for (const auto& lightSource : lightSources) {
+            const glm::vec4 lightSourcePositionView = view * glm::vec4(lightSource->GetLightSourcePositionWorld(), 1.0);
+            const float lightPosition[3] = { lightSourcePositionView.x, lightSourcePositionView.y, lightSourcePositionView.z };
 
-    std::vector<glm::vec3>
-    PhongShading::GetPolygonVertexTextureCoords
-    (
-            const std::vector<int> &textureIndices,
-            const std::vector<glm::vec3> &vertexTextures
-    ) const
-    {
-        vector<glm::vec3> vertexTextureCoords;
-        vertexTextureCoords.reserve(3);
+            spanKernels.EvaluateLighting(lightingSpan, lightPosition, fragmentCount, lambertTerms, reflectionTerms);
+
+            for (int lane = 0; lane < fragmentCount; ++lane){
+                auto diffuseShade = GetDiffuseShade(lightSource, lambertTerms[lane]);
+                {
+                    r[lane] += diffuseShade[1] / MAX_BYTE_VALUE_COLOR;
+                    g[lane] += diffuseShade[2] / MAX_BYTE_VALUE_COLOR;
+                    b[lane] += diffuseShade[3] / MAX_BYTE_VALUE_COLOR;
+                }
 
-        for (int textureIndex : textureIndices){
-            vertexTextureCoords.push_back(vertexTextures[textureIndex]);
+                auto specularShade = GetSpecularShade(lightSource, reflectionTerms[lane]) * specularShadeCoefficients[lane];
+                {
+                    r[lane] += specularShade[1] / MAX_BYTE_VALUE_COLOR;
+                    g[lane] += specularShade[2] / MAX_BYTE_VALUE_COLOR;
+                    b[lane] += specularShade[3] / MAX_BYTE_VALUE_COLOR;
+                }
+            }
         }
 
-        return vertexTextureCoords;
+        for (int lane = 0; lane < fragmentCount; ++lane){
+            array<uchar, 4> ambientShade;
+            if (diffuse_texture_ && diffuse_texturing_enabled_){
+                ambientShade = GetTextureAmbientShade(fragmentSpan.fragments[lane].textureCoord);
+            } else {
+                ambientShade = GetAmbientShade(materialColor);
+            }
+
+            {
+                r[lane] += ambientShade[1] / MAX_BYTE_VALUE_COLOR;
+                g[lane] += ambientShade[2] / MAX_BYTE_VALUE_COLOR;
+                b[lane] += ambientShade[3] / MAX_BYTE_VALUE_COLOR;
+            }
+
+            shadeColors[lane] = {255, GetByteColorComponentValue(r[lane]), GetByteColorComponentValue(g[lane]), GetByteColorComponentValue(b[lane]) };
+        }
     }
 
-    std::vector<glm::vec3>
-    PhongShading::GetPolygonVerticesInCameraSpace
+    std::array<VertexAttributes, 3>
+    PhongShading::GetPolygonVertexAttributes
     (
-            const std::vector<int> &vertexIndices,
-            const std::vector<glm::vec3> &vertices,
-            const glm::mat4& model,
-            const glm::mat4& view
-    ) const
-    {
-        glm::mat4 MV = view * model;
+            size_t polygonIndex,
+            const SceneData& sceneData,
+            const TransformedVertices& transformedVertices
+    ) const {
+
+        const bool hasTextureCoords = sceneData.HasTextureCoords();
+        const int* vertexIndices = sceneData.vertex_indices.data() + sceneData.GetFirstCorner(polygonIndex);
 
-        vector<glm::vec3> verticesInCameraSpace;
-        verticesInCameraSpace.reserve(3);
+        std::array<VertexAttributes, 3> vertexAttributes{};
+        for (size_t vertexIdx = 0; vertexIdx < 3; ++vertexIdx){
+            auto& attributes = vertexAttributes[vertexIdx];
+            const int vertexIndex = vertexIndices[vertexIdx];
 
-        for (int vertexIndex : vertexIndices){
-            verticesInCameraSpace.push_back(glm::vec3
-                                            (
-                                                MV * glm::vec4(vertices[vertexIndex], 1)
-                                            ));
+            attributes.normal = transformedVertices.cameraNormals[vertexIndex];
+            attributes.cameraSpacePosition = transformedVertices.cameraPositions[vertexIndex];
+            if (hasTextureCoords){
+                attributes.textureCoord = sceneData.vertex_textures[vertexIndex];
+            }
         }
 
-        return verticesInCameraSpace;
+        return vertexAttributes;
     }
 
-    glm::vec3 PhongShading::GetTextureNormal(glm::vec3 &interpTextCoord) const {
+    glm::vec3 PhongShading::GetTextureNormal(const glm::vec3 &interpTextCoord) const {
         float x = interpTextCoord[0]; size_t width = normal_texture_->GetWidth() - 1;
         float y = interpTextCoord[1]; size_t height = normal_texture_->GetHeight() - 1;
 
@@ -242,7 +207,7 @@ namespace pv {
         return texelNormal;
     }
 
-    float PhongShading::GetTextureSpecular(glm::vec3 &interpTextCoord) const {
+    float PhongShading::GetTextureSpecular(const glm::vec3 &interpTextCoord) const {
         float x = interpTextCoord[0]; size_t width = specular_texture_->GetWidth() - 1;
         float y = interpTextCoord[1]; size_t height = specular_texture_->GetHeight() - 1;
 
@@ -258,7 +223,7 @@ namespace pv {
     }
 
     std::array<uchar, 4>
-    PhongShading::GetTextureAmbientShade(glm::vec3& interpTextCoord) const {
+    PhongShading::GetTextureAmbientShade(const glm::vec3& interpTextCoord) const {
         constexpr double AMBIENT_LIGHT_COEFF = 0.95;
 
         float x = interpTextCoord[0]; size_t width = diffuse_texture_->GetWidth() - 1;
@@ -276,17 +241,13 @@ namespace pv {
     PhongShading::GetDiffuseShade
     (
             const std::shared_ptr<LightSource>& lightSource,
-            glm::vec3& lightDirectionView,
-            glm::vec3& surfaceNormalView
+            float lambertTerm
     ) const {
 
         constexpr double DIFFUSE_LIGHT_COEFF = 0.35;
 
         auto diffuseShade =
-                lightSource->GetLightColor() * DIFFUSE_LIGHT_COEFF *
-                glm::clamp(glm::dot(lightDirectionView, surfaceNormalView),
-                   static_cast<float>(0.0),
-                   static_cast<float>(1.0));
+                lightSource->GetLightColor() * DIFFUSE_LIGHT_COEFF * lambertTerm;
 
         return diffuseShade;
     }
@@ -295,25 +256,15 @@ namespace pv {
     PhongShading::GetSpecularShade
     (
             const std::shared_ptr<LightSource>& lightSource,
-            glm::vec3& lightDirectionView,
-            glm::vec3& surfaceNormalView,
-            glm::vec3& viewDirection
+            float reflectionTerm
     )
     const {
 
-        float dotProductLN = glm::dot(lightDirectionView, surfaceNormalView);
-        glm::vec3 reflectanceDirectionView = 2 * dotProductLN * surfaceNormalView - lightDirectionView;
-        reflectanceDirectionView = glm::normalize(reflectanceDirectionView);
-
-        float saturatedDotProductRV = glm::clamp(glm::dot(reflectanceDirectionView, viewDirection),
-                                                 static_cast<float>(0.0),
-                                                 static_cast<float>(1.0));
-
         constexpr double SPECULAR_LIGHT_COEFF = 1.00;
 
         auto specularShade =
                 lightSource->GetLightColor()  * SPECULAR_LIGHT_COEFF *
-                pow(saturatedDotProductRV, lightSource->GetSpecularPower());
+                pow(reflectionTerm, lightSource->GetSpecularPower());
 
         return specularShade;
 
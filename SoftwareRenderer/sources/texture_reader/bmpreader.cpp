@@ -2,7 +2,10 @@
 
 #include <QFile>
 #include <QTextStream>
+#include <cassert>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -18,11 +21,18 @@ namespace pv {
 
     TextureHolder BMPReader::GetTexture(QString path, TEXTURE_COLOR_MODEL textColorModel) const {
         QFile inputFile(path);
-        inputFile.open(QIODevice::ReadOnly);
+        if (!inputFile.open(QIODevice::ReadOnly)){
+            throw runtime_error("Cannot open texture file " + path.toStdString());
+        }
         QTextStream in(&inputFile);
 
         const QByteArray allBytes = inputFile.readAll();
 
+        constexpr size_t BMP_HEADER_SIZE = 54;
+        if (static_cast<size_t>(allBytes.size()) < BMP_HEADER_SIZE){
+            throw runtime_error("Not a BMP file: " + path.toStdString());
+        }
+
         constexpr size_t
                 BITMAP_WIDTH_OFFSET = 18,
                 BITMAP_HEIGHT_OFFSET = 22,
@@ -0,0 +1,114 @@
+#include "headers/threading/framescheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace pv {
+
+    constexpr float MIN_RENDER_SCALE = 0.25F;
+    constexpr float RENDER_SCALE_STEP = 0.125F;
+
+    // Frames measured at a scale before it may change again, so one slow frame
+    // does not trigger a drop and the new scale gets a fair measurement.
+    constexpr size_t FRAMES_BEFORE_RESCALE = 8;
+    constexpr double RENDER_MS_SMOOTHING = 0.25;
+
+    // A larger scale is only taken when it is predicted to leave this much of the
+    // budget unused, to keep the scale from bouncing between two steps.
+    constexpr double SCALE_UP_BUDGET_FRACTION = 0.75;
+
+    constexpr float MAX_ANIMATION_STEP_SECONDS = 0.1F;
+
+    FrameScheduler::FrameScheduler(double targetFps) :
+        target_fps_(targetFps),
+        adaptive_resolution_(true),
+        frame_started_(false),
+        render_scale_(1.0F),
+        smoothed_render_ms_(0.0),
+        frames_at_scale_(0)
+    {
+        SetTargetFps(targetFps);
+    }
+
+    void FrameScheduler::SetTargetFps(double targetFps) {
+        if (!(targetFps > 0.0)) throw runtime_error("Target frame rate must be positive");
+
+        target_fps_ = targetFps;
+        frames_at_scale_ = 0;
+    }
+
+    double FrameScheduler::GetTargetFps() const {
+        return target_fps_;
+    }
+
+    double FrameScheduler::GetFrameBudgetMs() const {
+        return 1000.0 / target_fps_;
+    }
+
+    void FrameScheduler::SetAdaptiveResolution(bool adaptiveResolution) {
+        adaptive_resolution_ = adaptiveResolution;
+        if (!adaptive_resolution_) ChangeRenderScale(1.0F);
+    }
+
+    FrameScheduler::Clock::time_point FrameScheduler::GetNextFrameTime() const {
+        if (!frame_started_) return Clock::time_point();
+
+        const auto framePeriod = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / target_fps_));
+        return last_frame_start_ + framePeriod;
+    }
+
+    float FrameScheduler::BeginFrame(Clock::time_point frameStart) {
+        float elapsedSeconds = 0.0F;
+        if (frame_started_){
+            elapsedSeconds = chrono::duration<float>(frameStart - last_frame_start_).count();
+        }
+
+        frame_started_ = true;
+        last_frame_start_ = frameStart;
+
+        return clamp(elapsedSeconds, 0.0F, MAX_ANIMATION_STEP_SECONDS);
+    }
+
+    void FrameScheduler::EndFrame(double renderMs) {
+        smoothed_render_ms_ = frames_at_scale_ == 0 ? renderMs
+                                                    : smoothed_render_ms_ + (renderMs - smoothed_render_ms_) * RENDER_MS_SMOOTHING;
+        ++frames_at_scale_;
+
+        if (!adaptive_resolution_ || frames_at_scale_ < FRAMES_BEFORE_RESCALE) return;
+
+        const double budgetMs = GetFrameBudgetMs();
+        if (smoothed_render_ms_ > budgetMs && render_scale_ > MIN_RENDER_SCALE){
+            ChangeRenderScale(max(render_scale_ - RENDER_SCALE_STEP, MIN_RENDER_SCALE));
+        } else if (render_scale_ < 1.0F){
+            // Assumes the cost grows with the pixel count, which overestimates it
+            // for geometry bound frames and so errs on the steady side.
+            const float largerScale = min(render_scale_ + RENDER_SCALE_STEP, 1.0F);
+            const double pixelRatio = static_cast<double>(largerScale * largerScale) / (render_scale_ * render_scale_);
+
+            if (smoothed_render_ms_ * pixelRatio < budgetMs * SCALE_UP_BUDGET_FRACTION){
+                ChangeRenderScale(largerScale);
+            }
+        }
+    }
+
+    float FrameScheduler::GetRenderScale() const {
+        return render_scale_;
+    }
+
+    size_t FrameScheduler::GetScaledSize(size_t fullSize) const {
+        if (fullSize == 0) return 0;
+
+        const auto scaledSize = static_cast<size_t>(lround(fullSize * static_cast<double>(render_scale_)));
+        return clamp<size_t>(scaledSize, 1, fullSize);
+    }
+
+    void FrameScheduler::ChangeRenderScale(float renderScale) {
+        if (renderScale == render_scale_) return;
+
+        render_scale_ = renderScale;
+        frames_at_scale_ = 0;
+    }
+
+} // namespace pv
@@ -0,0 +1,201 @@
+#include "headers/threading/renderthread.h"
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace pv {
+
+    RenderThread::RenderThread(const SceneData &sceneData, size_t width, size_t height, FrameReadyCallback frameReady) :
+        pipeline_(sceneData),
+        width_(width),
+        height_(height),
+        frame_ready_(std::move(frameReady)),
+        refinement_pending_(false),
+        frame_requested_(false),
+        continuous_rendering_(false),
+        stopping_(false),
+        target_fps_(frame_scheduler_.GetTargetFps()),
+        adaptive_resolution_(true),
+        frame_pacing_changed_(false),
+        rendered_slot_(0),
+        ready_slot_(1),
+        presented_slot_(2),
+        ready_slot_is_new_(false)
+    {
+        for (FrameSlot& frameSlot : frame_slots_){
+            frameSlot.image.assign(width_ * height_ * 4, 0);
+        }
+
+        render_thread_ = thread(&RenderThread::RenderLoop, this);
+    }
+
+    RenderThread::~RenderThread() {
+        {
+            lock_guard<mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_available_.notify_one();
+
+        render_thread_.join();
+    }
+
+    void RenderThread::Post(Command command) {
+        {
+            lock_guard<mutex> lock(mutex_);
+            pending_commands_.push_back(std::move(command));
+            frame_requested_ = true;
+        }
+        work_available_.notify_one();
+    }
+
+    void RenderThread::RequestFrame() {
+        {
+            lock_guard<mutex> lock(mutex_);
+            frame_requested_ = true;
+        }
+        work_available_.notify_one();
+    }
+
+    void RenderThread::SetContinuousRendering(bool continuousRendering) {
+        {
+            lock_guard<mutex> lock(mutex_);
+            continuous_rendering_ = continuousRendering;
+        }
+        work_available_.notify_one();
+    }
+
+    void RenderThread::SetTargetFps(double targetFps) {
+        if (!(targetFps > 0.0)) throw runtime_error("Target frame rate must be positive");
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            target_fps_ = targetFps;
+            frame_pacing_changed_ = true;
+        }
+        work_available_.notify_one();
+    }
+
+    void RenderThread::SetAdaptiveResolution(bool adaptiveResolution) {
+        {
+            lock_guard<mutex> lock(mutex_);
+            adaptive_resolution_ = adaptiveResolution;
+            frame_pacing_changed_ = true;
+        }
+        work_available_.notify_one();
+    }
+
+    void RenderThread::RunBetweenFrames(const function<void()> &task) {
+        lock_guard<mutex> pipelineLock(pipeline_mutex_);
+        task();
+        pipeline_.UpdateSceneClusters();
+    }
+
+    bool RenderThread::AcquireLatestFrame() {
+        exception_ptr frameException;
+        {
+            lock_guard<mutex> lock(mutex_);
+            swap(frameException, frame_exception_);
+
+            if (!frameException && ready_slot_is_new_){
+                swap(ready_slot_, presented_slot_);
+                ready_slot_is_new_ = false;
+                return true;
+            }
+        }
+
+        if (frameException){
+            rethrow_exception(frameException);
+        }
+        return false;
+    }
+
+    const uchar* RenderThread::GetPresentedImage() const {
+        return frame_slots_[presented_slot_].image.data();
+    }
+
+    size_t RenderThread::GetPresentedWidth() const {
+        return frame_slots_[presented_slot_].width;
+    }
+
+    size_t RenderThread::GetPresentedHeight() const {
+        return frame_slots_[presented_slot_].height;
+    }
+
+    const RenderStats& RenderThread::GetPresentedStats() const {
+        return frame_slots_[presented_slot_].stats;
+    }
+
+    void RenderThread::RenderLoop() {
+        vector<Command> commands;
+
+        while (true){
+            bool refinementFrame = false;
+            {
+                unique_lock<mutex> lock(mutex_);
+                work_available_.wait(lock, [this]{
+                    return stopping_ || frame_requested_ || continuous_rendering_ || refinement_pending_;
+                });
+
+                // Requested frames are paced too, so a burst of input cannot
+                // push the frame rate past the target.
+                work_available_.wait_until(lock, frame_scheduler_.GetNextFrameTime(), [this]{ return stopping_; });
+
+                if (stopping_) return;
+
+                if (frame_pacing_changed_){
+                    frame_scheduler_.SetTargetFps(target_fps_);
+                    frame_scheduler_.SetAdaptiveResolution(adaptive_resolution_);
+                    frame_pacing_changed_ = false;
+                }
+
+                refinementFrame = !frame_requested_ && !continuous_rendering_;
+                commands.swap(pending_commands_);
+                frame_requested_ = false;
+            }
+
+            try {
+                RenderFrame(commands, refinementFrame);
+            } catch (...) {
+                lock_guard<mutex> lock(mutex_);
+                if (!frame_exception_) frame_exception_ = current_exception();
+            }
+            commands.clear();
+
+            if (frame_ready_) frame_ready_();
+        }
+    }
+
+    // Only the render thread changes rendered_slot_, so the frame can be drawn
+    // into it without holding mutex_; the slots only change hands under it.
+    void RenderThread::RenderFrame(vector<Command> &commands, bool refinementFrame) {
+        {
+            lock_guard<mutex> pipelineLock(pipeline_mutex_);
+
+            for (Command& command : commands){
+                command(pipeline_);
+            }
+
+            pipeline_.AdvanceAnimation(frame_scheduler_.BeginFrame(FrameScheduler::Clock::now()));
+
+            FrameSlot& frameSlot = frame_slots_[rendered_slot_];
+            frameSlot.width = refinementFrame ? width_ : frame_scheduler_.GetScaledSize(width_);
+            frameSlot.height = refinementFrame ? height_ : frame_scheduler_.GetScaledSize(height_);
+
+            // The slot holds an older frame than the one the frame buffer drew
+            // last, so its contents cannot be treated as preserved.
+            pipeline_.DoRender(frameSlot.width, frameSlot.height, frameSlot.image.data(), false);
+            frameSlot.stats = pipeline_.GetLastFrameStats();
+
+            // A refinement frame is at full size on purpose; its time says nothing
+            // about whether the scaled frames fit the budget.
+            if (!refinementFrame) frame_scheduler_.EndFrame(frameSlot.stats.frameMs);
+            refinement_pending_ = frameSlot.width != width_ || frameSlot.height != height_;
+        }
+
+        lock_guard<mutex> lock(mutex_);
+        swap(rendered_slot_, ready_slot_);
+        ready_slot_is_new_ = true;
+    }
+
+} // namespace pv
@@ -0,0 +1,118 @@
+#include "headers/threading/threadpool.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace pv {
+
+    ThreadPool::ThreadPool(size_t threadCount) :
+        current_task_(nullptr),
+        task_count_(0),
+        next_task_index_(0),
+        busy_workers_(0),
+        generation_(0),
+        stopping_(false)
+    {
+        const size_t workerCount = max<size_t>(threadCount, 1) - 1;
+
+        workers_.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; ++i){
+            workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            lock_guard<mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_available_.notify_all();
+
+        for (auto& worker : workers_){
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::GetThreadCount() const {
+        return workers_.size() + 1;
+    }
+
+    void ThreadPool::ParallelFor(size_t taskCount, const Task &task) {
+        if (taskCount == 0) return;
+
+        if (workers_.empty() || taskCount == 1){
+            for (size_t taskIndex = 0; taskIndex < taskCount; ++taskIndex){
+                task(taskIndex);
+            }
+            return;
+        }
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            current_task_ = &task;
+            task_count_ = taskCount;
+            next_task_index_.store(0);
+            busy_workers_ = workers_.size();
+            first_exception_ = nullptr;
+            ++generation_;
+        }
+        work_available_.notify_all();
+
+        RunPendingTasks();
+
+        exception_ptr taskException;
+        {
+            unique_lock<mutex> lock(mutex_);
+            work_finished_.wait(lock, [this]{ return busy_workers_ == 0; });
+
+            current_task_ = nullptr;
+            taskException = first_exception_;
+            first_exception_ = nullptr;
+        }
+
+        if (taskException){
+            rethrow_exception(taskException);
+        }
+    }
+
+    void ThreadPool::WorkerLoop() {
+        uint64_t seenGeneration = 0;
+
+        while (true){
+            {
+                unique_lock<mutex> lock(mutex_);
+                work_available_.wait(lock, [this, seenGeneration]{ return stopping_ || generation_ != seenGeneration; });
+
+                if (stopping_) return;
+                seenGeneration = generation_;
+            }
+
+            RunPendingTasks();
+
+            {
+                lock_guard<mutex> lock(mutex_);
+                --busy_workers_;
+                if (busy_workers_ == 0){
+                    work_finished_.notify_one();
+                }
+            }
+        }
+    }
+
+    void ThreadPool::RunPendingTasks() {
+        while (true){
+            const size_t taskIndex = next_task_index_.fetch_add(1);
+            if (taskIndex >= task_count_) return;
+
+            try {
+                (*current_task_)(taskIndex);
+            } catch (...) {
+                lock_guard<mutex> lock(mutex_);
+                if (!first_exception_){
+                    first_exception_ = current_exception();
+                }
+            }
+        }
+    }
+
+} // namespace pv